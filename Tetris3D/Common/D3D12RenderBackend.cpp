@@ -0,0 +1,86 @@
+//***************************************************************************************
+// D3D12RenderBackend.cpp
+//***************************************************************************************
+
+#include "D3D12RenderBackend.h"
+
+D3D12RenderBackend::D3D12RenderBackend(UINT objectCbParameter, UINT instanceSrvParameter, UINT instanceStride,
+	UINT meshConstantsParameter, UINT meshConstantCount)
+	: mObjectCbParameter(objectCbParameter),
+	mInstanceSrvParameter(instanceSrvParameter),
+	mInstanceStride(instanceStride),
+	mMeshConstantsParameter(meshConstantsParameter),
+	mMeshConstantCount(meshConstantCount)
+{
+}
+
+UINT D3D12RenderBackend::AddPipelineState(ID3D12PipelineState* pso)
+{
+	mPipelineStates.push_back(pso);
+	return (UINT)mPipelineStates.size() - 1;
+}
+
+UINT D3D12RenderBackend::AddGeometry(const MeshGeometry* geo)
+{
+	mVertexBufferViews.push_back(geo->VertexBufferView());
+	mIndexBufferViews.push_back(geo->IndexBufferView());
+	return (UINT)mVertexBufferViews.size() - 1;
+}
+
+void D3D12RenderBackend::SetMeshConstantData(UINT mesh, const void* data)
+{
+	size_t first = (size_t)mesh*mMeshConstantCount;
+	if(mMeshConstants.size() < first + mMeshConstantCount)
+		mMeshConstants.resize(first + mMeshConstantCount, 0);
+
+	CopyMemory(&mMeshConstants[first], data, mMeshConstantCount*sizeof(UINT));
+}
+
+void D3D12RenderBackend::Begin(ID3D12GraphicsCommandList* cmdList, D3D12_GPU_VIRTUAL_ADDRESS constantBase,
+	D3D12_GPU_VIRTUAL_ADDRESS instanceBuffer)
+{
+	mCommandList = cmdList;
+	mConstantBase = constantBase;
+	mInstanceBuffer = instanceBuffer;
+}
+
+void D3D12RenderBackend::SetPipelineState(std::uint32_t pso)
+{
+	mCommandList->SetPipelineState(mPipelineStates[pso]);
+}
+
+void D3D12RenderBackend::SetGeometry(std::uint32_t geometry)
+{
+	mCommandList->IASetVertexBuffers(0, 1, &mVertexBufferViews[geometry]);
+	mCommandList->IASetIndexBuffer(&mIndexBufferViews[geometry]);
+}
+
+void D3D12RenderBackend::SetPrimitiveTopology(std::uint32_t topology)
+{
+	mCommandList->IASetPrimitiveTopology((D3D12_PRIMITIVE_TOPOLOGY)topology);
+}
+
+void D3D12RenderBackend::SetMeshConstants(std::uint32_t mesh)
+{
+	assert((size_t)(mesh + 1)*mMeshConstantCount <= mMeshConstants.size());
+	mCommandList->SetGraphicsRoot32BitConstants(mMeshConstantsParameter, mMeshConstantCount,
+		&mMeshConstants[(size_t)mesh*mMeshConstantCount], 0);
+}
+
+void D3D12RenderBackend::SetObjectConstants(std::uint32_t slot)
+{
+	mCommandList->SetGraphicsRootConstantBufferView(mObjectCbParameter,
+		mConstantBase + (UINT64)slot*ConstantSlotSize);
+}
+
+void D3D12RenderBackend::SetInstanceRange(std::uint32_t firstInstance)
+{
+	mCommandList->SetGraphicsRootShaderResourceView(mInstanceSrvParameter,
+		mInstanceBuffer + (UINT64)firstInstance*mInstanceStride);
+}
+
+void D3D12RenderBackend::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+	std::uint32_t startIndexLocation, std::int32_t baseVertexLocation)
+{
+	mCommandList->DrawIndexedInstanced(indexCount, instanceCount, startIndexLocation, baseVertexLocation, 0);
+}
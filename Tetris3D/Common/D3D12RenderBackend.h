@@ -0,0 +1,67 @@
+//***************************************************************************************
+// D3D12RenderBackend.h
+//
+// Replays a RenderCommandStream on a Direct3D 12 command list.  Pipeline states and
+// geometries are registered once and referred to by handle; the vertex and index
+// buffer views are computed at registration instead of for every draw.  Per-mesh
+// root constants (e.g. QuantizationBounds) are stored by mesh handle.  Object constants
+// are bound as root CBVs at the address of their constant buffer chunk.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "RenderCommandStream.h"
+
+class D3D12RenderBackend : public RenderBackend
+{
+public:
+	///<summary>
+	/// objectCbParameter is the root parameter of the per-object root CBV,
+	/// instanceSrvParameter the root parameter of the per-instance root SRV whose
+	/// elements are instanceStride bytes, and meshConstantsParameter the root
+	/// parameter of meshConstantCount 32-bit per-mesh root constants.
+	///</summary>
+	D3D12RenderBackend(UINT objectCbParameter, UINT instanceSrvParameter, UINT instanceStride,
+		UINT meshConstantsParameter, UINT meshConstantCount);
+
+	UINT AddPipelineState(ID3D12PipelineState* pso);
+	UINT AddGeometry(const MeshGeometry* geo);
+
+	// Copies meshConstantCount 32-bit values used when mesh is bound.
+	void SetMeshConstantData(UINT mesh, const void* data);
+
+	///<summary>
+	/// Sets the command list and the per-frame bases used by the following commands.
+	/// Object constant slot n is bound at constantBase + n*ConstantSlotSize.
+	///</summary>
+	void Begin(ID3D12GraphicsCommandList* cmdList, D3D12_GPU_VIRTUAL_ADDRESS constantBase,
+		D3D12_GPU_VIRTUAL_ADDRESS instanceBuffer);
+
+	static const UINT ConstantSlotSize = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+	virtual void SetPipelineState(std::uint32_t pso)override;
+	virtual void SetGeometry(std::uint32_t geometry)override;
+	virtual void SetPrimitiveTopology(std::uint32_t topology)override;
+	virtual void SetMeshConstants(std::uint32_t mesh)override;
+	virtual void SetObjectConstants(std::uint32_t slot)override;
+	virtual void SetInstanceRange(std::uint32_t firstInstance)override;
+	virtual void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+		std::uint32_t startIndexLocation, std::int32_t baseVertexLocation)override;
+
+private:
+	UINT mObjectCbParameter;
+	UINT mInstanceSrvParameter;
+	UINT mInstanceStride;
+	UINT mMeshConstantsParameter;
+	UINT mMeshConstantCount;
+
+	std::vector<ID3D12PipelineState*> mPipelineStates;
+	std::vector<D3D12_VERTEX_BUFFER_VIEW> mVertexBufferViews;
+	std::vector<D3D12_INDEX_BUFFER_VIEW> mIndexBufferViews;
+	std::vector<UINT> mMeshConstants;
+
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS mConstantBase = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS mInstanceBuffer = 0;
+};
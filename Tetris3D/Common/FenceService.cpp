@@ -0,0 +1,45 @@
+//***************************************************************************************
+// FenceService.cpp
+//***************************************************************************************
+
+#include "FenceService.h"
+
+FenceService::FenceService(ID3D12Device* device, ID3D12CommandQueue* queue)
+	: mQueue(queue), mTracker(mFence)
+{
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence.Fence)));
+
+	// Auto-reset, so a wait consumes the signal and the event is ready for the next.
+	mFence.Event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	if(mFence.Event == nullptr)
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+}
+
+UINT64 FenceService::Signal()
+{
+	const UINT64 value = mTracker.NextValue();
+	ThrowIfFailed(mQueue->Signal(mFence.Fence.Get(), value));
+	return value;
+}
+
+void FenceService::Flush()
+{
+	Wait(Signal());
+}
+
+FenceService::GpuFence::~GpuFence()
+{
+	if(Event != nullptr)
+		CloseHandle(Event);
+}
+
+std::uint64_t FenceService::GpuFence::CompletedValue()
+{
+	return Fence->GetCompletedValue();
+}
+
+void FenceService::GpuFence::WaitFor(std::uint64_t value)
+{
+	ThrowIfFailed(Fence->SetEventOnCompletion(value, Event));
+	WaitForSingleObject(Event, INFINITE);
+}
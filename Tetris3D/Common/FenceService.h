@@ -0,0 +1,62 @@
+//***************************************************************************************
+// FenceService.h
+//
+// The fence of a command queue, with one event reused for every wait instead of an
+// event created and closed each time.  Signal marks the commands submitted so far;
+// Wait blocks until they have executed; OnCompleted defers work, such as releasing
+// resources the GPU may still read, until they have.  The scheduling and the blocked
+// time statistics are in FenceTracker.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "FenceTracker.h"
+
+class FenceService
+{
+public:
+	FenceService(ID3D12Device* device, ID3D12CommandQueue* queue);
+	FenceService(const FenceService& rhs) = delete;
+	FenceService& operator=(const FenceService& rhs) = delete;
+
+	// Signals the next fence value on the queue and returns it.
+	UINT64 Signal();
+
+	// Blocks until value is complete, see FenceTracker::Wait.
+	void Wait(UINT64 value) { mTracker.Wait(value); }
+
+	// Signals and waits for everything submitted to the queue so far.
+	void Flush();
+
+	UINT64 LastSignaled()const { return mTracker.LastSignaled(); }
+	UINT64 CompletedValue() { return mTracker.CompletedValue(); }
+
+	void OnCompleted(UINT64 value, FenceTracker::Callback callback) { mTracker.OnCompleted(value, std::move(callback)); }
+	void Poll() { mTracker.Poll(); }
+
+	const FenceTracker::WaitStats& FrameStats()const { return mTracker.FrameStats(); }
+	const FenceTracker::WaitStats& TotalStats()const { return mTracker.TotalStats(); }
+	void ResetFrameStats() { mTracker.ResetFrameStats(); }
+
+	ID3D12Fence* Fence()const { return mFence.Fence.Get(); }
+
+private:
+	struct GpuFence : public FenceTracker::Fence
+	{
+		GpuFence() = default;
+		GpuFence(const GpuFence& rhs) = delete;
+		GpuFence& operator=(const GpuFence& rhs) = delete;
+		~GpuFence();
+
+		std::uint64_t CompletedValue() override;
+		void WaitFor(std::uint64_t value) override;
+
+		Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+		HANDLE Event = nullptr;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mQueue;
+	GpuFence mFence;
+	FenceTracker mTracker;
+};
@@ -0,0 +1,93 @@
+//***************************************************************************************
+// FenceTracker.cpp
+//***************************************************************************************
+
+#include "FenceTracker.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+FenceTracker::FenceTracker(Fence& fence)
+	: mFence(fence)
+{
+}
+
+std::uint64_t FenceTracker::NextValue()
+{
+	return ++mLastSignaled;
+}
+
+std::uint64_t FenceTracker::CompletedValue()
+{
+	mCompleted = (std::max)(mCompleted, mFence.CompletedValue());
+	return mCompleted;
+}
+
+bool FenceTracker::IsComplete(std::uint64_t value)
+{
+	return value <= mCompleted || value <= CompletedValue();
+}
+
+void FenceTracker::Wait(std::uint64_t value)
+{
+	assert(value <= mLastSignaled && "Waiting for a fence value that was never signaled.");
+
+	mFrameStats.Waits++;
+	mTotalStats.Waits++;
+
+	if(!IsComplete(value))
+	{
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point start = Clock::now();
+
+		mFence.WaitFor(value);
+
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		for(WaitStats* stats : { &mFrameStats, &mTotalStats })
+		{
+			stats->BlockedWaits++;
+			stats->BlockedMs += ms;
+			stats->MaxBlockedMs = (std::max)(stats->MaxBlockedMs, ms);
+		}
+
+		CompletedValue();
+		assert(mCompleted >= value);
+	}
+
+	RunCompleted();
+}
+
+void FenceTracker::OnCompleted(std::uint64_t value, Callback callback)
+{
+	mCallbacks.emplace(value, std::move(callback));
+
+	// Due callbacks of lower values, if any, run first.
+	if(IsComplete(value))
+		RunCompleted();
+}
+
+void FenceTracker::Poll()
+{
+	if(!mCallbacks.empty())
+	{
+		CompletedValue();
+		RunCompleted();
+	}
+}
+
+void FenceTracker::ResetFrameStats()
+{
+	mFrameStats = WaitStats();
+}
+
+// Runs the callbacks up to the completed value already read.
+void FenceTracker::RunCompleted()
+{
+	while(!mCallbacks.empty() && mCallbacks.begin()->first <= mCompleted)
+	{
+		// Taken out of the map first: the callback may add callbacks or throw.
+		Callback callback = std::move(mCallbacks.begin()->second);
+		mCallbacks.erase(mCallbacks.begin());
+		callback();
+	}
+}
@@ -0,0 +1,90 @@
+//***************************************************************************************
+// FenceTracker.h
+//
+// Bookkeeping for a monotonically increasing fence: the values handed out for signals,
+// the last value known to be complete, callbacks that run once a value completes (to
+// release resources or reuse memory the GPU was reading), and the time the CPU spends
+// blocked waiting for it.  The fence itself is behind a small interface, implemented
+// over an ID3D12Fence by FenceService, so the scheduling can run against a simulated
+// fence.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+
+class FenceTracker
+{
+public:
+	class Fence
+	{
+	public:
+		virtual ~Fence() = default;
+
+		virtual std::uint64_t CompletedValue() = 0;
+
+		// Blocks until CompletedValue() >= value.
+		virtual void WaitFor(std::uint64_t value) = 0;
+	};
+
+	typedef std::function<void()> Callback;
+
+	struct WaitStats
+	{
+		std::uint32_t Waits = 0;        // Calls to Wait.
+		std::uint32_t BlockedWaits = 0; // Waits that had to block.
+		double BlockedMs = 0.0;
+		double MaxBlockedMs = 0.0;
+	};
+
+	// fence must outlive the tracker and start at a completed value of 0.
+	explicit FenceTracker(Fence& fence);
+	FenceTracker(const FenceTracker& rhs) = delete;
+	FenceTracker& operator=(const FenceTracker& rhs) = delete;
+
+	// Returns the value to signal next, one more than the last one.
+	std::uint64_t NextValue();
+	std::uint64_t LastSignaled()const { return mLastSignaled; }
+
+	// Reads the fence; the result never decreases.
+	std::uint64_t CompletedValue();
+	bool IsComplete(std::uint64_t value);
+
+	///<summary>
+	/// Returns once value (<= LastSignaled) is complete, blocking on the fence only if
+	/// it is not yet, then runs the callbacks that became due.
+	///</summary>
+	void Wait(std::uint64_t value);
+	void WaitIdle() { Wait(mLastSignaled); }
+
+	///<summary>
+	/// Runs callback once value is complete: from Poll or Wait, or right away if
+	/// value already is.  Callbacks run in the order of their values, then of
+	/// registration, and may register further callbacks.
+	///</summary>
+	void OnCompleted(std::uint64_t value, Callback callback);
+
+	// Runs the callbacks whose value is complete.
+	void Poll();
+
+	std::size_t PendingCallbacks()const { return mCallbacks.size(); }
+
+	// Waits since the last ResetFrameStats, and since construction.
+	const WaitStats& FrameStats()const { return mFrameStats; }
+	const WaitStats& TotalStats()const { return mTotalStats; }
+	void ResetFrameStats();
+
+private:
+	void RunCompleted();
+
+	Fence& mFence;
+	std::uint64_t mLastSignaled = 0;
+	std::uint64_t mCompleted = 0;
+
+	std::multimap<std::uint64_t, Callback> mCallbacks;
+
+	WaitStats mFrameStats;
+	WaitStats mTotalStats;
+};
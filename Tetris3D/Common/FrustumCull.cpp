@@ -0,0 +1,174 @@
+//***************************************************************************************
+// FrustumCull.cpp
+//***************************************************************************************
+
+#include "FrustumCull.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define FRUSTUM_CULL_SSE 1
+#include <emmintrin.h>
+#endif
+
+Frustum Frustum::FromViewProj(const float m[16])
+{
+	// clip = p*M, so clip.c = dot(p, column c).  With -w <= x <= w, -w <= y <= w and
+	// 0 <= z <= w each plane is a sum or difference of columns.
+	auto column = [m](int c, float sign, float out[4])
+	{
+		for(int r = 0; r < 4; ++r)
+			out[r] += sign*m[r*4 + c];
+	};
+
+	Frustum f = {};
+	for(int i = 0; i < 6; ++i)
+	{
+		if(i != 4)
+			column(3, 1.0f, f.Planes[i]);
+	}
+	column(0,  1.0f, f.Planes[0]);
+	column(0, -1.0f, f.Planes[1]);
+	column(1,  1.0f, f.Planes[2]);
+	column(1, -1.0f, f.Planes[3]);
+	column(2,  1.0f, f.Planes[4]);
+	column(2, -1.0f, f.Planes[5]);
+
+	for(int i = 0; i < 6; ++i)
+	{
+		float* p = f.Planes[i];
+		float len = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+		if(len > 0.0f)
+		{
+			for(int k = 0; k < 4; ++k)
+				p[k] /= len;
+		}
+	}
+
+	return f;
+}
+
+void CullBoxList::Clear()
+{
+	mCenterX.clear(); mCenterY.clear(); mCenterZ.clear();
+	mExtentX.clear(); mExtentY.clear(); mExtentZ.clear();
+}
+
+void CullBoxList::Reserve(std::size_t count)
+{
+	mCenterX.reserve(count); mCenterY.reserve(count); mCenterZ.reserve(count);
+	mExtentX.reserve(count); mExtentY.reserve(count); mExtentZ.reserve(count);
+}
+
+void CullBoxList::Add(const float center[3], const float extents[3])
+{
+	mCenterX.push_back(center[0]);
+	mCenterY.push_back(center[1]);
+	mCenterZ.push_back(center[2]);
+	mExtentX.push_back(extents[0]);
+	mExtentY.push_back(extents[1]);
+	mExtentZ.push_back(extents[2]);
+}
+
+void CullBoxList::AddTransformed(const float center[3], const float extents[3], const float world[16])
+{
+	// Arvo: the new center is the transformed center and each new extent is the
+	// sum of the old extents scaled by the absolute matrix entries.
+	float c[3], e[3];
+	for(int j = 0; j < 3; ++j)
+	{
+		c[j] = world[12 + j];
+		e[j] = 0.0f;
+		for(int i = 0; i < 3; ++i)
+		{
+			c[j] += center[i]*world[i*4 + j];
+			e[j] += extents[i]*std::fabs(world[i*4 + j]);
+		}
+	}
+
+	Add(c, e);
+}
+
+std::size_t CullBoxList::CullRange(const Frustum& frustum, std::size_t first, std::uint8_t* visible)const
+{
+	std::size_t visibleCount = 0;
+
+	for(std::size_t i = first; i < Count(); ++i)
+	{
+		bool inside = true;
+		for(int p = 0; p < 6 && inside; ++p)
+		{
+			// Summed in the same order as the SSE path so both give the same answer for
+			// boxes that just touch a plane.
+			const float* n = frustum.Planes[p];
+			float d = (n[0]*mCenterX[i] + n[1]*mCenterY[i]) + (n[2]*mCenterZ[i] + n[3]);
+			float r = (std::fabs(n[0])*mExtentX[i] + std::fabs(n[1])*mExtentY[i]) + std::fabs(n[2])*mExtentZ[i];
+			inside = d + r >= 0.0f;
+		}
+
+		visible[i] = inside ? 1 : 0;
+		visibleCount += visible[i];
+	}
+
+	return visibleCount;
+}
+
+std::size_t CullBoxList::CullScalar(const Frustum& frustum, std::uint8_t* visible)const
+{
+	return CullRange(frustum, 0, visible);
+}
+
+std::size_t CullBoxList::Cull(const Frustum& frustum, std::uint8_t* visible)const
+{
+#if FRUSTUM_CULL_SSE
+	const std::size_t count = Count();
+	const std::size_t simdCount = count & ~std::size_t(3);
+
+	// Splat every plane and its absolute normal once.
+	__m128 nx[6], ny[6], nz[6], nd[6], ax[6], ay[6], az[6];
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	for(int p = 0; p < 6; ++p)
+	{
+		nx[p] = _mm_set1_ps(frustum.Planes[p][0]);
+		ny[p] = _mm_set1_ps(frustum.Planes[p][1]);
+		nz[p] = _mm_set1_ps(frustum.Planes[p][2]);
+		nd[p] = _mm_set1_ps(frustum.Planes[p][3]);
+		ax[p] = _mm_and_ps(nx[p], absMask);
+		ay[p] = _mm_and_ps(ny[p], absMask);
+		az[p] = _mm_and_ps(nz[p], absMask);
+	}
+
+	std::size_t visibleCount = 0;
+	const __m128 zero = _mm_setzero_ps();
+
+	for(std::size_t i = 0; i < simdCount; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&mCenterX[i]);
+		__m128 cy = _mm_loadu_ps(&mCenterY[i]);
+		__m128 cz = _mm_loadu_ps(&mCenterZ[i]);
+		__m128 ex = _mm_loadu_ps(&mExtentX[i]);
+		__m128 ey = _mm_loadu_ps(&mExtentY[i]);
+		__m128 ez = _mm_loadu_ps(&mExtentZ[i]);
+
+		// A box is outside when d + r < 0 for any plane.
+		__m128 outside = _mm_setzero_ps();
+		for(int p = 0; p < 6; ++p)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)),
+				_mm_add_ps(_mm_mul_ps(nz[p], cz), nd[p]));
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for(int k = 0; k < 4; ++k)
+		{
+			visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+			visibleCount += visible[i + k];
+		}
+	}
+
+	return visibleCount + CullRange(frustum, simdCount, visible);
+#else
+	return CullRange(frustum, 0, visible);
+#endif
+}
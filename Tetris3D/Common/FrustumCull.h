@@ -0,0 +1,60 @@
+//***************************************************************************************
+// FrustumCull.h
+//
+// Frustum culling of world space axis-aligned boxes.  Boxes are stored as a structure
+// of arrays and tested four at a time with SSE when it is available, one at a time
+// otherwise.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+///<summary>
+/// Six planes (nx, ny, nz, d) with normals pointing inwards; a point p is inside a
+/// plane when dot(n, p) + d >= 0.  Order: left, right, bottom, top, near, far.
+///</summary>
+struct Frustum
+{
+	float Planes[6][4];
+
+	///<summary>
+	/// Extracts the planes of a Direct3D style (z in [0, w]) row-vector view-projection
+	/// matrix stored row-major, e.g. XMFLOAT4X4::m of view*proj.
+	///</summary>
+	static Frustum FromViewProj(const float viewProj[16]);
+};
+
+class CullBoxList
+{
+public:
+	void Clear();
+	void Reserve(std::size_t count);
+
+	void Add(const float center[3], const float extents[3]);
+
+	///<summary>
+	/// Adds the world space box enclosing a local box transformed by world, a row-major
+	/// row-vector affine matrix.
+	///</summary>
+	void AddTransformed(const float center[3], const float extents[3], const float world[16]);
+
+	std::size_t Count()const { return mCenterX.size(); }
+
+	///<summary>
+	/// Sets visible[i] to 1 when box i intersects the frustum and to 0 when it is
+	/// completely outside one of its planes.  Returns the number of visible boxes.
+	///</summary>
+	std::size_t Cull(const Frustum& frustum, std::uint8_t* visible)const;
+
+	// Same test one box at a time; the reference for Cull.
+	std::size_t CullScalar(const Frustum& frustum, std::uint8_t* visible)const;
+
+private:
+	std::size_t CullRange(const Frustum& frustum, std::size_t first, std::uint8_t* visible)const;
+
+	std::vector<float> mCenterX, mCenterY, mCenterZ;
+	std::vector<float> mExtentX, mExtentY, mExtentZ;
+};
@@ -3,12 +3,66 @@
 //***************************************************************************************
 
 #include "GeometryGenerator.h"
+#include "MeshTextParser.h"
 #include <algorithm>
-
-#include <fstream>
+#include <stdexcept>
+#include <thread>
 
 using namespace DirectX;
 
+namespace
+{
+	// Meshes with fewer vertices per thread than this are built on the calling thread.
+	const std::uint64_t MinVerticesPerThread = 32*1024;
+
+	///<summary>
+	/// Splits [0, count) into contiguous ranges and calls work(begin, end) for each,
+	/// one range per thread, the first on the calling thread.  verticesPerItem sizes
+	/// the split so that small meshes stay on one thread.  work must not throw.
+	///</summary>
+	template<typename Work>
+	void ParallelFor(std::uint32_t count, std::uint32_t verticesPerItem, const Work& work)
+	{
+		std::uint64_t threadCount = (std::min)((std::uint64_t)count*verticesPerItem/MinVerticesPerThread, (std::uint64_t)count);
+		if(threadCount > 1)
+			threadCount = (std::min)(threadCount, (std::uint64_t)std::thread::hardware_concurrency());
+		threadCount = (std::max)(threadCount, (std::uint64_t)1);
+
+		std::vector<std::thread> threads;
+		for(std::uint64_t t = 1; t < threadCount; ++t)
+			threads.emplace_back(work, (std::uint32_t)(count*t/threadCount), (std::uint32_t)(count*(t + 1)/threadCount));
+		work(0u, (std::uint32_t)(count/threadCount));
+		for(std::thread& thread : threads)
+			thread.join();
+	}
+
+	///<summary>
+	/// Sines and cosines of i*step for i = 0..count, four at a time with XMVectorSinCos.
+	/// The tables are padded to a multiple of four.
+	///</summary>
+	void SinCosTable(float step, std::uint32_t count, std::vector<float>& sines, std::vector<float>& cosines)
+	{
+		std::uint32_t size = (count + 4) & ~3u;
+		sines.resize(size);
+		cosines.resize(size);
+
+		for(std::uint32_t i = 0; i < size; i += 4)
+		{
+			XMVECTOR angles = XMVectorSet(i*step, (i + 1)*step, (i + 2)*step, (i + 3)*step);
+
+			XMVECTOR s, c;
+			XMVectorSinCos(&s, &c, angles);
+
+			XMFLOAT4 s4, c4;
+			XMStoreFloat4(&s4, s);
+			XMStoreFloat4(&c4, c);
+
+			sines[i] = s4.x; sines[i + 1] = s4.y; sines[i + 2] = s4.z; sines[i + 3] = s4.w;
+			cosines[i] = c4.x; cosines[i + 1] = c4.y; cosines[i + 2] = c4.z; cosines[i + 3] = c4.w;
+		}
+	}
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
     MeshData meshData;
@@ -116,81 +170,90 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
-	meshData.Vertices.push_back( topVertex );
-
-	float phiStep   = XM_PI/stackCount;
-	float thetaStep = 2.0f*XM_PI/sliceCount;
-
-	// Compute vertices for each stack ring (do not count the poles as rings).
-	for(uint32 i = 1; i <= stackCount-1; ++i)
-	{
-		float phi = i*phiStep;
-
-		// Vertices of ring.
-        for(uint32 j = 0; j <= sliceCount; ++j)
-		{
-			float theta = j*thetaStep;
-
-			Vertex v;
-
-			// spherical to cartesian
-			v.Position.x = radius*sinf(phi)*cosf(theta);
-			v.Position.y = radius*cosf(phi);
-			v.Position.z = radius*sinf(phi)*sinf(theta);
-
-			// Partial derivative of P with respect to theta
-			v.TangentU.x = -radius*sinf(phi)*sinf(theta);
-			v.TangentU.y = 0.0f;
-			v.TangentU.z = +radius*sinf(phi)*cosf(theta);
-
-			XMVECTOR T = XMLoadFloat3(&v.TangentU);
-			XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
+	// Do not count the poles as rings.
+	uint32 ringCount = stackCount - 1;
+	uint32 ringVertexCount = sliceCount + 1;
 
-			XMVECTOR p = XMLoadFloat3(&v.Position);
-			XMStoreFloat3(&v.Normal, XMVector3Normalize(p));
+	meshData.Vertices.resize(ringCount*ringVertexCount + 2);
+	meshData.Indices32.resize(6*sliceCount*(stackCount - 1));
 
-			v.TexC.x = theta / XM_2PI;
-			v.TexC.y = phi / XM_PI;
+	meshData.Vertices.front() = topVertex;
+	meshData.Vertices.back() = bottomVertex;
 
-			meshData.Vertices.push_back( v );
-		}
-	}
+	float phiStep   = XM_PI/stackCount;
+	float thetaStep = 2.0f*XM_PI/sliceCount;
 
-	meshData.Vertices.push_back( bottomVertex );
+	// Every ring shares the angles of the slices.
+	std::vector<float> sinPhi, cosPhi, sinTheta, cosTheta;
+	SinCosTable(phiStep, stackCount, sinPhi, cosPhi);
+	SinCosTable(thetaStep, sliceCount, sinTheta, cosTheta);
 
 	//
 	// Compute indices for top stack.  The top stack was written first to the vertex buffer
 	// and connects the top pole to the first ring.
 	//
 
-    for(uint32 i = 1; i <= sliceCount; ++i)
+	uint32* indices = meshData.Indices32.data();
+    for(uint32 i = 1; i <= sliceCount; ++i, indices += 3)
 	{
-		meshData.Indices32.push_back(0);
-		meshData.Indices32.push_back(i+1);
-		meshData.Indices32.push_back(i);
+		indices[0] = 0;
+		indices[1] = i+1;
+		indices[2] = i;
 	}
-	
-	//
-	// Compute indices for inner stacks (not connected to poles).
-	//
 
-	// Offset the indices to the index of the first vertex in the first ring.
-	// This is just skipping the top pole vertex.
-    uint32 baseIndex = 1;
-    uint32 ringVertexCount = sliceCount + 1;
-	for(uint32 i = 0; i < stackCount-2; ++i)
+	// Compute vertices for each stack ring and the indices of the inner stack (not
+	// connected to poles) below it.  Rings are split across threads.
+	ParallelFor(ringCount, ringVertexCount, [&](uint32 begin, uint32 end)
 	{
-		for(uint32 j = 0; j < sliceCount; ++j)
-		{
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
+		// Offset the indices to the index of the first vertex in the first ring.
+		// This is just skipping the top pole vertex.
+		const uint32 baseIndex = 1;
 
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j+1);
+		for(uint32 i = begin; i < end; ++i)
+		{
+			uint32 ring = i + 1;
+			float phi = ring*phiStep;
+
+			// Vertices of ring.
+			Vertex* v = &meshData.Vertices[baseIndex + i*ringVertexCount];
+			for(uint32 j = 0; j <= sliceCount; ++j, ++v)
+			{
+				float theta = j*thetaStep;
+
+				// spherical to cartesian; the position over the radius is the normal.
+				v->Normal.x = sinPhi[ring]*cosTheta[j];
+				v->Normal.y = cosPhi[ring];
+				v->Normal.z = sinPhi[ring]*sinTheta[j];
+
+				v->Position.x = radius*v->Normal.x;
+				v->Position.y = radius*v->Normal.y;
+				v->Position.z = radius*v->Normal.z;
+
+				// Partial derivative of P with respect to theta, normalized.
+				v->TangentU.x = -sinTheta[j];
+				v->TangentU.y = 0.0f;
+				v->TangentU.z = +cosTheta[j];
+
+				v->TexC.x = theta / XM_2PI;
+				v->TexC.y = phi / XM_PI;
+			}
+
+			if(i + 1 == ringCount)
+				continue;
+
+			uint32* k = &meshData.Indices32[3*sliceCount + 6*sliceCount*i];
+			for(uint32 j = 0; j < sliceCount; ++j, k += 6)
+			{
+				k[0] = baseIndex + i*ringVertexCount + j;
+				k[1] = baseIndex + i*ringVertexCount + j+1;
+				k[2] = baseIndex + (i+1)*ringVertexCount + j;
+
+				k[3] = baseIndex + (i+1)*ringVertexCount + j;
+				k[4] = baseIndex + i*ringVertexCount + j+1;
+				k[5] = baseIndex + (i+1)*ringVertexCount + j+1;
+			}
 		}
-	}
+	});
 
 	//
 	// Compute indices for bottom stack.  The bottom stack was written last to the vertex buffer
@@ -201,26 +264,86 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	uint32 southPoleIndex = (uint32)meshData.Vertices.size()-1;
 
 	// Offset the indices to the index of the first vertex in the last ring.
-	baseIndex = southPoleIndex - ringVertexCount;
-	
-	for(uint32 i = 0; i < sliceCount; ++i)
+	uint32 baseIndex = southPoleIndex - ringVertexCount;
+
+	indices = &meshData.Indices32[meshData.Indices32.size() - 3*sliceCount];
+	for(uint32 i = 0; i < sliceCount; ++i, indices += 3)
 	{
-		meshData.Indices32.push_back(southPoleIndex);
-		meshData.Indices32.push_back(baseIndex+i);
-		meshData.Indices32.push_back(baseIndex+i+1);
+		indices[0] = southPoleIndex;
+		indices[1] = baseIndex+i;
+		indices[2] = baseIndex+i+1;
 	}
 
     return meshData;
 }
  
-void GeometryGenerator::Subdivide(MeshData& meshData)
+namespace
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
+	///<summary>
+	/// Maps an undirected edge, the pair of its vertex indices, to the index of the
+	/// vertex at its midpoint.  Open addressing with linear probing over one flat array
+	/// of keys and one of values; sized once for at most maxEdges edges.
+	///</summary>
+	class EdgeMidpointMap
+	{
+	public:
+		explicit EdgeMidpointMap(std::size_t maxEdges)
+		{
+			// Keep the load factor at or below one half.
+			std::size_t capacity = 16;
+			mShift = 60;
+			while(capacity < 2*maxEdges)
+			{
+				capacity *= 2;
+				mShift--;
+			}
+
+			mKeys.assign(capacity, EmptyKey);
+			mValues.resize(capacity);
+		}
 
+		///<summary>
+		/// Returns the midpoint of edge (i0, i1) or (i1, i0) if it is in the map;
+		/// otherwise adds the edge with the given midpoint and returns that.
+		///</summary>
+		std::uint32_t FindOrAdd(std::uint32_t i0, std::uint32_t i1, std::uint32_t midpoint)
+		{
+			std::uint64_t key = i0 < i1 ?
+				((std::uint64_t)i0 << 32) | i1 :
+				((std::uint64_t)i1 << 32) | i0;
+
+			std::size_t mask = mKeys.size() - 1;
+			std::size_t slot = (std::size_t)((key*0x9E3779B97F4A7C15ull) >> mShift);
+			for(;; slot = (slot + 1) & mask)
+			{
+				if(mKeys[slot] == key)
+					return mValues[slot];
+
+				if(mKeys[slot] == EmptyKey)
+				{
+					mKeys[slot] = key;
+					mValues[slot] = midpoint;
+					return midpoint;
+				}
+			}
+		}
 
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
+	private:
+		// No edge joins a vertex to itself, so (~0, ~0) is never a key.
+		static constexpr std::uint64_t EmptyKey = ~0ull;
+
+		std::vector<std::uint64_t> mKeys;
+		std::vector<std::uint32_t> mValues;
+		int mShift;
+	};
+}
+
+void GeometryGenerator::Subdivide(MeshData& meshData)
+{
+	// The corner vertices are kept.  The triangles are replaced, and the midpoint of
+	// an edge is added once and shared by the triangles on both sides of it.
+	std::vector<uint32> inputIndices;
+	inputIndices.swap(meshData.Indices32);
 
 	//       v1
 	//       *
@@ -232,47 +355,51 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
+	uint32 numTris = (uint32)inputIndices.size()/3;
+
+	// Up to 3 edges per triangle; a closed mesh has 3/2.
+	EdgeMidpointMap midpoints((std::size_t)numTris*3);
+	meshData.Vertices.reserve(meshData.Vertices.size() + numTris*3/2);
+	meshData.Indices32.reserve((std::size_t)numTris*12);
+
+	auto midpoint = [&](uint32 i0, uint32 i1)
+	{
+		uint32 next = (uint32)meshData.Vertices.size();
+		uint32 m = midpoints.FindOrAdd(i0, i1, next);
+		if(m == next)
+		{
+			Vertex v = MidPoint(meshData.Vertices[i0], meshData.Vertices[i1]);
+			meshData.Vertices.push_back(v);
+		}
+		return m;
+	};
+
 	for(uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[ inputCopy.Indices32[i*3+0] ];
-		Vertex v1 = inputCopy.Vertices[ inputCopy.Indices32[i*3+1] ];
-		Vertex v2 = inputCopy.Vertices[ inputCopy.Indices32[i*3+2] ];
+		uint32 v0 = inputIndices[i*3+0];
+		uint32 v1 = inputIndices[i*3+1];
+		uint32 v2 = inputIndices[i*3+2];
 
 		//
-		// Generate the midpoints.
+		// Find or generate the midpoints.
 		//
 
-        Vertex m0 = MidPoint(v0, v1);
-        Vertex m1 = MidPoint(v1, v2);
-        Vertex m2 = MidPoint(v0, v2);
+		uint32 m0 = midpoint(v0, v1);
+		uint32 m1 = midpoint(v1, v2);
+		uint32 m2 = midpoint(v0, v2);
 
 		//
 		// Add new geometry.
 		//
 
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
- 
-		meshData.Indices32.push_back(i*6+0);
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+5);
-
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+5);
-
-		meshData.Indices32.push_back(i*6+5);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+2);
-
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+1);
-		meshData.Indices32.push_back(i*6+4);
+		uint32 tris[12] =
+		{
+			v0, m0, m2,
+			m0, m1, m2,
+			m2, m1, v2,
+			m0, v1, m1
+		};
+		meshData.Indices32.insert(meshData.Indices32.end(), &tris[0], &tris[12]);
 	}
 }
 
@@ -396,78 +523,87 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 
 	uint32 ringCount = stackCount+1;
 
-	// Compute vertices for each stack ring starting at the bottom and moving up.
-	for(uint32 i = 0; i < ringCount; ++i)
-	{
-		float y = -0.5f*height + i*stackHeight;
-		float r = bottomRadius + i*radiusStep;
-
-		// vertices of ring
-		float dTheta = 2.0f*XM_PI/sliceCount;
-		for(uint32 j = 0; j <= sliceCount; ++j)
-		{
-			Vertex vertex;
-
-			float c = cosf(j*dTheta);
-			float s = sinf(j*dTheta);
-
-			vertex.Position = XMFLOAT3(r*c, y, r*s);
-
-			vertex.TexC.x = (float)j/sliceCount;
-			vertex.TexC.y = 1.0f - (float)i/stackCount;
-
-			// Cylinder can be parameterized as follows, where we introduce v
-			// parameter that goes in the same direction as the v tex-coord
-			// so that the bitangent goes in the same direction as the v tex-coord.
-			//   Let r0 be the bottom radius and let r1 be the top radius.
-			//   y(v) = h - hv for v in [0,1].
-			//   r(v) = r1 + (r0-r1)v
-			//
-			//   x(t, v) = r(v)*cos(t)
-			//   y(t, v) = h - hv
-			//   z(t, v) = r(v)*sin(t)
-			// 
-			//  dx/dt = -r(v)*sin(t)
-			//  dy/dt = 0
-			//  dz/dt = +r(v)*cos(t)
-			//
-			//  dx/dv = (r0-r1)*cos(t)
-			//  dy/dv = -h
-			//  dz/dv = (r0-r1)*sin(t)
-
-			// This is unit length.
-			vertex.TangentU = XMFLOAT3(-s, 0.0f, c);
-
-			float dr = bottomRadius-topRadius;
-			XMFLOAT3 bitangent(dr*c, -height, dr*s);
-
-			XMVECTOR T = XMLoadFloat3(&vertex.TangentU);
-			XMVECTOR B = XMLoadFloat3(&bitangent);
-			XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-			XMStoreFloat3(&vertex.Normal, N);
-
-			meshData.Vertices.push_back(vertex);
-		}
-	}
-
 	// Add one because we duplicate the first and last vertex per ring
 	// since the texture coordinates are different.
 	uint32 ringVertexCount = sliceCount+1;
 
-	// Compute indices for each stack.
-	for(uint32 i = 0; i < stackCount; ++i)
+	// The caps add a ring and a center vertex each.
+	meshData.Vertices.reserve(ringCount*ringVertexCount + 2*(ringVertexCount + 1));
+	meshData.Indices32.reserve(6*sliceCount*stackCount + 2*3*sliceCount);
+	meshData.Vertices.resize(ringCount*ringVertexCount);
+	meshData.Indices32.resize(6*sliceCount*stackCount);
+
+	// Every ring shares the angles of the slices.
+	float dTheta = 2.0f*XM_PI/sliceCount;
+	std::vector<float> sines, cosines;
+	SinCosTable(dTheta, sliceCount, sines, cosines);
+
+	// Cylinder can be parameterized as follows, where we introduce v
+	// parameter that goes in the same direction as the v tex-coord
+	// so that the bitangent goes in the same direction as the v tex-coord.
+	//   Let r0 be the bottom radius and let r1 be the top radius.
+	//   y(v) = h - hv for v in [0,1].
+	//   r(v) = r1 + (r0-r1)v
+	//
+	//   x(t, v) = r(v)*cos(t)
+	//   y(t, v) = h - hv
+	//   z(t, v) = r(v)*sin(t)
+	// 
+	//  dx/dt = -r(v)*sin(t)
+	//  dy/dt = 0
+	//  dz/dt = +r(v)*cos(t)
+	//
+	//  dx/dv = (r0-r1)*cos(t)
+	//  dy/dv = -h
+	//  dz/dv = (r0-r1)*sin(t)
+	//
+	// The tangent is (-sin(t), 0, cos(t)), which is unit length, and the normal
+	// T x B = (h*cos(t), r0-r1, h*sin(t)) has the same length on every ring.
+	float dr = bottomRadius-topRadius;
+	float normalScale = 1.0f/sqrtf(height*height + dr*dr);
+
+	// Compute vertices for each stack ring starting at the bottom and moving up, and
+	// the indices of the stack above it.  Rings are split across threads.
+	ParallelFor(ringCount, ringVertexCount, [&](uint32 begin, uint32 end)
 	{
-		for(uint32 j = 0; j < sliceCount; ++j)
+		for(uint32 i = begin; i < end; ++i)
 		{
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-			meshData.Indices32.push_back(i*ringVertexCount + j+1);
+			float y = -0.5f*height + i*stackHeight;
+			float r = bottomRadius + i*radiusStep;
+
+			// vertices of ring
+			Vertex* vertex = &meshData.Vertices[i*ringVertexCount];
+			for(uint32 j = 0; j <= sliceCount; ++j, ++vertex)
+			{
+				float c = cosines[j];
+				float s = sines[j];
+
+				vertex->Position = XMFLOAT3(r*c, y, r*s);
+
+				vertex->TexC.x = (float)j/sliceCount;
+				vertex->TexC.y = 1.0f - (float)i/stackCount;
+
+				vertex->TangentU = XMFLOAT3(-s, 0.0f, c);
+				vertex->Normal = XMFLOAT3(height*c*normalScale, dr*normalScale, height*s*normalScale);
+			}
+
+			if(i == stackCount)
+				continue;
+
+			// Indices of the stack between this ring and the next.
+			uint32* k = &meshData.Indices32[6*sliceCount*i];
+			for(uint32 j = 0; j < sliceCount; ++j, k += 6)
+			{
+				k[0] = i*ringVertexCount + j;
+				k[1] = (i+1)*ringVertexCount + j;
+				k[2] = (i+1)*ringVertexCount + j+1;
+
+				k[3] = i*ringVertexCount + j;
+				k[4] = (i+1)*ringVertexCount + j+1;
+				k[5] = i*ringVertexCount + j+1;
+			}
 		}
-	}
+	});
 
 	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
 	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
@@ -482,12 +618,14 @@ void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius,
 
 	float y = 0.5f*height;
 	float dTheta = 2.0f*XM_PI/sliceCount;
+	std::vector<float> sines, cosines;
+	SinCosTable(dTheta, sliceCount, sines, cosines);
 
 	// Duplicate cap ring vertices because the texture coordinates and normals differ.
 	for(uint32 i = 0; i <= sliceCount; ++i)
 	{
-		float x = topRadius*cosf(i*dTheta);
-		float z = topRadius*sinf(i*dTheta);
+		float x = topRadius*cosines[i];
+		float z = topRadius*sines[i];
 
 		// Scale down by the height to try and make top cap texture coord area
 		// proportional to base.
@@ -523,10 +661,12 @@ void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadi
 
 	// vertices of ring
 	float dTheta = 2.0f*XM_PI/sliceCount;
+	std::vector<float> sines, cosines;
+	SinCosTable(dTheta, sliceCount, sines, cosines);
 	for(uint32 i = 0; i <= sliceCount; ++i)
 	{
-		float x = bottomRadius*cosf(i*dTheta);
-		float z = bottomRadius*sinf(i*dTheta);
+		float x = bottomRadius*cosines[i];
+		float z = bottomRadius*sines[i];
 
 		// Scale down by the height to try and make top cap texture coord area
 		// proportional to base.
@@ -558,7 +698,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	uint32 faceCount   = (m-1)*(n-1)*2;
 
 	//
-	// Create the vertices.
+	// Create the vertices and indices.
 	//
 
 	float halfWidth = 0.5f*width;
@@ -571,46 +711,48 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	float dv = 1.0f / (m-1);
 
 	meshData.Vertices.resize(vertexCount);
-	for(uint32 i = 0; i < m; ++i)
-	{
-		float z = halfDepth - i*dz;
-		for(uint32 j = 0; j < n; ++j)
-		{
-			float x = -halfWidth + j*dx;
-
-			meshData.Vertices[i*n+j].Position = XMFLOAT3(x, 0.0f, z);
-			meshData.Vertices[i*n+j].Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			meshData.Vertices[i*n+j].TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
-
-			// Stretch texture over grid.
-			meshData.Vertices[i*n+j].TexC.x = j*du;
-			meshData.Vertices[i*n+j].TexC.y = i*dv;
-		}
-	}
- 
-    //
-	// Create the indices.
-	//
-
 	meshData.Indices32.resize(faceCount*3); // 3 indices per face
 
-	// Iterate over each quad and compute indices.
-	uint32 k = 0;
-	for(uint32 i = 0; i < m-1; ++i)
+	// Rows are split across threads; each writes its vertices and the indices of the
+	// quads below it.
+	ParallelFor(m, n, [&](uint32 begin, uint32 end)
 	{
-		for(uint32 j = 0; j < n-1; ++j)
+		for(uint32 i = begin; i < end; ++i)
 		{
-			meshData.Indices32[k]   = i*n+j;
-			meshData.Indices32[k+1] = i*n+j+1;
-			meshData.Indices32[k+2] = (i+1)*n+j;
-
-			meshData.Indices32[k+3] = (i+1)*n+j;
-			meshData.Indices32[k+4] = i*n+j+1;
-			meshData.Indices32[k+5] = (i+1)*n+j+1;
-
-			k += 6; // next quad
+			float z = halfDepth - i*dz;
+			Vertex* v = &meshData.Vertices[i*n];
+			for(uint32 j = 0; j < n; ++j, ++v)
+			{
+				float x = -halfWidth + j*dx;
+
+				v->Position = XMFLOAT3(x, 0.0f, z);
+				v->Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
+				v->TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+
+				// Stretch texture over grid.
+				v->TexC.x = j*du;
+				v->TexC.y = i*dv;
+			}
+
+			if(i + 1 == m)
+				continue;
+
+			// Iterate over each quad and compute indices.
+			uint32* k = &meshData.Indices32[i*(n-1)*6];
+			for(uint32 j = 0; j < n-1; ++j)
+			{
+				k[0] = i*n+j;
+				k[1] = i*n+j+1;
+				k[2] = (i+1)*n+j;
+
+				k[3] = (i+1)*n+j;
+				k[4] = i*n+j+1;
+				k[5] = (i+1)*n+j+1;
+
+				k += 6; // next quad
+			}
 		}
-	}
+	});
 
     return meshData;
 }
@@ -661,39 +803,30 @@ GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, floa
 typedef unsigned int        UINT;
 GeometryGenerator::MeshData GeometryGenerator::CreateFromFile(std::string filename)
 {
-	MeshData meshData;
+	TextMesh text;
+	std::string error;
+	if (!MeshTextParser::Load("Models/" + filename, text, error))
+		throw std::runtime_error(error);
 
-	std::ifstream fin("Models/" + filename);
-
-	assert(fin);
-
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	meshData.Vertices.resize(vcount);
-	meshData.Indices32.resize(tcount * 3);
-
-	for (UINT i = 0; i < vcount; ++i)
+	MeshData meshData;
+	meshData.Vertices.resize(text.Vertices.size());
+	for (size_t i = 0; i < text.Vertices.size(); ++i)
 	{
-		fin >> meshData.Vertices[i].Position.x >> meshData.Vertices[i].Position.y >> meshData.Vertices[i].Position.z;
-		fin >> meshData.Vertices[i].Normal.x >> meshData.Vertices[i].Normal.y >> meshData.Vertices[i].Normal.z;
+		meshData.Vertices[i].Position = XMFLOAT3(text.Vertices[i].Position);
+		meshData.Vertices[i].Normal = XMFLOAT3(text.Vertices[i].Normal);
 	}
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	for (UINT i = 0; i < tcount; ++i)
-	{
-		fin >> meshData.Indices32[i * 3 + 0] >> meshData.Indices32[i * 3 + 1] >> meshData.Indices32[i * 3 + 2];
-	}
+	meshData.Indices32 = std::move(text.Indices);
+	return meshData;
+}
 
-	fin.close();
+void GeometryGenerator::OptimizeMesh(MeshData& meshData)
+{
+	uint32* indices = meshData.Indices32.data();
+	size_t indexCount = meshData.Indices32.size();
+	size_t vertexCount = meshData.Vertices.size();
 
-	return meshData;
+	MeshOptimize::OptimizeVertexCache(indices, indexCount, vertexCount);
+	std::vector<uint32> remap = MeshOptimize::OptimizeVertexFetch(indices, indexCount, vertexCount);
+	MeshOptimize::RemapVertices(meshData.Vertices, remap);
 }
@@ -18,6 +18,7 @@
 #include <DirectXMath.h>
 #include <vector>
 #include <string>
+#include "MeshOptimize.h"
 
 class GeometryGenerator
 {
@@ -26,6 +27,12 @@ public:
     using uint16 = std::uint16_t;
     using uint32 = std::uint32_t;
 
+	// Version of the generated output.  Bump it whenever a Create function produces
+	// different vertices or indices for the same parameters; it is part of every
+	// MeshCache key and file, so cached meshes of an older version are regenerated.
+	//   2: CreateSphere, CreateCylinder and CreateGrid use shared sine and cosine tables.
+	static const uint32 Version = 2;
+
 	struct Vertex
 	{
 		Vertex(){}
@@ -58,21 +65,25 @@ public:
 	{
 		std::vector<Vertex> Vertices;
         std::vector<uint32> Indices32;
+	};
 
-        std::vector<uint16>& GetIndices16()
-        {
-			if(mIndices16.empty())
-			{
-				mIndices16.resize(Indices32.size());
-				for(size_t i = 0; i < Indices32.size(); ++i)
-					mIndices16[i] = static_cast<uint16>(Indices32[i]);
-			}
-
-			return mIndices16;
-        }
-
-	private:
-		std::vector<uint16> mIndices16;
+	///<summary>
+	/// The vertices and indices of a mesh stored elsewhere: a MeshData, or a file
+	/// mapped by the mesh cache.  The storage must outlive the view.
+	///</summary>
+	struct MeshView
+	{
+		MeshView() = default;
+		MeshView(const MeshData& mesh) :
+			Vertices(mesh.Vertices.data()),
+			VertexCount(mesh.Vertices.size()),
+			Indices32(mesh.Indices32.data()),
+			IndexCount(mesh.Indices32.size()) {}
+
+		const Vertex* Vertices = nullptr;
+		std::size_t VertexCount = 0;
+		const uint32* Indices32 = nullptr;
+		std::size_t IndexCount = 0;
 	};
 
 	///<summary>
@@ -111,8 +122,19 @@ public:
 	///</summary>
     MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
+	///<summary>
+	/// Loads Models/filename in the VertexList/TriangleList text format.  Throws
+	/// std::runtime_error naming the file and line of malformed text.  Models drawn
+	/// by the app are loaded baked instead (see MeshBake.h).
+	///</summary>
 	MeshData CreateFromFile(std::string filename);
 
+	///<summary>
+	/// Reorders the triangles for the post-transform vertex cache, then the vertices in
+	/// the order the triangles use them.
+	///</summary>
+	void OptimizeMesh(MeshData& meshData);
+
 private:
 	void Subdivide(MeshData& meshData);
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
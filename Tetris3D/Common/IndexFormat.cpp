@@ -0,0 +1,86 @@
+//***************************************************************************************
+// IndexFormat.cpp
+//***************************************************************************************
+
+#include "IndexFormat.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define INDEX_FORMAT_SSE 1
+#include <emmintrin.h>
+#endif
+
+std::uint32_t IndexFormat::MaxIndex(const std::uint32_t* indices, std::size_t count)
+{
+	std::size_t i = 0;
+	std::uint32_t result = 0;
+
+#if INDEX_FORMAT_SSE
+	// SSE2 has no unsigned 32-bit max: flipping the sign bit maps unsigned order to
+	// signed order, where compare and select give the max.  Two accumulators hide
+	// the latency of the select.
+	const __m128i bias = _mm_set1_epi32((int)0x80000000);
+	__m128i max0 = bias;
+	__m128i max1 = bias;
+
+	auto maxOf = [](__m128i a, __m128i b)
+	{
+		__m128i greater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+	};
+
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i a = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)), bias);
+		__m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4)), bias);
+		max0 = maxOf(a, max0);
+		max1 = maxOf(b, max1);
+	}
+
+	max0 = maxOf(max0, max1);
+	max0 = maxOf(max0, _mm_shuffle_epi32(max0, _MM_SHUFFLE(1, 0, 3, 2)));
+	max0 = maxOf(max0, _mm_shuffle_epi32(max0, _MM_SHUFFLE(2, 3, 0, 1)));
+	result = (std::uint32_t)_mm_cvtsi128_si32(max0) ^ 0x80000000u;
+#endif
+
+	for(; i < count; ++i)
+		result = (std::max)(result, indices[i]);
+
+	return result;
+}
+
+void IndexFormat::Write(const std::uint32_t* indices, std::size_t count, std::uint32_t indexSize, void* destination)
+{
+	assert(indexSize == 2 || indexSize == 4);
+
+	if(indexSize == 4)
+	{
+		std::memcpy(destination, indices, count*sizeof(std::uint32_t));
+		return;
+	}
+
+	assert(MaxIndex(indices, count) <= 0xffff && "Indices do not fit 16 bits.");
+
+	std::uint16_t* out = static_cast<std::uint16_t*>(destination);
+	std::size_t i = 0;
+
+#if INDEX_FORMAT_SSE
+	// SSE2 only packs with signed saturation: shift [0, 65535] to [-32768, 32767],
+	// pack, and shift back.
+	const __m128i offset32 = _mm_set1_epi32(0x8000);
+	const __m128i offset16 = _mm_set1_epi16((short)0x8000);
+
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i a = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)), offset32);
+		__m128i b = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4)), offset32);
+		__m128i packed = _mm_add_epi16(_mm_packs_epi32(a, b), offset16);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+	}
+#endif
+
+	for(; i < count; ++i)
+		out[i] = static_cast<std::uint16_t>(indices[i]);
+}
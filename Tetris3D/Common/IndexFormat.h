@@ -0,0 +1,32 @@
+//***************************************************************************************
+// IndexFormat.h
+//
+// Chooses between 16- and 32-bit triangle list indices from the largest index, found
+// with an SSE reduction when it is available, and writes 32-bit indices in the chosen
+// format into a caller's buffer.  Nothing is truncated: a list whose largest index
+// does not fit 16 bits is written with 32.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace IndexFormat
+{
+	// Largest index of the list; 0 for an empty one.
+	std::uint32_t MaxIndex(const std::uint32_t* indices, std::size_t count);
+
+	// Bytes per index (2 or 4) of the smallest format that holds maxIndex.
+	inline std::uint32_t SizeFor(std::uint32_t maxIndex)
+	{
+		return maxIndex <= 0xffff ? 2u : 4u;
+	}
+
+	///<summary>
+	/// Writes count indices at destination with indexSize (2 or 4) bytes each.
+	/// indexSize must hold every index, e.g. SizeFor(MaxIndex(...)).  destination
+	/// may be write-combined memory; it is only written.
+	///</summary>
+	void Write(const std::uint32_t* indices, std::size_t count, std::uint32_t indexSize, void* destination);
+}
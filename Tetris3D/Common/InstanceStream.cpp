@@ -0,0 +1,106 @@
+//***************************************************************************************
+// InstanceStream.cpp
+//***************************************************************************************
+
+#include "InstanceStream.h"
+#include "TransformBatch.h"
+#include <algorithm>
+#include <cassert>
+
+void InstanceStreamBuilder::Reset()
+{
+	mEntries.clear();
+	mWorlds.clear();
+	mPending.clear();
+	mInstances.clear();
+	mBatches.clear();
+}
+
+void InstanceStreamBuilder::Reserve(std::size_t instanceCount)
+{
+	mEntries.reserve(instanceCount);
+	mWorlds.reserve(instanceCount*16);
+	mPending.reserve(instanceCount);
+	mInstances.reserve(instanceCount);
+}
+
+void InstanceStreamBuilder::Add(std::uint32_t pipelineState, std::uint32_t mesh, std::uint32_t materialIndex,
+	const float world[16], std::uint32_t color)
+{
+	assert(pipelineState <= MaxHandle && mesh <= MaxHandle);
+
+	// The columns of the matrix are stored by Build, for all instances at once.
+	mWorlds.insert(mWorlds.end(), world, world + 16);
+
+	InstanceData inst;
+	inst.Color = color;
+	inst.MaterialIndex = materialIndex;
+
+	Entry e;
+	e.Key = (static_cast<std::uint64_t>(pipelineState) << 48) | (static_cast<std::uint64_t>(mesh) << 32) | materialIndex;
+	e.Source = static_cast<std::uint32_t>(mPending.size());
+
+	mEntries.push_back(e);
+	mPending.push_back(inst);
+}
+
+void InstanceStreamBuilder::Build()
+{
+	// Store the columns of the affine part of the matrices.
+	if(!mPending.empty())
+	{
+		TransformBatch::MultiplyTranspose(mWorlds.data(), 16*sizeof(float), mPending.size(), nullptr,
+			3, &mPending[0].World[0][0], sizeof(InstanceData));
+	}
+
+	// Sort by key; ties keep their Add order so the stream is deterministic.
+	std::sort(mEntries.begin(), mEntries.end(), [](const Entry& a, const Entry& b)
+	{
+		return a.Key != b.Key ? a.Key < b.Key : a.Source < b.Source;
+	});
+
+	mInstances.resize(mEntries.size());
+	mBatches.clear();
+
+	for(std::size_t i = 0; i < mEntries.size(); ++i)
+	{
+		const Entry& e = mEntries[i];
+		const std::uint32_t pipelineState = static_cast<std::uint32_t>(e.Key >> 48);
+		const std::uint32_t mesh = static_cast<std::uint32_t>(e.Key >> 32) & MaxHandle;
+
+		if(mBatches.empty() || mBatches.back().PipelineState != pipelineState || mBatches.back().Mesh != mesh)
+		{
+			Batch batch;
+			batch.PipelineState = pipelineState;
+			batch.Mesh = mesh;
+			batch.StartInstance = static_cast<std::uint32_t>(i);
+			batch.FirstSource = e.Source;
+			mBatches.push_back(batch);
+		}
+
+		Batch& batch = mBatches.back();
+		batch.InstanceCount++;
+		batch.FirstSource = std::min(batch.FirstSource, e.Source);
+
+		mInstances[i] = mPending[e.Source];
+	}
+}
+
+std::size_t InstanceStreamBuilder::CapacityFor(std::size_t instanceCount, std::size_t capacity)
+{
+	if(capacity > 0 && instanceCount <= capacity)
+		return capacity;
+
+	return (std::max)(2*instanceCount, MinCapacity);
+}
+
+std::uint32_t InstanceStreamBuilder::PackColor(float r, float g, float b, float a)
+{
+	auto toByte = [](float x) -> std::uint32_t
+	{
+		x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+		return static_cast<std::uint32_t>(x*255.0f + 0.5f);
+	};
+
+	return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (toByte(a) << 24);
+}
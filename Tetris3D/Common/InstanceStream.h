@@ -0,0 +1,94 @@
+//***************************************************************************************
+// InstanceStream.h
+//
+// Builds the per-instance data stream on the CPU.  Instances are added in any order,
+// then grouped by batch (one batch per pipeline state and mesh) and ordered by material
+// inside each batch, so each batch is a contiguous range that can be drawn with one
+// DrawIndexedInstanced.
+//
+// This file has no Direct3D dependencies so it can be compiled and tested on any
+// platform.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Per-instance data read by the vertex shader through a StructuredBuffer.
+// World holds the three columns of the row-vector affine world matrix (the
+// transposed upper 4x3 block), so the shader computes posW.x = dot(float4(posL, 1), World[0]).
+struct InstanceData
+{
+	float World[3][4];
+	std::uint32_t Color;         // R8G8B8A8_UNORM, red in the low byte.
+	std::uint32_t MaterialIndex; // Index into the material buffer.
+};
+
+static_assert(sizeof(InstanceData) == 56, "InstanceData must match the HLSL structured buffer layout.");
+
+class InstanceStreamBuilder
+{
+public:
+	// Pipeline states and meshes are 16-bit handles.
+	static const std::uint32_t MaxHandle = 0xffff;
+
+	// The smallest instance buffer CapacityFor returns.
+	static const std::size_t MinCapacity = 256;
+
+	struct Batch
+	{
+		std::uint32_t PipelineState = 0;
+		std::uint32_t Mesh = 0;
+		std::uint32_t StartInstance = 0;
+		std::uint32_t InstanceCount = 0;
+
+		// Index (in Add order) of the first instance added to this batch.  Callers use
+		// it to look up the draw arguments shared by every instance of the batch.
+		std::uint32_t FirstSource = 0;
+	};
+
+	void Reset();
+	void Reserve(std::size_t instanceCount);
+
+	///<summary>
+	/// Queues one instance.  world is a row-major 4x4 matrix using the row-vector
+	/// convention (translation in the last row), e.g. XMFLOAT4X4::m.
+	///</summary>
+	void Add(std::uint32_t pipelineState, std::uint32_t mesh, std::uint32_t materialIndex,
+		const float world[16], std::uint32_t color);
+
+	///<summary>
+	/// Sorts the queued instances by (pipeline state, mesh, material) into one
+	/// contiguous stream and computes the batch ranges.
+	///</summary>
+	void Build();
+
+	const std::vector<InstanceData>& Instances()const { return mInstances; }
+	const std::vector<Batch>& Batches()const { return mBatches; }
+	std::size_t InstanceCount()const { return mInstances.size(); }
+
+	///<summary>
+	/// Capacity of an instance buffer for instanceCount instances: capacity while
+	/// they fit in a buffer of that capacity, otherwise twice the count (at least
+	/// MinCapacity), so a growing stream reallocates rarely.
+	///</summary>
+	static std::size_t CapacityFor(std::size_t instanceCount, std::size_t capacity);
+
+	// Packs a color with components in [0, 1] to R8G8B8A8_UNORM.
+	static std::uint32_t PackColor(float r, float g, float b, float a);
+
+private:
+	struct Entry
+	{
+		std::uint64_t Key;
+		std::uint32_t Source;
+	};
+
+	std::vector<Entry> mEntries;
+	std::vector<float> mWorlds;
+	std::vector<InstanceData> mPending;
+	std::vector<InstanceData> mInstances;
+	std::vector<Batch> mBatches;
+};
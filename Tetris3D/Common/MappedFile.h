@@ -0,0 +1,40 @@
+//***************************************************************************************
+// MappedFile.h
+//
+// Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap
+// elsewhere).  The view starts on a page boundary and stays valid until the
+// MappedFile is closed or destroyed.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	~MappedFile();
+
+	// Returns false if the file cannot be opened or mapped.  An empty file maps to
+	// a null view of size 0.
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen()const { return mOpen; }
+	const unsigned char* Data()const { return mData; }
+	std::size_t Size()const { return mSize; }
+
+private:
+	const unsigned char* mData = nullptr;
+	std::size_t mSize = 0;
+	bool mOpen = false;
+
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#endif
+};
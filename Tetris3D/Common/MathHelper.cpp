@@ -33,6 +33,39 @@ float MathHelper::AngleFromXY(float x, float y)
 	return theta;
 }
 
+XMMATRIX MathHelper::InverseRigid(CXMMATRIX M)
+{
+	// M = [R 0; t 1] with orthonormal R, so inverse(M) = [R^T 0; -t*R^T 1].
+	XMMATRIX R = M;
+	R.r[3] = g_XMIdentityR3;
+	R = XMMatrixTranspose(R);
+
+	XMVECTOR t = XMVector3TransformNormal(M.r[3], R);
+	R.r[3] = XMVectorSetW(XMVectorNegate(t), 1.0f);
+	return R;
+}
+
+XMMATRIX MathHelper::InversePerspective(CXMMATRIX P)
+{
+	// P = [a 0 0 0; 0 b 0 0; e f c 1; 0 0 d 0], where e and f are zero unless the
+	// frustum is off center.
+	XMFLOAT4X4 p;
+	XMStoreFloat4x4(&p, P);
+
+	float a = p._11;
+	float b = p._22;
+	float c = p._33;
+	float d = p._43;
+	float e = p._31;
+	float f = p._32;
+
+	return XMMATRIX(
+		1.0f/a, 0.0f,   0.0f, 0.0f,
+		0.0f,   1.0f/b, 0.0f, 0.0f,
+		0.0f,   0.0f,   0.0f, 1.0f/d,
+		-e/a,   -f/b,   1.0f, -c/d);
+}
+
 XMVECTOR MathHelper::RandUnitVec3()
 {
 	XMVECTOR One  = XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f);
@@ -6,9 +6,12 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <DirectXMath.h>
 #include <cstdint>
+#include <cstdlib>
 
 class MathHelper
 {
@@ -78,6 +81,15 @@ public:
         return DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(&det, A));
 	}
 
+	// Inverse of a rigid transform (rotation and translation only), such as a view
+	// matrix, without the general inverse: the rotation is transposed and the
+	// translation rotated back.
+	static DirectX::XMMATRIX InverseRigid(DirectX::CXMMATRIX M);
+
+	// Closed-form inverse of a perspective projection built by XMMatrixPerspectiveFovLH
+	// or XMMatrixPerspectiveOffCenterLH.
+	static DirectX::XMMATRIX InversePerspective(DirectX::CXMMATRIX P);
+
     static DirectX::XMFLOAT4X4 Identity4x4()
     {
         static DirectX::XMFLOAT4X4 I(
@@ -0,0 +1,51 @@
+//***************************************************************************************
+// MemoryReport.cpp
+//***************************************************************************************
+
+#include "MemoryReport.h"
+#include <algorithm>
+
+void MemoryReport::Add(const std::string& name, std::uint64_t bytes)
+{
+	auto it = std::find_if(mCategories.begin(), mCategories.end(),
+		[&name](const Category& c) { return c.Name == name; });
+
+	if(it == mCategories.end())
+	{
+		Category category;
+		category.Name = name;
+		category.Bytes = bytes;
+		mCategories.push_back(category);
+	}
+	else
+	{
+		it->Bytes += bytes;
+	}
+}
+
+std::uint64_t MemoryReport::Bytes(const std::string& name)const
+{
+	for(const Category& c : mCategories)
+	{
+		if(c.Name == name)
+			return c.Bytes;
+	}
+	return 0;
+}
+
+std::uint64_t MemoryReport::Total()const
+{
+	std::uint64_t total = 0;
+	for(const Category& c : mCategories)
+		total += c.Bytes;
+	return total;
+}
+
+std::string MemoryReport::Text()const
+{
+	std::string text;
+	for(const Category& c : mCategories)
+		text += "   " + c.Name + ": " + std::to_string((c.Bytes + 1023)/1024) + " KB\n";
+	text += "   total: " + std::to_string((Total() + 1023)/1024) + " KB\n";
+	return text;
+}
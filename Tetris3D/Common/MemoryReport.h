@@ -0,0 +1,37 @@
+//***************************************************************************************
+// MemoryReport.h
+//
+// Sums the memory held by the app under named categories, such as geometry buffers,
+// staging heaps or descriptor heaps, and formats it for the debug output.  Categories
+// are listed in the order they were first added.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MemoryReport
+{
+public:
+	struct Category
+	{
+		std::string Name;
+		std::uint64_t Bytes = 0;
+	};
+
+	// Adds bytes to the category name, creating it if needed.
+	void Add(const std::string& name, std::uint64_t bytes);
+
+	std::uint64_t Bytes(const std::string& name)const;
+	std::uint64_t Total()const;
+
+	const std::vector<Category>& Categories()const { return mCategories; }
+
+	// One line per category with its size in KB, followed by the total.
+	std::string Text()const;
+
+private:
+	std::vector<Category> mCategories;
+};
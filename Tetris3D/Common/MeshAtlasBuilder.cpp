@@ -0,0 +1,200 @@
+//***************************************************************************************
+// MeshAtlasBuilder.cpp
+//***************************************************************************************
+
+#include "MeshAtlasBuilder.h"
+#include "IndexFormat.h"
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+using namespace DirectX;
+
+std::size_t MeshAtlasBuilder::Mesh::VertexCount()const
+{
+	return File == nullptr ? Data.VertexCount : File->Header().VertexCount;
+}
+
+const std::uint32_t* MeshAtlasBuilder::Mesh::Indices()const
+{
+	return File == nullptr ? Data.Indices32 : File->Indices() + File->Lods()[0].StartIndex;
+}
+
+std::size_t MeshAtlasBuilder::Mesh::IndexCount()const
+{
+	return File == nullptr ? Data.IndexCount : File->Lods()[0].IndexCount;
+}
+
+UINT MeshAtlasBuilder::AddMesh(const std::string& name, const GeometryGenerator::MeshView& mesh)
+{
+	Mesh entry;
+	entry.Name = name;
+	entry.Data = mesh;
+	mMeshes.push_back(entry);
+
+	return (UINT)mMeshes.size() - 1;
+}
+
+UINT MeshAtlasBuilder::AddMesh(const std::string& name, const MeshFile& file)
+{
+	assert(file.IsOpen());
+
+	Mesh entry;
+	entry.Name = name;
+	entry.File = &file;
+	mMeshes.push_back(entry);
+
+	return (UINT)mMeshes.size() - 1;
+}
+
+void MeshAtlasBuilder::AddIndices(const std::string& name, UINT mesh, const std::uint32_t* indices, std::size_t count)
+{
+	assert(mesh < mMeshes.size());
+
+	IndexList entry;
+	entry.Name = name;
+	entry.Mesh = mesh;
+	entry.Indices = indices;
+	entry.Count = count;
+	mIndexLists.push_back(entry);
+}
+
+std::unique_ptr<MeshGeometry> MeshAtlasBuilder::Build(ID3D12Device* device, StagingUploader& staging,
+	const std::string& name, UINT vertexStride, const VertexWriter& writeVertices,
+	bool keepCpuCopy)const
+{
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = name;
+
+	//
+	// Lay out the vertices and indices.  Indices are relative to the base vertex of
+	// their mesh, so 16 bits are enough unless one of the lists indexes past 65535.
+	//
+
+	std::vector<SubmeshGeometry> submeshes(mMeshes.size());
+	UINT vertexCount = 0;
+	UINT indexCount = 0;
+	std::uint32_t maxIndex = 0;
+
+	for(std::size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		const Mesh& mesh = mMeshes[i];
+		SubmeshGeometry& submesh = submeshes[i];
+
+		submesh.IndexCount = (UINT)mesh.IndexCount();
+		submesh.StartIndexLocation = indexCount;
+		submesh.BaseVertexLocation = (INT)vertexCount;
+
+		// The bounds are used for culling and as the vertex quantization range; baked
+		// meshes were quantized to the bounds in their header.
+		if(mesh.File != nullptr)
+		{
+			const MeshFileHeader& header = mesh.File->Header();
+			submesh.Bounds = BoundingBox(XMFLOAT3(header.BoundsCenter), XMFLOAT3(header.BoundsExtents));
+		}
+		else if(mesh.Data.VertexCount > 0)
+		{
+			BoundingBox::CreateFromPoints(submesh.Bounds, mesh.Data.VertexCount,
+				&mesh.Data.Vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+		}
+
+		vertexCount += (UINT)mesh.VertexCount();
+		indexCount += submesh.IndexCount;
+		maxIndex = (std::max)(maxIndex, IndexFormat::MaxIndex(mesh.Indices(), mesh.IndexCount()));
+
+		geo->DrawArgs[mesh.Name] = submesh;
+	}
+
+	for(const IndexList& list : mIndexLists)
+	{
+		SubmeshGeometry submesh = submeshes[list.Mesh];
+		submesh.IndexCount = (UINT)list.Count;
+		submesh.StartIndexLocation = indexCount;
+		indexCount += submesh.IndexCount;
+		maxIndex = (std::max)(maxIndex, IndexFormat::MaxIndex(list.Indices, list.Count));
+
+		geo->DrawArgs[list.Name] = submesh;
+	}
+
+	const UINT indexSize = IndexFormat::SizeFor(maxIndex);
+
+	geo->VertexByteStride = vertexStride;
+	geo->VertexBufferByteSize = vertexCount*vertexStride;
+	geo->IndexFormat = indexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	geo->IndexBufferByteSize = indexCount*indexSize;
+
+	//
+	// Create the buffers.
+	//
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(geo->VertexBufferByteSize),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(geo->VertexBufferGPU.GetAddressOf())));
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(geo->IndexBufferByteSize),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(geo->IndexBufferGPU.GetAddressOf())));
+
+	//
+	// Write every mesh straight into the staging memory of the buffers, or into the
+	// CPU copies when they are kept, and stage those afterwards.
+	//
+
+	BYTE* vertexData = nullptr;
+	BYTE* indexData = nullptr;
+	if(keepCpuCopy)
+	{
+		ThrowIfFailed(D3DCreateBlob(geo->VertexBufferByteSize, geo->VertexBufferCPU.GetAddressOf()));
+		ThrowIfFailed(D3DCreateBlob(geo->IndexBufferByteSize, geo->IndexBufferCPU.GetAddressOf()));
+		vertexData = static_cast<BYTE*>(geo->VertexBufferCPU->GetBufferPointer());
+		indexData = static_cast<BYTE*>(geo->IndexBufferCPU->GetBufferPointer());
+	}
+	else
+	{
+		vertexData = staging.Stage(geo->VertexBufferGPU.Get(), 0, geo->VertexBufferByteSize,
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_GENERIC_READ);
+		indexData = staging.Stage(geo->IndexBufferGPU.Get(), 0, geo->IndexBufferByteSize,
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_GENERIC_READ);
+	}
+
+	for(std::size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		const Mesh& mesh = mMeshes[i];
+		BYTE* destination = vertexData + (UINT64)submeshes[i].BaseVertexLocation*vertexStride;
+		if(mesh.File != nullptr)
+		{
+			assert(vertexStride == mesh.File->Header().VertexStride);
+			std::memcpy(destination, mesh.File->Vertices(), mesh.VertexCount()*vertexStride);
+		}
+		else
+			writeVertices(mesh.Data, submeshes[i], destination);
+	}
+
+	BYTE* indexCursor = indexData;
+	auto writeIndexList = [&](const std::uint32_t* indices, std::size_t count)
+	{
+		IndexFormat::Write(indices, count, indexSize, indexCursor);
+		indexCursor += count*indexSize;
+	};
+	for(const Mesh& mesh : mMeshes)
+		writeIndexList(mesh.Indices(), mesh.IndexCount());
+	for(const IndexList& list : mIndexLists)
+		writeIndexList(list.Indices, list.Count);
+
+	if(keepCpuCopy)
+	{
+		staging.Upload(geo->VertexBufferGPU.Get(), 0, vertexData, geo->VertexBufferByteSize,
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_GENERIC_READ);
+		staging.Upload(geo->IndexBufferGPU.Get(), 0, indexData, geo->IndexBufferByteSize,
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_GENERIC_READ);
+	}
+
+	return geo;
+}
@@ -0,0 +1,84 @@
+//***************************************************************************************
+// MeshAtlasBuilder.h
+//
+// Concatenates meshes into one MeshGeometry.  The vertex and index offsets, bounds and
+// DrawArgs of every mesh are computed from the inputs, and the index format is 16-bit
+// when every index fits, 32-bit otherwise (see IndexFormat.h).  Vertices and indices
+// are written once, straight into staging memory, and copied from there into the
+// vertex and index buffers on the GPU; no intermediate arrays are made, and CPU copies
+// are kept only on request.  The vertices of baked meshes (MeshFile.h) are already in
+// the atlas vertex format and are copied with one memcpy.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+#include "MeshFile.h"
+#include "StagingUploader.h"
+#include <functional>
+
+class MeshAtlasBuilder
+{
+public:
+	///<summary>
+	/// Writes the vertices of a generated mesh, in the atlas vertex format, at destination.
+	/// submesh holds the bounds of the mesh.  destination may be write-combined
+	/// upload memory and must not be read.
+	///</summary>
+	typedef std::function<void(const GeometryGenerator::MeshView& mesh, const SubmeshGeometry& submesh, void* destination)> VertexWriter;
+
+	///<summary>
+	/// Adds a mesh drawn by DrawArgs[name] and returns its index.  The mesh is
+	/// referenced, not copied, so its storage must outlive Build.
+	///</summary>
+	UINT AddMesh(const std::string& name, const GeometryGenerator::MeshView& mesh);
+
+	///<summary>
+	/// Adds the full level of detail of a baked mesh, whose vertices are PackedVertex
+	/// quantized to its bounds.  The file must stay open until Build returns.
+	///</summary>
+	UINT AddMesh(const std::string& name, const MeshFile& file);
+
+	///<summary>
+	/// Adds DrawArgs[name] drawing count indices over the vertices of an added mesh,
+	/// such as a level of detail.  It shares the bounds and base vertex of the mesh.
+	/// The indices are referenced, not copied.
+	///</summary>
+	void AddIndices(const std::string& name, UINT mesh, const std::uint32_t* indices, std::size_t count);
+
+	///<summary>
+	/// Lays out the meshes in the order they were added, followed by the extra index
+	/// lists, and writes them into staging memory for the vertex and index buffers.
+	/// The copies are part of the next batch that staging records.  With
+	/// keepCpuCopy, the data is also kept in VertexBufferCPU and IndexBufferCPU for
+	/// CPU-side queries such as picking; otherwise those are null.
+	///</summary>
+	std::unique_ptr<MeshGeometry> Build(ID3D12Device* device, StagingUploader& staging,
+		const std::string& name, UINT vertexStride, const VertexWriter& writeVertices,
+		bool keepCpuCopy = false)const;
+
+private:
+	// A baked mesh when File is set, the generated mesh Data otherwise.
+	struct Mesh
+	{
+		std::string Name;
+		GeometryGenerator::MeshView Data;
+		const MeshFile* File = nullptr;
+
+		std::size_t VertexCount()const;
+		const std::uint32_t* Indices()const;
+		std::size_t IndexCount()const;
+	};
+
+	struct IndexList
+	{
+		std::string Name;
+		UINT Mesh = 0;
+		const std::uint32_t* Indices = nullptr;
+		std::size_t Count = 0;
+	};
+
+	std::vector<Mesh> mMeshes;
+	std::vector<IndexList> mIndexLists;
+};
@@ -0,0 +1,161 @@
+//***************************************************************************************
+// MeshBake.cpp
+//***************************************************************************************
+
+#include "MeshBake.h"
+#include "MappedFile.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const std::uint64_t FnvOffsetBasis = 14695981039346656037ull;
+	const std::uint64_t FnvPrime = 1099511628211ull;
+
+	std::uint64_t Fnv1a(std::uint64_t hash, const void* data, std::size_t size)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for(std::size_t i = 0; i < size; ++i)
+			hash = (hash ^ p[i])*FnvPrime;
+		return hash;
+	}
+}
+
+std::uint64_t MeshBake::SourceHash(const void* text, std::size_t size)
+{
+	return Fnv1a(FnvOffsetBasis, text, size);
+}
+
+std::uint64_t MeshBake::SettingsHash(const MeshBakeSettings& settings)
+{
+	std::uint64_t hash = Fnv1a(FnvOffsetBasis, &settings.LodCount, sizeof(settings.LodCount));
+	hash = Fnv1a(hash, &settings.LodReduction, sizeof(settings.LodReduction));
+	hash = Fnv1a(hash, &settings.LodMaxError, sizeof(settings.LodMaxError));
+	return hash;
+}
+
+void MeshBake::Bake(const TextMesh& mesh, const MeshBakeSettings& settings, MeshFileData& data)
+{
+	const std::size_t vertexCount = mesh.Vertices.size();
+
+	data = MeshFileData();
+	data.Indices = mesh.Indices;
+
+	// Bounds as center and extents, computed like DirectX::BoundingBox::CreateFromPoints
+	// so the app's submesh bounds dequantize exactly what was quantized here.
+	float minP[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxP[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for(const TextMeshVertex& v : mesh.Vertices)
+	{
+		for(int a = 0; a < 3; ++a)
+		{
+			minP[a] = (std::min)(minP[a], v.Position[a]);
+			maxP[a] = (std::max)(maxP[a], v.Position[a]);
+		}
+	}
+	float diagonal = 0.0f;
+	for(int a = 0; a < 3 && vertexCount > 0; ++a)
+	{
+		data.BoundsCenter[a] = (minP[a] + maxP[a])*0.5f;
+		data.BoundsExtents[a] = (maxP[a] - minP[a])*0.5f;
+		diagonal += (maxP[a] - minP[a])*(maxP[a] - minP[a]);
+	}
+	diagonal = std::sqrt(diagonal);
+
+	std::vector<LodLevel> lods;
+	if(vertexCount > 0 && settings.LodCount > 1)
+	{
+		MeshSimplifier simplifier(mesh.Vertices[0].Position, sizeof(TextMeshVertex), vertexCount);
+		lods = simplifier.BuildLodChain(mesh.Indices, settings.LodCount, settings.LodReduction,
+			settings.LodMaxError*diagonal);
+	}
+
+	// Order the full mesh for the vertex cache and renumber the vertices by first use,
+	// then reorder the coarser levels over the renumbered vertices.
+	MeshOptimize::OptimizeVertexCache(data.Indices.data(), data.Indices.size(), vertexCount);
+	std::vector<std::uint32_t> remap = MeshOptimize::OptimizeVertexFetch(data.Indices.data(), data.Indices.size(), vertexCount);
+
+	MeshFileLod full;
+	full.IndexCount = (std::uint32_t)data.Indices.size();
+	data.Lods.push_back(full);
+
+	for(std::size_t i = 1; i < lods.size(); ++i)
+	{
+		std::vector<std::uint32_t>& indices = lods[i].Indices;
+		MeshOptimize::RemapIndices(indices.data(), indices.size(), remap);
+		MeshOptimize::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+
+		MeshFileLod lod;
+		lod.StartIndex = (std::uint32_t)data.Indices.size();
+		lod.IndexCount = (std::uint32_t)indices.size();
+		lod.Error = lods[i].Error;
+		data.Lods.push_back(lod);
+		data.Indices.insert(data.Indices.end(), indices.begin(), indices.end());
+	}
+
+	QuantizationBounds bounds = QuantizationBounds::FromCenterExtents(data.BoundsCenter, data.BoundsExtents);
+	data.Vertices.resize(vertexCount);
+	for(std::size_t i = 0; i < vertexCount; ++i)
+		data.Vertices[remap[i]] = VertexQuantize::Pack(mesh.Vertices[i].Position, mesh.Vertices[i].Normal, bounds);
+}
+
+bool MeshBake::Load(const std::string& textPath, const std::string& meshPath, const MeshBakeSettings& settings,
+	MeshFile& file, std::string& error, bool* rebuilt)
+{
+	namespace fs = std::filesystem;
+
+	if(rebuilt != nullptr)
+		*rebuilt = false;
+
+	std::error_code ec;
+	const std::uintmax_t textSize = fs::file_size(textPath, ec);
+	fs::file_time_type textTime;
+	if(!ec)
+		textTime = fs::last_write_time(textPath, ec);
+	if(ec)
+		return file.Open(meshPath, error);
+
+	const std::uint64_t settingsHash = SettingsHash(settings);
+	bool current = file.Open(meshPath, error) && file.Header().SettingsHash == settingsHash &&
+		file.Header().SourceSize == textSize;
+	if(current)
+	{
+		const fs::file_time_type meshTime = fs::last_write_time(meshPath, ec);
+		if(!ec && textTime < meshTime)
+			return true;
+	}
+
+	MappedFile text;
+	if(!text.Open(textPath))
+		return file.Open(meshPath, error);
+
+	const std::uint64_t sourceHash = SourceHash(text.Data(), text.Size());
+	if(current && file.Header().SourceHash == sourceHash)
+	{
+		fs::last_write_time(meshPath, fs::file_time_type::clock::now(), ec);
+		return true;
+	}
+
+	file.Close();
+
+	TextMesh mesh;
+	if(!MeshTextParser::Parse(reinterpret_cast<const char*>(text.Data()), text.Size(), textPath, mesh, error))
+		return false;
+
+	MeshFileData data;
+	Bake(mesh, settings, data);
+	std::vector<unsigned char> image = MeshFile::Serialize(data, text.Size(), sourceHash, settingsHash);
+
+	std::ofstream fout(meshPath, std::ios::binary | std::ios::trunc);
+	fout.write(reinterpret_cast<const char*>(image.data()), (std::streamsize)image.size());
+
+	if(rebuilt != nullptr)
+		*rebuilt = true;
+
+	return file.Adopt(std::move(image), meshPath, error);
+}
@@ -0,0 +1,59 @@
+//***************************************************************************************
+// MeshBake.h
+//
+// Turns a VertexList/TriangleList text mesh into the contents of a .mesh file (see
+// MeshFile.h): a quadric simplification chain of levels of detail (MeshSimplify.h),
+// vertex cache and fetch ordering of every level (MeshOptimize.h) and vertices
+// quantized to PackedVertex (VertexQuantize.h).  The result is in the layout the
+// vertex and index buffers use, so loading it is a copy.
+//
+// Load keeps the .mesh file next to its text up to date: a file baked from other text
+// or with other settings is rebuilt.  The text is only read when it was written after
+// the .mesh file, so loading a current file does not touch the text.  No Direct3D
+// dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "MeshFile.h"
+#include "MeshTextParser.h"
+
+struct MeshBakeSettings
+{
+	// Levels of detail including the full mesh, each with about LodReduction times
+	// the triangles of the previous one.  The chain stops before the error reaches
+	// LodMaxError times the bounding box diagonal.  The defaults are the settings the
+	// app loads its models with.
+	std::uint32_t LodCount = 5;
+	float LodReduction = 0.5f;
+	float LodMaxError = 0.02f;
+};
+
+namespace MeshBake
+{
+	///<summary>
+	/// 64-bit FNV-1a hashes of the text and of the settings, stored in the header to
+	/// tell whether a .mesh file is stale.
+	///</summary>
+	std::uint64_t SourceHash(const void* text, std::size_t size);
+	std::uint64_t SettingsHash(const MeshBakeSettings& settings);
+
+	void Bake(const TextMesh& mesh, const MeshBakeSettings& settings, MeshFileData& data);
+
+	///<summary>
+	/// Opens meshPath if it was baked from the current contents of textPath with
+	/// settings.  Otherwise parses textPath, bakes it, writes meshPath (a failed write
+	/// only costs the next load the rebuild) and opens the result from memory.  Without
+	/// textPath, meshPath is used as it is.  rebuilt, if not null, tells which happened.
+	///
+	/// meshPath is current when the settings and the size of the text match its header
+	/// and the text was last written before it.  Text written since, e.g. by a fresh
+	/// checkout, is hashed; if it is unchanged meshPath is touched so the next load
+	/// does not hash it again.
+	///</summary>
+	bool Load(const std::string& textPath, const std::string& meshPath, const MeshBakeSettings& settings,
+		MeshFile& file, std::string& error, bool* rebuilt = nullptr);
+}
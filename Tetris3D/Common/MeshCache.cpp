@@ -0,0 +1,219 @@
+//***************************************************************************************
+// MeshCache.cpp
+//***************************************************************************************
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	// Header of a cache file.  The key bytes follow it, then the vertices from
+	// VertexOffset, aligned to VertexAlignment so they can be used in place, and the
+	// 32-bit indices.
+	struct MeshCacheFileHeader
+	{
+		static const std::uint32_t MagicValue = 0x4843534d; // "MSCH"
+		static const std::uint32_t CurrentVersion = 3;
+		static const std::uint32_t VertexAlignment = 16;
+
+		std::uint32_t Magic = MagicValue;
+		std::uint32_t Version = CurrentVersion;
+		std::uint32_t GeneratorVersion = GeometryGenerator::Version;
+		std::uint32_t VertexStride = sizeof(GeometryGenerator::Vertex);
+		std::uint32_t KeySize = 0;
+		std::uint32_t VertexCount = 0;
+		std::uint32_t IndexCount = 0;
+		std::uint32_t VertexOffset = 0;
+		std::uint64_t Hash = 0;
+	};
+
+	static_assert(sizeof(MeshCacheFileHeader) == 40, "MeshCacheFileHeader is part of the file format.");
+
+	std::uint32_t VertexOffsetFor(std::size_t keySize)
+	{
+		const std::uint32_t a = MeshCacheFileHeader::VertexAlignment;
+		return ((std::uint32_t)(sizeof(MeshCacheFileHeader) + keySize) + a - 1) & ~(a - 1);
+	}
+}
+
+CachedMesh::CachedMesh(GeometryGenerator::MeshData data)
+	: mData(std::move(data)), mView(mData)
+{
+}
+
+CachedMesh::CachedMesh(std::unique_ptr<MappedFile> file, std::size_t vertexOffset, std::size_t vertexCount,
+	std::size_t indexOffset, std::size_t indexCount)
+	: mFile(std::move(file))
+{
+	mView.Vertices = reinterpret_cast<const GeometryGenerator::Vertex*>(mFile->Data() + vertexOffset);
+	mView.VertexCount = vertexCount;
+	mView.Indices32 = reinterpret_cast<const std::uint32_t*>(mFile->Data() + indexOffset);
+	mView.IndexCount = indexCount;
+}
+
+std::uint64_t MeshKey::HashBytes(const void* data, std::size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	for(std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+MeshCache::MeshPtr MeshCache::GetOrCreate(const MeshKey& key, const std::function<GeometryGenerator::MeshData()>& create)
+{
+	std::promise<MeshPtr> promise;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		auto it = mEntries.find(key.Hash());
+		if(it != mEntries.end())
+		{
+			if(it->second.Key == key.Bytes())
+			{
+				mStats.Hits++;
+				std::shared_future<MeshPtr> mesh = it->second.Mesh;
+				lock.unlock();
+				return mesh.get();
+			}
+
+			// Another key with the same hash holds the slot; create without caching.
+			mStats.Misses++;
+			lock.unlock();
+			return std::make_shared<const CachedMesh>(create());
+		}
+
+		Entry& entry = mEntries[key.Hash()];
+		entry.Key = key.Bytes();
+		entry.Mesh = promise.get_future().share();
+		mStats.Misses++;
+	}
+
+	try
+	{
+		MeshPtr mesh = Load(key);
+		if(mesh != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStats.DiskLoads++;
+		}
+		else
+		{
+			mesh = std::make_shared<const CachedMesh>(create());
+			Save(key, mesh->View());
+		}
+
+		promise.set_value(mesh);
+		return mesh;
+	}
+	catch(...)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mEntries.erase(key.Hash());
+		}
+
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+}
+
+void MeshCache::SetDirectory(const std::string& directory)
+{
+	if(!directory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDirectory = directory;
+}
+
+MeshCache::Stats MeshCache::GetStats()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+void MeshCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.clear();
+}
+
+std::string MeshCache::FilePath(const MeshKey& key)const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(mDirectory.empty())
+		return std::string();
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key.Hash());
+	return mDirectory + "/" + name;
+}
+
+MeshCache::MeshPtr MeshCache::Load(const MeshKey& key)const
+{
+	std::string path = FilePath(key);
+	if(path.empty())
+		return nullptr;
+
+	auto file = std::make_unique<MappedFile>();
+	if(!file->Open(path) || file->Size() < sizeof(MeshCacheFileHeader))
+		return nullptr;
+
+	MeshCacheFileHeader h;
+	std::memcpy(&h, file->Data(), sizeof(h));
+
+	const std::uint64_t vertexBytes = (std::uint64_t)h.VertexCount*sizeof(GeometryGenerator::Vertex);
+	const std::uint64_t indexBytes = (std::uint64_t)h.IndexCount*sizeof(std::uint32_t);
+
+	// Anything unexpected, including a file cut short by an earlier run, is a miss
+	// and gets rewritten.
+	if(h.Magic != MeshCacheFileHeader::MagicValue || h.Version != MeshCacheFileHeader::CurrentVersion ||
+		h.GeneratorVersion != GeometryGenerator::Version || h.VertexStride != sizeof(GeometryGenerator::Vertex) || h.Hash != key.Hash() ||
+		h.KeySize != key.Bytes().size() || h.VertexOffset != VertexOffsetFor(h.KeySize) ||
+		file->Size() != h.VertexOffset + vertexBytes + indexBytes)
+		return nullptr;
+
+	if(std::memcmp(file->Data() + sizeof(h), key.Bytes().data(), h.KeySize) != 0)
+		return nullptr;
+
+	// The view starts on a page boundary, so the vertices and indices are aligned.
+	return std::make_shared<const CachedMesh>(std::move(file), h.VertexOffset, h.VertexCount,
+		(std::size_t)(h.VertexOffset + vertexBytes), h.IndexCount);
+}
+
+void MeshCache::Save(const MeshKey& key, const GeometryGenerator::MeshView& mesh)const
+{
+	std::string path = FilePath(key);
+	if(path.empty())
+		return;
+
+	MeshCacheFileHeader h;
+	h.KeySize = (std::uint32_t)key.Bytes().size();
+	h.VertexCount = (std::uint32_t)mesh.VertexCount;
+	h.IndexCount = (std::uint32_t)mesh.IndexCount;
+	h.VertexOffset = VertexOffsetFor(h.KeySize);
+	h.Hash = key.Hash();
+
+	const char padding[MeshCacheFileHeader::VertexAlignment] = {};
+
+	// A failed write leaves a file that Load rejects.
+	std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+	fout.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	fout.write(key.Bytes().data(), (std::streamsize)key.Bytes().size());
+	fout.write(padding, (std::streamsize)(h.VertexOffset - sizeof(h) - h.KeySize));
+	fout.write(reinterpret_cast<const char*>(mesh.Vertices), (std::streamsize)(mesh.VertexCount*sizeof(GeometryGenerator::Vertex)));
+	fout.write(reinterpret_cast<const char*>(mesh.Indices32), (std::streamsize)(mesh.IndexCount*sizeof(std::uint32_t)));
+}
@@ -0,0 +1,143 @@
+//***************************************************************************************
+// MeshCache.h
+//
+// Content-addressed cache of generated meshes.  A mesh is identified by a MeshKey, the
+// name of the generator and the values of its parameters, and is created once; later
+// requests for the same key share the same immutable CachedMesh.  With a directory set,
+// created meshes are also written there in a binary form and mapped on the next run
+// instead of being generated again; a mapped mesh is used in place, not copied.  Keys
+// and files carry GeometryGenerator::Version, so meshes cached by an older generator
+// are not reused.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include "GeometryGenerator.h"
+#include "MappedFile.h"
+
+class MeshKey
+{
+public:
+	///<summary>
+	/// The key of the mesh generator(params...) makes.  The bytes of each parameter are
+	/// hashed as they are, so 1.0f and 1.0 are different keys; use the parameter types
+	/// of the generator.  GeometryGenerator::Version is hashed with them.
+	///</summary>
+	template<typename... Params>
+	explicit MeshKey(const std::string& generator, Params... params)
+		: mBytes(generator)
+	{
+		mBytes.push_back('\0');
+		Append(GeometryGenerator::Version, params...);
+		mHash = HashBytes(mBytes.data(), mBytes.size());
+	}
+
+	const std::string& Bytes()const { return mBytes; }
+	std::uint64_t Hash()const { return mHash; }
+
+	// The same key with another hash, to test how the cache handles hash collisions.
+	static MeshKey WithHash(const MeshKey& key, std::uint64_t hash)
+	{
+		MeshKey result = key;
+		result.mHash = hash;
+		return result;
+	}
+
+	// 64-bit FNV-1a.
+	static std::uint64_t HashBytes(const void* data, std::size_t size);
+
+private:
+	void Append() {}
+
+	template<typename T, typename... Rest>
+	void Append(T value, Rest... rest)
+	{
+		static_assert(std::is_arithmetic<T>::value, "Mesh parameters must be numbers.");
+		mBytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		Append(rest...);
+	}
+
+	std::string mBytes;
+	std::uint64_t mHash = 0;
+};
+
+///<summary>
+/// A mesh held by the cache: generated, or read from the cache directory, in which
+/// case View points into the mapped file.
+///</summary>
+class CachedMesh
+{
+public:
+	explicit CachedMesh(GeometryGenerator::MeshData data);
+
+	// vertexOffset and indexOffset are byte offsets into file.
+	CachedMesh(std::unique_ptr<MappedFile> file, std::size_t vertexOffset, std::size_t vertexCount,
+		std::size_t indexOffset, std::size_t indexCount);
+
+	CachedMesh(const CachedMesh& rhs) = delete;
+	CachedMesh& operator=(const CachedMesh& rhs) = delete;
+
+	const GeometryGenerator::MeshView& View()const { return mView; }
+	bool IsMapped()const { return mFile != nullptr; }
+
+private:
+	GeometryGenerator::MeshData mData;
+	std::unique_ptr<MappedFile> mFile;
+	GeometryGenerator::MeshView mView;
+};
+
+class MeshCache
+{
+public:
+	typedef std::shared_ptr<const CachedMesh> MeshPtr;
+
+	struct Stats
+	{
+		std::uint64_t Hits = 0;      // Requests served from memory.
+		std::uint64_t Misses = 0;    // Requests that loaded or created the mesh.
+		std::uint64_t DiskLoads = 0; // Misses read from the directory.
+	};
+
+	///<summary>
+	/// Returns the mesh of key, calling create only if it is neither in memory nor in
+	/// the directory.  Safe to call from several threads; concurrent requests for the
+	/// same key wait for the first one.  If create throws, the key is not cached and
+	/// the exception reaches every waiting caller.
+	///</summary>
+	MeshPtr GetOrCreate(const MeshKey& key, const std::function<GeometryGenerator::MeshData()>& create);
+
+	///<summary>
+	/// Persists created meshes under directory, which is created if needed.  An empty
+	/// path (the default) keeps the cache in memory only.
+	///</summary>
+	void SetDirectory(const std::string& directory);
+
+	Stats GetStats()const;
+
+	// Drops the meshes held in memory; meshes still referenced stay alive.
+	void Clear();
+
+private:
+	struct Entry
+	{
+		std::string Key;
+		std::shared_future<MeshPtr> Mesh;
+	};
+
+	std::string FilePath(const MeshKey& key)const;
+	MeshPtr Load(const MeshKey& key)const;
+	void Save(const MeshKey& key, const GeometryGenerator::MeshView& mesh)const;
+
+	mutable std::mutex mMutex;
+	std::unordered_map<std::uint64_t, Entry> mEntries;
+	std::string mDirectory;
+	Stats mStats;
+};
@@ -0,0 +1,157 @@
+//***************************************************************************************
+// MeshFile.cpp
+//***************************************************************************************
+
+#include "MeshFile.h"
+#include "IndexFormat.h"
+#include <cstring>
+
+namespace
+{
+	std::uint64_t AlignUp(std::uint64_t offset)
+	{
+		const std::uint64_t a = MeshFileHeader::BlobAlignment;
+		return (offset + a - 1) & ~(a - 1);
+	}
+}
+
+bool MeshFile::Open(const std::string& path, std::string& error)
+{
+	Close();
+
+	if(!mFile.Open(path))
+	{
+		error = path + ": cannot open file.";
+		return false;
+	}
+
+	return Validate(mFile.Data(), mFile.Size(), path, error);
+}
+
+bool MeshFile::Adopt(std::vector<unsigned char> image, const std::string& name, std::string& error)
+{
+	Close();
+
+	mImage = std::move(image);
+	return Validate(mImage.data(), mImage.size(), name, error);
+}
+
+bool MeshFile::Validate(const unsigned char* data, std::size_t size, const std::string& name, std::string& error)
+{
+	const std::uint64_t fileSize = size;
+	if(fileSize < sizeof(MeshFileHeader))
+	{
+		error = name + ": file is smaller than the header.";
+		Close();
+		return false;
+	}
+
+	const MeshFileHeader* h = reinterpret_cast<const MeshFileHeader*>(data);
+
+	// Only called once the blobs are known to be inside the file.
+	auto lodsInRange = [h, data]()
+	{
+		const MeshFileLod* lods = reinterpret_cast<const MeshFileLod*>(data + h->LodOffset);
+		for(std::uint32_t i = 0; i < h->LodCount; ++i)
+		{
+			if((std::uint64_t)lods[i].StartIndex + lods[i].IndexCount > h->IndexCount || lods[i].IndexCount % 3 != 0)
+				return false;
+		}
+		return true;
+	};
+	auto maxIndex = [h, data]()
+	{
+		return IndexFormat::MaxIndex(reinterpret_cast<const std::uint32_t*>(data + h->IndexOffset), h->IndexCount);
+	};
+
+	if(h->Magic != MeshFileHeader::MagicValue)
+		error = name + ": not a mesh file.";
+	else if(h->Version != MeshFileHeader::CurrentVersion)
+		error = name + ": unsupported version " + std::to_string(h->Version) + ".";
+	else if(h->HeaderSize != sizeof(MeshFileHeader) || h->VertexStride != sizeof(PackedVertex) ||
+		h->IndexStride != sizeof(std::uint32_t))
+		error = name + ": unexpected header, vertex or index size.";
+	else if(h->FileSize != fileSize)
+		error = name + ": file is truncated.";
+	else if(h->LodOffset % alignof(MeshFileLod) != 0 ||
+		h->VertexOffset % MeshFileHeader::BlobAlignment != 0 || h->IndexOffset % MeshFileHeader::BlobAlignment != 0)
+		error = name + ": blobs are not aligned.";
+	else if(h->LodOffset < sizeof(MeshFileHeader) ||
+		h->LodOffset > fileSize || h->VertexOffset > fileSize || h->IndexOffset > fileSize ||
+		h->LodOffset + (std::uint64_t)h->LodCount*sizeof(MeshFileLod) > h->VertexOffset ||
+		h->VertexOffset + (std::uint64_t)h->VertexCount*h->VertexStride > h->IndexOffset ||
+		h->IndexOffset + (std::uint64_t)h->IndexCount*h->IndexStride > fileSize)
+		error = name + ": blobs are out of range.";
+	else if(h->LodCount == 0 || !lodsInRange())
+		error = name + ": level of detail ranges are out of range.";
+	else if(h->IndexCount > 0 && (h->VertexCount == 0 || maxIndex() >= h->VertexCount))
+		error = name + ": indices are out of range.";
+	else
+	{
+		mHeader = h;
+		return true;
+	}
+
+	Close();
+	return false;
+}
+
+void MeshFile::Close()
+{
+	mFile.Close();
+	mImage.clear();
+	mHeader = nullptr;
+}
+
+const MeshFileLod* MeshFile::Lods()const
+{
+	return reinterpret_cast<const MeshFileLod*>(Data() + mHeader->LodOffset);
+}
+
+const PackedVertex* MeshFile::Vertices()const
+{
+	return reinterpret_cast<const PackedVertex*>(Data() + mHeader->VertexOffset);
+}
+
+const std::uint32_t* MeshFile::Indices()const
+{
+	return reinterpret_cast<const std::uint32_t*>(Data() + mHeader->IndexOffset);
+}
+
+std::vector<unsigned char> MeshFile::Serialize(const MeshFileData& data, std::uint64_t sourceSize,
+	std::uint64_t sourceHash, std::uint64_t settingsHash)
+{
+	MeshFileHeader h;
+	h.VertexCount = (std::uint32_t)data.Vertices.size();
+	h.IndexCount = (std::uint32_t)data.Indices.size();
+	h.LodCount = (std::uint32_t)data.Lods.size();
+	for(int a = 0; a < 3; ++a)
+	{
+		h.BoundsCenter[a] = data.BoundsCenter[a];
+		h.BoundsExtents[a] = data.BoundsExtents[a];
+	}
+	h.SourceSize = sourceSize;
+	h.SourceHash = sourceHash;
+	h.SettingsHash = settingsHash;
+
+	const std::uint64_t lodBytes = (std::uint64_t)h.LodCount*sizeof(MeshFileLod);
+	const std::uint64_t vertexBytes = (std::uint64_t)h.VertexCount*sizeof(PackedVertex);
+	const std::uint64_t indexBytes = (std::uint64_t)h.IndexCount*sizeof(std::uint32_t);
+
+	h.LodOffset = sizeof(MeshFileHeader);
+	h.VertexOffset = AlignUp(h.LodOffset + lodBytes);
+	h.IndexOffset = AlignUp(h.VertexOffset + vertexBytes);
+	h.FileSize = h.IndexOffset + indexBytes;
+
+	// The padding between the blobs is zero.
+	std::vector<unsigned char> image((std::size_t)h.FileSize, 0);
+	std::memcpy(image.data(), &h, sizeof(h));
+	if(lodBytes > 0)
+		std::memcpy(image.data() + h.LodOffset, data.Lods.data(), (std::size_t)lodBytes);
+	if(vertexBytes > 0)
+		std::memcpy(image.data() + h.VertexOffset, data.Vertices.data(), (std::size_t)vertexBytes);
+	if(indexBytes > 0)
+		std::memcpy(image.data() + h.IndexOffset, data.Indices.data(), (std::size_t)indexBytes);
+
+	return image;
+}
@@ -0,0 +1,126 @@
+//***************************************************************************************
+// MeshFile.h
+//
+// Versioned binary mesh container (.mesh).  The file is a MeshFileHeader followed by
+// the level of detail table (MeshFileLod), the vertex blob (PackedVertex, quantized to
+// the bounds in the header) and the index blob (32-bit triangle lists of every level,
+// relative to the first vertex).  The vertex and index blobs start on a
+// BlobAlignment boundary.  The vertices are stored in the layout the vertex buffer
+// uses, so a MeshFile hands out pointers into the mapped view and the vertex blob is
+// copied into staging memory with one memcpy.
+//
+// Files are baked from the VertexList/TriangleList text format by MeshBake (see
+// MeshBake.h), either offline by Tools/MeshConverter.cpp or at load time when the
+// .mesh file is missing or stale.  All fields are little endian.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "VertexQuantize.h"
+
+struct MeshFileLod
+{
+	// Range of the index blob, in indices.
+	std::uint32_t StartIndex = 0;
+	std::uint32_t IndexCount = 0;
+
+	// Distance from the full mesh in model units (LodLevel::Error).
+	float Error = 0.0f;
+	std::uint32_t Reserved = 0;
+};
+
+struct MeshFileHeader
+{
+	static const std::uint32_t MagicValue = 0x4853454d; // "MESH"
+	static const std::uint32_t CurrentVersion = 3;
+	static const std::uint32_t BlobAlignment = 256;
+
+	std::uint32_t Magic = MagicValue;
+	std::uint32_t Version = CurrentVersion;
+	std::uint32_t HeaderSize = sizeof(MeshFileHeader);
+	std::uint32_t VertexStride = sizeof(PackedVertex);
+
+	std::uint32_t VertexCount = 0;
+	std::uint32_t IndexCount = 0;
+	std::uint32_t IndexStride = sizeof(std::uint32_t);
+	std::uint32_t LodCount = 0;
+
+	// Bounds of the positions; the vertices are quantized to
+	// QuantizationBounds::FromCenterExtents(BoundsCenter, BoundsExtents).
+	float BoundsCenter[3] = { 0.0f, 0.0f, 0.0f };
+	float BoundsExtents[3] = { 0.0f, 0.0f, 0.0f };
+
+	// Size and MeshBake::SourceHash of the text file the mesh was baked from, and
+	// MeshBake::SettingsHash of the settings it was baked with.
+	std::uint64_t SourceSize = 0;
+	std::uint64_t SourceHash = 0;
+	std::uint64_t SettingsHash = 0;
+
+	// Byte offsets from the start of the file.
+	std::uint64_t LodOffset = 0;
+	std::uint64_t VertexOffset = 0;
+	std::uint64_t IndexOffset = 0;
+	std::uint64_t FileSize = 0;
+};
+
+static_assert(sizeof(MeshFileHeader) == 112, "MeshFileHeader is part of the file format.");
+static_assert(sizeof(MeshFileLod) == 16, "MeshFileLod is part of the file format.");
+
+///<summary>
+/// Contents of a .mesh file in memory, as written by MeshFile::Serialize.
+///</summary>
+struct MeshFileData
+{
+	float BoundsCenter[3] = { 0.0f, 0.0f, 0.0f };
+	float BoundsExtents[3] = { 0.0f, 0.0f, 0.0f };
+
+	std::vector<PackedVertex> Vertices;
+	std::vector<std::uint32_t> Indices;
+	std::vector<MeshFileLod> Lods;
+};
+
+class MeshFile
+{
+public:
+	///<summary>
+	/// Maps path and validates it: the header against the file, the level of detail
+	/// ranges against the index blob, and every index against the vertex count.  On
+	/// failure returns false and describes the problem in error.
+	///</summary>
+	bool Open(const std::string& path, std::string& error);
+
+	///<summary>
+	/// Same as Open for a file image already in memory, e.g. one just baked.  name is
+	/// used in the error message.
+	///</summary>
+	bool Adopt(std::vector<unsigned char> image, const std::string& name, std::string& error);
+
+	void Close();
+
+	bool IsOpen()const { return mHeader != nullptr; }
+	const MeshFileHeader& Header()const { return *mHeader; }
+	const MeshFileLod* Lods()const;
+	const PackedVertex* Vertices()const;
+	const std::uint32_t* Indices()const;
+
+	///<summary>
+	/// Lays out a .mesh file image.  The levels of detail must index data.Indices and
+	/// the indices data.Vertices.
+	///</summary>
+	static std::vector<unsigned char> Serialize(const MeshFileData& data, std::uint64_t sourceSize,
+		std::uint64_t sourceHash, std::uint64_t settingsHash);
+
+private:
+	bool Validate(const unsigned char* data, std::size_t size, const std::string& name, std::string& error);
+
+	const unsigned char* Data()const { return mFile.IsOpen() ? mFile.Data() : mImage.data(); }
+
+	MappedFile mFile;
+	std::vector<unsigned char> mImage;
+	const MeshFileHeader* mHeader = nullptr;
+};
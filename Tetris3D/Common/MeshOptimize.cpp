@@ -0,0 +1,167 @@
+//***************************************************************************************
+// MeshOptimize.cpp
+//***************************************************************************************
+
+#include "MeshOptimize.h"
+#include <algorithm>
+
+namespace MeshOptimize
+{
+
+float ComputeAcmr(const std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount, unsigned cacheSize)
+{
+	if(indexCount < 3)
+		return 0.0f;
+
+	// A vertex is in the FIFO while fewer than cacheSize misses happened since it
+	// was inserted.
+	std::vector<std::size_t> insertedAt(vertexCount, 0);
+	std::size_t misses = 0;
+
+	for(std::size_t i = 0; i < indexCount; ++i)
+	{
+		std::uint32_t v = indices[i];
+		if(insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize)
+		{
+			misses++;
+			insertedAt[v] = misses;
+		}
+	}
+
+	return static_cast<float>(misses) / (indexCount / 3);
+}
+
+void OptimizeVertexCache(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount, unsigned cacheSize)
+{
+	std::size_t triCount = indexCount / 3;
+	if(triCount == 0)
+		return;
+
+	// Vertex to triangle adjacency in compressed rows.
+	std::vector<std::uint32_t> liveTris(vertexCount, 0);
+	for(std::size_t i = 0; i < triCount*3; ++i)
+		liveTris[indices[i]]++;
+
+	std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+	for(std::size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + liveTris[v];
+
+	std::vector<std::uint32_t> adjacency(offsets[vertexCount]);
+	{
+		std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for(std::size_t i = 0; i < triCount*3; ++i)
+			adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+	}
+
+	std::vector<std::uint32_t> cacheTime(vertexCount, 0);
+	std::vector<std::uint8_t> emitted(triCount, 0);
+	std::vector<std::uint32_t> deadEnd;
+	std::vector<std::uint32_t> candidates;
+	std::vector<std::uint32_t> output;
+	output.reserve(triCount*3);
+
+	std::uint32_t time = cacheSize + 1;
+	std::size_t cursor = 0;
+	std::int64_t fan = indices[0];
+
+	while(fan >= 0)
+	{
+		// Emit every remaining triangle around the fanning vertex.
+		candidates.clear();
+		for(std::uint32_t k = offsets[fan]; k < offsets[fan + 1]; ++k)
+		{
+			std::uint32_t t = adjacency[k];
+			if(emitted[t])
+				continue;
+
+			for(int c = 0; c < 3; ++c)
+			{
+				std::uint32_t v = indices[t*3 + c];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTris[v]--;
+
+				if(time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		// Next fan: the candidate that stays in the cache longest and still has
+		// triangles left, if it will still be cached when its fan is emitted.
+		fan = -1;
+		int best = -1;
+		for(std::uint32_t v : candidates)
+		{
+			if(liveTris[v] == 0)
+				continue;
+
+			int priority = 0;
+			if(time - cacheTime[v] + 2*liveTris[v] <= cacheSize)
+				priority = time - cacheTime[v];
+
+			if(priority > best)
+			{
+				best = priority;
+				fan = v;
+			}
+		}
+
+		if(fan < 0)
+		{
+			// Dead end: go back to a recently used vertex, or scan forwards.
+			while(!deadEnd.empty() && fan < 0)
+			{
+				std::uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+				if(liveTris[v] > 0)
+					fan = v;
+			}
+
+			while(fan < 0 && cursor < vertexCount)
+			{
+				if(liveTris[cursor] > 0)
+					fan = static_cast<std::int64_t>(cursor);
+				else
+					cursor++;
+			}
+		}
+	}
+
+	// Meshes exported by a tool that already optimized them can be better than this.
+	if(ComputeAcmr(output.data(), output.size(), vertexCount, cacheSize) < ComputeAcmr(indices, triCount*3, vertexCount, cacheSize))
+		std::copy(output.begin(), output.end(), indices);
+}
+
+std::vector<std::uint32_t> OptimizeVertexFetch(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount)
+{
+	const std::uint32_t unused = 0xffffffff;
+
+	std::vector<std::uint32_t> remap(vertexCount, unused);
+	std::uint32_t next = 0;
+
+	for(std::size_t i = 0; i < indexCount; ++i)
+	{
+		std::uint32_t& r = remap[indices[i]];
+		if(r == unused)
+			r = next++;
+		indices[i] = r;
+	}
+
+	for(std::size_t v = 0; v < vertexCount; ++v)
+	{
+		if(remap[v] == unused)
+			remap[v] = next++;
+	}
+
+	return remap;
+}
+
+void RemapIndices(std::uint32_t* indices, std::size_t indexCount, const std::vector<std::uint32_t>& remap)
+{
+	for(std::size_t i = 0; i < indexCount; ++i)
+		indices[i] = remap[indices[i]];
+}
+
+}
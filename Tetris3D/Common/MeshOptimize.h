@@ -0,0 +1,52 @@
+//***************************************************************************************
+// MeshOptimize.h
+//
+// Index and vertex reordering for the GPU vertex pipeline:
+//   OptimizeVertexCache reorders triangles for post-transform cache reuse (Tipsify,
+//   Sander, Nehab and Barczak 2007), linear in the mesh size.
+//   OptimizeVertexFetch renumbers vertices in the order they are first used so
+//   vertex fetches walk the vertex buffer forwards.
+//   ComputeAcmr measures the average cache miss ratio (transformed vertices per
+//   triangle) with a FIFO cache; 0.5 is the ideal for large regular meshes, 3 the worst.
+//
+// No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace MeshOptimize
+{
+	const unsigned DefaultCacheSize = 16;
+
+	float ComputeAcmr(const std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount,
+		unsigned cacheSize = DefaultCacheSize);
+
+	///<summary>
+	/// Reorders the triangles of a triangle list in place.  Triangles keep their winding.
+	/// The input order is kept if its ACMR is already lower.
+	///</summary>
+	void OptimizeVertexCache(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount,
+		unsigned cacheSize = DefaultCacheSize);
+
+	///<summary>
+	/// Renumbers the vertices of a triangle list by first use and rewrites the indices.
+	/// Returns the remap table, remap[old] = new; unused vertices go last.  Apply it to
+	/// the vertex data with RemapVertices and to other index lists with RemapIndices.
+	///</summary>
+	std::vector<std::uint32_t> OptimizeVertexFetch(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount);
+
+	void RemapIndices(std::uint32_t* indices, std::size_t indexCount, const std::vector<std::uint32_t>& remap);
+
+	template<typename T>
+	void RemapVertices(std::vector<T>& vertices, const std::vector<std::uint32_t>& remap)
+	{
+		std::vector<T> result(vertices.size());
+		for(std::size_t i = 0; i < vertices.size(); ++i)
+			result[remap[i]] = vertices[i];
+		vertices.swap(result);
+	}
+}
@@ -0,0 +1,506 @@
+//***************************************************************************************
+// MeshSimplify.cpp
+//***************************************************************************************
+
+#include "MeshSimplify.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <thread>
+
+namespace
+{
+	// Symmetric 4x4 matrix: xx xy xz xw yy yz yw zz zw ww.
+	struct Quadric
+	{
+		double a[10] = {};
+
+		void AddPlane(double nx, double ny, double nz, double d)
+		{
+			a[0] += nx*nx; a[1] += nx*ny; a[2] += nx*nz; a[3] += nx*d;
+			a[4] += ny*ny; a[5] += ny*nz; a[6] += ny*d;
+			a[7] += nz*nz; a[8] += nz*d;
+			a[9] += d*d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			for(int i = 0; i < 10; ++i)
+				a[i] += q.a[i];
+		}
+
+		double Evaluate(const float* p)const
+		{
+			double x = p[0], y = p[1], z = p[2];
+			return a[0]*x*x + 2.0*a[1]*x*y + 2.0*a[2]*x*z + 2.0*a[3]*x +
+				a[4]*y*y + 2.0*a[5]*y*z + 2.0*a[6]*y +
+				a[7]*z*z + 2.0*a[8]*z +
+				a[9];
+		}
+	};
+
+	struct Collapse
+	{
+		double Cost;
+		std::uint32_t From;
+		std::uint32_t To;
+		std::uint32_t FromVersion;
+		std::uint32_t ToVersion;
+
+		bool operator>(const Collapse& rhs)const { return Cost > rhs.Cost; }
+	};
+
+	// Region of vertices that may not be collapsed.
+	const int Locked = -1;
+
+	void Cross(const float* p0, const float* p1, const float* p2, double n[3])
+	{
+		double e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		double e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		n[0] = e0[1]*e1[2] - e0[2]*e1[1];
+		n[1] = e0[2]*e1[0] - e0[0]*e1[2];
+		n[2] = e0[0]*e1[1] - e0[1]*e1[0];
+	}
+}
+
+// Working copy of the mesh.  During the parallel pass each thread only touches the
+// triangles of its region and the vertices whose every triangle is in that region.
+struct SimplifyState
+{
+	typedef std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> CollapseQueue;
+
+	explicit SimplifyState(const MeshSimplifier& mesh) : Mesh(mesh) {}
+
+	const MeshSimplifier& Mesh;
+
+	std::vector<std::uint32_t> Tris;
+	std::vector<std::uint8_t> TriDead;
+	std::vector<std::vector<std::uint32_t>> VertexTris;
+	std::vector<Quadric> Quadrics;
+	std::vector<std::uint32_t> Versions;
+	std::vector<std::uint8_t> Removed;
+	std::vector<std::uint8_t> Border;
+	std::vector<int> Regions;
+
+	void Init(const std::vector<std::uint32_t>& indices)
+	{
+		std::size_t vertexCount = Mesh.mVertexCount;
+		std::size_t triCount = indices.size() / 3;
+
+		Tris.assign(indices.begin(), indices.begin() + triCount*3);
+		TriDead.assign(triCount, 0);
+		VertexTris.assign(vertexCount, std::vector<std::uint32_t>());
+		Quadrics.assign(vertexCount, Quadric());
+		Versions.assign(vertexCount, 0);
+		Removed.assign(vertexCount, 0);
+		Border.assign(vertexCount, 0);
+		Regions.assign(vertexCount, Locked);
+
+		std::vector<std::uint64_t> edges;
+		edges.reserve(triCount*3);
+
+		for(std::uint32_t t = 0; t < triCount; ++t)
+		{
+			const std::uint32_t* tri = &Tris[t*3];
+
+			double n[3];
+			Cross(Mesh.Position(tri[0]), Mesh.Position(tri[1]), Mesh.Position(tri[2]), n);
+			double len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+			for(int k = 0; k < 3; ++k)
+			{
+				VertexTris[tri[k]].push_back(t);
+
+				std::uint32_t a = std::min(tri[k], tri[(k + 1) % 3]);
+				std::uint32_t b = std::max(tri[k], tri[(k + 1) % 3]);
+				edges.push_back((std::uint64_t(a) << 32) | b);
+			}
+
+			if(len > 0.0)
+			{
+				n[0] /= len; n[1] /= len; n[2] /= len;
+				const float* p = Mesh.Position(tri[0]);
+				double d = -(n[0]*p[0] + n[1]*p[1] + n[2]*p[2]);
+				for(int k = 0; k < 3; ++k)
+					Quadrics[tri[k]].AddPlane(n[0], n[1], n[2], d);
+			}
+		}
+
+		// Vertices on open or non-manifold edges keep the silhouette and are never removed.
+		std::sort(edges.begin(), edges.end());
+		for(std::size_t i = 0; i < edges.size(); )
+		{
+			std::size_t j = i;
+			while(j < edges.size() && edges[j] == edges[i])
+				++j;
+
+			if(j - i != 2)
+			{
+				Border[edges[i] >> 32] = 1;
+				Border[edges[i] & 0xffffffff] = 1;
+			}
+			i = j;
+		}
+	}
+
+	// Splits the triangles into slabs along the longest axis.  Vertices used by more
+	// than one slab are locked.
+	std::vector<std::vector<std::uint32_t>> AssignRegions(int regionCount)
+	{
+		std::size_t triCount = TriDead.size();
+
+		float lo[3] = { 1e30f, 1e30f, 1e30f };
+		float hi[3] = { -1e30f, -1e30f, -1e30f };
+		for(std::uint32_t v : Tris)
+		{
+			const float* p = Mesh.Position(v);
+			for(int k = 0; k < 3; ++k)
+			{
+				lo[k] = std::min(lo[k], p[k]);
+				hi[k] = std::max(hi[k], p[k]);
+			}
+		}
+
+		int axis = 0;
+		for(int k = 1; k < 3; ++k)
+		{
+			if(hi[k] - lo[k] > hi[axis] - lo[axis])
+				axis = k;
+		}
+		float extent = std::max(hi[axis] - lo[axis], 1e-20f);
+
+		std::vector<std::vector<std::uint32_t>> regionTris(regionCount);
+		std::vector<int> triRegion(triCount);
+		for(std::uint32_t t = 0; t < triCount; ++t)
+		{
+			const std::uint32_t* tri = &Tris[t*3];
+			float c = (Mesh.Position(tri[0])[axis] + Mesh.Position(tri[1])[axis] + Mesh.Position(tri[2])[axis]) / 3.0f;
+			int r = static_cast<int>((c - lo[axis]) / extent * regionCount);
+			r = std::min(std::max(r, 0), regionCount - 1);
+
+			triRegion[t] = r;
+			regionTris[r].push_back(t);
+		}
+
+		for(std::size_t v = 0; v < VertexTris.size(); ++v)
+		{
+			const auto& tris = VertexTris[v];
+			int r = Border[v] || tris.empty() ? Locked : triRegion[tris[0]];
+			for(std::size_t i = 1; i < tris.size() && r != Locked; ++i)
+			{
+				if(triRegion[tris[i]] != r)
+					r = Locked;
+			}
+			Regions[v] = r;
+		}
+
+		return regionTris;
+	}
+
+	std::vector<std::uint32_t> AssignSingleRegion()
+	{
+		for(std::size_t v = 0; v < VertexTris.size(); ++v)
+			Regions[v] = Border[v] || Removed[v] || VertexTris[v].empty() ? Locked : 0;
+
+		std::vector<std::uint32_t> tris;
+		for(std::uint32_t t = 0; t < TriDead.size(); ++t)
+		{
+			if(!TriDead[t])
+				tris.push_back(t);
+		}
+		return tris;
+	}
+
+	void Push(CollapseQueue& queue, int region, std::uint32_t from, std::uint32_t to)const
+	{
+		if(Regions[from] != region || Regions[to] != region)
+			return;
+
+		Quadric q = Quadrics[from];
+		q.Add(Quadrics[to]);
+
+		Collapse c;
+		c.Cost = std::max(q.Evaluate(Mesh.Position(to)), 0.0);
+		c.From = from;
+		c.To = to;
+		c.FromVersion = Versions[from];
+		c.ToVersion = Versions[to];
+		queue.push(c);
+	}
+
+	void Neighbors(std::uint32_t v, std::vector<std::uint32_t>& out)const
+	{
+		out.clear();
+		for(std::uint32_t t : VertexTris[v])
+		{
+			if(TriDead[t])
+				continue;
+			for(int k = 0; k < 3; ++k)
+			{
+				if(Tris[t*3 + k] != v)
+					out.push_back(Tris[t*3 + k]);
+			}
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+
+	bool CanCollapse(std::uint32_t from, std::uint32_t to, std::vector<std::uint32_t>& a, std::vector<std::uint32_t>& b)const
+	{
+		// Link condition: an interior edge has exactly two common neighbours,
+		// more would make the result non-manifold.
+		Neighbors(from, a);
+		Neighbors(to, b);
+
+		std::size_t common = 0;
+		for(std::size_t i = 0, j = 0; i < a.size() && j < b.size(); )
+		{
+			if(a[i] < b[j]) ++i;
+			else if(b[j] < a[i]) ++j;
+			else { ++common; ++i; ++j; }
+		}
+		if(common > 2)
+			return false;
+
+		// The triangles that remain must not flip or become degenerate.
+		for(std::uint32_t t : VertexTris[from])
+		{
+			if(TriDead[t])
+				continue;
+
+			const std::uint32_t* tri = &Tris[t*3];
+			if(tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+
+			const float* p[3];
+			const float* q[3];
+			for(int k = 0; k < 3; ++k)
+			{
+				p[k] = Mesh.Position(tri[k]);
+				q[k] = tri[k] == from ? Mesh.Position(to) : p[k];
+			}
+
+			double n0[3], n1[3];
+			Cross(p[0], p[1], p[2], n0);
+			Cross(q[0], q[1], q[2], n1);
+			if(n0[0]*n1[0] + n0[1]*n1[1] + n0[2]*n1[2] <= 0.0)
+				return false;
+		}
+
+		return true;
+	}
+
+	std::size_t DoCollapse(std::uint32_t from, std::uint32_t to)
+	{
+		std::size_t removedTris = 0;
+
+		for(std::uint32_t t : VertexTris[from])
+		{
+			if(TriDead[t])
+				continue;
+
+			std::uint32_t* tri = &Tris[t*3];
+			if(tri[0] == to || tri[1] == to || tri[2] == to)
+			{
+				TriDead[t] = 1;
+				removedTris++;
+				continue;
+			}
+
+			for(int k = 0; k < 3; ++k)
+			{
+				if(tri[k] == from)
+					tri[k] = to;
+			}
+			VertexTris[to].push_back(t);
+		}
+
+		VertexTris[from].clear();
+		Removed[from] = 1;
+		Versions[from]++;
+		Versions[to]++;
+		Quadrics[to].Add(Quadrics[from]);
+
+		auto& tris = VertexTris[to];
+		tris.erase(std::remove_if(tris.begin(), tris.end(), [this](std::uint32_t t) { return TriDead[t] != 0; }), tris.end());
+
+		return removedTris;
+	}
+
+	// Collapses the cheapest edges between vertices of region until the triangles of
+	// the region number at most target or the next collapse costs more than costLimit.
+	// Returns the largest cost collapsed.
+	double SimplifyRegion(int region, const std::vector<std::uint32_t>& tris, std::size_t target, double costLimit)
+	{
+		CollapseQueue queue;
+		for(std::uint32_t t : tris)
+		{
+			for(int k = 0; k < 3; ++k)
+			{
+				std::uint32_t a = Tris[t*3 + k];
+				std::uint32_t b = Tris[t*3 + (k + 1) % 3];
+				Push(queue, region, a, b);
+				Push(queue, region, b, a);
+			}
+		}
+
+		std::size_t live = tris.size();
+		double maxCost = 0.0;
+		std::vector<std::uint32_t> a, b, neighbors;
+
+		while(live > target && !queue.empty())
+		{
+			Collapse c = queue.top();
+			queue.pop();
+
+			if(Removed[c.From] || Removed[c.To] ||
+				Versions[c.From] != c.FromVersion || Versions[c.To] != c.ToVersion)
+				continue;
+
+			// Every remaining valid collapse costs at least as much.
+			if(c.Cost > costLimit)
+				break;
+
+			if(!CanCollapse(c.From, c.To, a, b))
+				continue;
+
+			live -= DoCollapse(c.From, c.To);
+			maxCost = std::max(maxCost, c.Cost);
+
+			Neighbors(c.To, neighbors);
+			for(std::uint32_t n : neighbors)
+			{
+				Push(queue, region, c.To, n);
+				Push(queue, region, n, c.To);
+			}
+
+			// The link of c.To changed, so a collapse along it that was rejected before
+			// may be valid now.
+			for(std::uint32_t t : VertexTris[c.To])
+			{
+				const std::uint32_t* tri = &Tris[t*3];
+				for(int k = 0; k < 3; ++k)
+				{
+					if(tri[k] == c.To)
+					{
+						Push(queue, region, tri[(k + 1) % 3], tri[(k + 2) % 3]);
+						Push(queue, region, tri[(k + 2) % 3], tri[(k + 1) % 3]);
+					}
+				}
+			}
+		}
+
+		return maxCost;
+	}
+};
+
+MeshSimplifier::MeshSimplifier(const float* positions, std::size_t positionStride, std::size_t vertexCount)
+	: mPositions(positions), mPositionStride(positionStride), mVertexCount(vertexCount)
+{
+}
+
+LodLevel MeshSimplifier::Simplify(const std::vector<std::uint32_t>& indices, std::size_t targetTriangleCount,
+	float maxError, unsigned threadCount)const
+{
+	if(threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	SimplifyState state(*this);
+	state.Init(indices);
+
+	std::size_t triCount = indices.size() / 3;
+	double maxCost = 0.0;
+	double costLimit = maxError > 0.0f ? double(maxError)*maxError : HUGE_VAL;
+
+	// Small meshes are not worth the locked slab borders.
+	const std::size_t minRegionTris = 2048;
+	const std::size_t serialShare = 50; // percent of the collapses left to the serial pass
+	int regionCount = static_cast<int>(std::min<std::size_t>(threadCount, triCount / minRegionTris));
+
+	if(regionCount > 1 && targetTriangleCount < triCount)
+	{
+		auto regionTris = state.AssignRegions(regionCount);
+
+		std::vector<double> regionCost(regionCount, 0.0);
+		std::vector<std::thread> threads;
+		for(int r = 0; r < regionCount; ++r)
+		{
+			// Leave part of the collapses to the serial pass so that the most expensive
+			// ones are chosen across the whole mesh rather than forced inside a slab.
+			std::size_t regionTarget = regionTris[r].size()*targetTriangleCount / triCount;
+			std::size_t target = regionTarget + (regionTris[r].size() - regionTarget)*serialShare / 100;
+			threads.emplace_back([&state, &regionTris, &regionCost, r, target, costLimit]()
+			{
+				regionCost[r] = state.SimplifyRegion(r, regionTris[r], target, costLimit);
+			});
+		}
+		for(auto& t : threads)
+			t.join();
+
+		for(double c : regionCost)
+			maxCost = std::max(maxCost, c);
+	}
+
+	// Finish across the slab borders.
+	auto tris = state.AssignSingleRegion();
+	maxCost = std::max(maxCost, state.SimplifyRegion(0, tris, targetTriangleCount, costLimit));
+
+	LodLevel level;
+	level.Error = static_cast<float>(std::sqrt(maxCost));
+	for(std::uint32_t t = 0; t < state.TriDead.size(); ++t)
+	{
+		if(!state.TriDead[t])
+			level.Indices.insert(level.Indices.end(), &state.Tris[t*3], &state.Tris[t*3] + 3);
+	}
+
+	return level;
+}
+
+std::vector<LodLevel> MeshSimplifier::BuildLodChain(const std::vector<std::uint32_t>& indices, std::size_t levelCount,
+	float reduction, float maxError, unsigned threadCount)const
+{
+	std::vector<LodLevel> levels;
+	if(levelCount == 0)
+		return levels;
+
+	LodLevel base;
+	base.Indices = indices;
+	levels.push_back(base);
+
+	while(levels.size() < levelCount)
+	{
+		const LodLevel& prev = levels.back();
+		std::size_t target = static_cast<std::size_t>(prev.Indices.size() / 3 * reduction);
+
+		float budget = maxError > 0.0f ? maxError - prev.Error : 0.0f;
+		if(maxError > 0.0f && budget <= 0.0f)
+			break;
+
+		LodLevel next = Simplify(prev.Indices, target, budget, threadCount);
+
+		// Stop when nothing more can be collapsed.
+		if(next.Indices.size() >= prev.Indices.size())
+			break;
+
+		next.Error += prev.Error;
+		levels.push_back(std::move(next));
+	}
+
+	return levels;
+}
+
+std::size_t MeshSimplifier::SelectLod(const std::vector<float>& errors, float radius, float screenRadius,
+	float pixelTolerance)
+{
+	if(radius <= 0.0f)
+		return 0;
+
+	for(std::size_t i = errors.size(); i-- > 1; )
+	{
+		if(errors[i] / radius * screenRadius <= pixelTolerance)
+			return i;
+	}
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+//***************************************************************************************
+// MeshSimplify.h
+//
+// Quadric error metric mesh simplification (Garland and Heckbert) by half-edge
+// collapse.  A vertex is always collapsed onto one of its neighbours, so every level
+// of detail references a subset of the original vertices and only needs its own
+// index list; all levels can share one vertex buffer.
+//
+// The mesh is split into slabs along its longest axis that are simplified in
+// parallel.  Vertices on slab borders are locked during that pass and a final serial
+// pass over the whole mesh reaches the exact target.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct LodLevel
+{
+	std::vector<std::uint32_t> Indices;
+
+	// Estimated distance from the original surface, in model units (the square
+	// root of the largest quadric error, summed along the chain).
+	float Error = 0.0f;
+};
+
+class MeshSimplifier
+{
+public:
+	///<summary>
+	/// positions points to the x of the first vertex; vertices are positionStride bytes
+	/// apart.  The data must outlive the simplifier.
+	///</summary>
+	MeshSimplifier(const float* positions, std::size_t positionStride, std::size_t vertexCount);
+
+	///<summary>
+	/// Collapses edges of a triangle list until at most targetTriangleCount triangles
+	/// remain, or no collapse keeps the mesh valid and within maxError model units of
+	/// the input (0 for no limit).  threadCount 0 uses every hardware thread.
+	///</summary>
+	LodLevel Simplify(const std::vector<std::uint32_t>& indices, std::size_t targetTriangleCount,
+		float maxError = 0.0f, unsigned threadCount = 0)const;
+
+	///<summary>
+	/// Returns up to levelCount levels; level 0 is the input and each following level
+	/// has about reduction times the triangles of the previous one.  The chain ends
+	/// early when a level would exceed maxError (0 for no limit).
+	///</summary>
+	std::vector<LodLevel> BuildLodChain(const std::vector<std::uint32_t>& indices, std::size_t levelCount,
+		float reduction, float maxError = 0.0f, unsigned threadCount = 0)const;
+
+	///<summary>
+	/// Picks the coarsest level whose error (LodLevel::Error of each level), projected
+	/// to the screen, stays below pixelTolerance.  radius is the mesh bounding radius
+	/// in model units and screenRadius the same radius projected to pixels.
+	///</summary>
+	static std::size_t SelectLod(const std::vector<float>& errors, float radius, float screenRadius,
+		float pixelTolerance = 1.0f);
+
+private:
+	const float* Position(std::uint32_t v)const
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(mPositions) + v*mPositionStride);
+	}
+
+	const float* mPositions;
+	std::size_t mPositionStride;
+	std::size_t mVertexCount;
+
+	friend struct SimplifyState;
+};
@@ -0,0 +1,336 @@
+//***************************************************************************************
+// MeshTextParser.cpp
+//***************************************************************************************
+
+#include "MeshTextParser.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace
+{
+	// Smaller lists are parsed on the calling thread only.
+	const std::size_t MinChunkSize = 128*1024;
+
+	// Fewest bytes a list entry can take: one digit per value and a space, newline or
+	// the closing '}' after each.  A count larger than the rest of the file allows is
+	// rejected before anything is allocated for it.
+	const std::size_t MinBytesPerVertex = 6*2;
+	const std::size_t MinBytesPerTriangle = 3*2;
+
+	// Any control character or space separates numbers.
+	bool IsSpace(char c)
+	{
+		return (unsigned char)c <= ' ';
+	}
+
+	const char* SkipSpace(const char* p, const char* end)
+	{
+		while(p < end && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	///<summary>
+	/// std::from_chars with Clinger's fast path for plain decimals of up to 9 digits
+	/// whose digits form an integer no larger than 2^24: the integer and the power of
+	/// ten are exact floats, so one correctly rounded division gives the same result
+	/// as from_chars.  Exponents, longer numbers and anything else take from_chars.
+	///</summary>
+	std::from_chars_result ParseNumber(const char* p, const char* end, float& value)
+	{
+		static const float PowersOf10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f };
+
+		const char* q = p;
+		bool negative = q < end && *q == '-';
+		q += negative;
+
+		std::uint32_t mantissa = 0;
+		int digits = 0;
+		int fractionDigits = 0;
+		for(; q < end && (unsigned)(*q - '0') < 10 && digits < 9; ++q, ++digits)
+			mantissa = mantissa*10 + (*q - '0');
+
+		int integerDigits = digits;
+		if(q < end && *q == '.')
+		{
+			for(++q; q < end && (unsigned)(*q - '0') < 10 && digits < 9; ++q, ++digits)
+				mantissa = mantissa*10 + (*q - '0');
+		}
+		fractionDigits = digits - integerDigits;
+
+		if(digits == 0 || mantissa > (1u << 24) || (q < end && !IsSpace(*q)))
+			return std::from_chars(p, end, value);
+
+		value = (float)mantissa / PowersOf10[fractionDigits];
+		if(negative)
+			value = -value;
+
+		return { q, std::errc() };
+	}
+
+	std::from_chars_result ParseNumber(const char* p, const char* end, std::uint32_t& value)
+	{
+		return std::from_chars(p, end, value);
+	}
+
+	struct ParseError
+	{
+		const char* Position = nullptr;
+		std::string Message;
+	};
+
+	bool ExpectWord(const char*& p, const char* end, const char* word, ParseError& error)
+	{
+		p = SkipSpace(p, end);
+		std::size_t length = std::strlen(word);
+		if((std::size_t)(end - p) < length || std::memcmp(p, word, length) != 0)
+		{
+			error.Position = p;
+			error.Message = std::string("expected '") + word + "'";
+			return false;
+		}
+
+		p += length;
+		return true;
+	}
+
+	///<summary>
+	/// Reads a count of list entries of at least minBytes bytes each and checks that
+	/// they fit in what is left of the file.
+	///</summary>
+	bool ReadCount(const char*& p, const char* end, std::size_t minBytes, std::uint32_t& value, ParseError& error)
+	{
+		p = SkipSpace(p, end);
+		auto result = std::from_chars(p, end, value);
+		if(result.ec != std::errc())
+		{
+			error.Position = p;
+			error.Message = "expected a count";
+			return false;
+		}
+
+		if((std::uint64_t)value*minBytes > (std::uint64_t)(end - result.ptr))
+		{
+			error.Position = p;
+			error.Message = "count " + std::to_string(value) + " does not fit in the file";
+			return false;
+		}
+
+		p = result.ptr;
+		return true;
+	}
+
+	// Values of one line-aligned part of a list, and the first error found in it.  The
+	// first chunk is parsed straight into the output, the others into Values.
+	template<typename T>
+	struct Chunk
+	{
+		const char* Begin = nullptr;
+		const char* End = nullptr;
+
+		T* Out = nullptr;
+		std::size_t Capacity = 0;
+		std::size_t Count = 0;
+
+		std::vector<T> Values;
+		ParseError Error;
+	};
+
+	// Parses whitespace separated numbers; integers must be below limit.
+	template<typename T>
+	void ParseChunk(Chunk<T>& chunk, std::uint32_t limit)
+	{
+		const char* p = chunk.Begin;
+		const char* end = chunk.End;
+
+		// About 9 characters per value in the model files.
+		if(chunk.Out == nullptr)
+			chunk.Values.reserve((end - p)/8);
+
+		for(p = SkipSpace(p, end); p < end; p = SkipSpace(p, end))
+		{
+			T value;
+			auto result = ParseNumber(p, end, value);
+			if(result.ec != std::errc() || (result.ptr < end && !IsSpace(*result.ptr)))
+			{
+				chunk.Error.Position = p;
+				chunk.Error.Message = result.ec == std::errc::result_out_of_range ? "number out of range" : "malformed number";
+				return;
+			}
+
+			if constexpr(std::is_integral<T>::value)
+			{
+				if(value >= limit)
+				{
+					chunk.Error.Position = p;
+					chunk.Error.Message = "index " + std::to_string(value) + " is out of range";
+					return;
+				}
+			}
+
+			if(chunk.Out == nullptr)
+				chunk.Values.push_back(value);
+			else if(chunk.Count < chunk.Capacity)
+				chunk.Out[chunk.Count] = value;
+			else
+			{
+				chunk.Error.Position = p;
+				chunk.Error.Message = "expected " + std::to_string(chunk.Capacity) + " values";
+				return;
+			}
+
+			chunk.Count++;
+			p = result.ptr;
+		}
+	}
+
+	///<summary>
+	/// Parses the list between begin and the closing '}' into count values at out.
+	/// On success p is moved past the '}'.
+	///</summary>
+	template<typename T>
+	bool ParseList(const char*& p, const char* end, T* out, std::size_t count, std::uint32_t limit,
+		unsigned threadCount, ParseError& error)
+	{
+		const char* begin = p;
+		const char* close = static_cast<const char*>(std::memchr(begin, '}', end - begin));
+		if(close == nullptr)
+		{
+			error.Position = end;
+			error.Message = "expected '}'";
+			return false;
+		}
+
+		std::size_t size = close - begin;
+		std::size_t chunkCount = (std::min)((std::size_t)threadCount, (std::max)(size/MinChunkSize, (std::size_t)1));
+
+		// Split at the line breaks after evenly spaced offsets.
+		std::vector<Chunk<T>> chunks(chunkCount);
+		const char* chunkBegin = begin;
+		for(std::size_t i = 0; i < chunkCount; ++i)
+		{
+			const char* chunkEnd = close;
+			if(i + 1 < chunkCount)
+			{
+				chunkEnd = (std::max)(begin + size*(i + 1)/chunkCount, chunkBegin);
+				const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', close - chunkEnd));
+				chunkEnd = newline != nullptr ? newline + 1 : close;
+			}
+
+			chunks[i].Begin = chunkBegin;
+			chunks[i].End = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+
+		chunks[0].Out = out;
+		chunks[0].Capacity = count;
+
+		std::vector<std::thread> threads;
+		for(std::size_t i = 1; i < chunkCount; ++i)
+			threads.emplace_back(ParseChunk<T>, std::ref(chunks[i]), limit);
+		ParseChunk(chunks[0], limit);
+		for(std::thread& t : threads)
+			t.join();
+
+		std::size_t parsed = 0;
+		for(const Chunk<T>& chunk : chunks)
+		{
+			if(chunk.Error.Position != nullptr)
+			{
+				error = chunk.Error;
+				return false;
+			}
+			parsed += chunk.Count;
+		}
+
+		if(parsed != count)
+		{
+			error.Position = parsed < count ? close : begin;
+			error.Message = "expected " + std::to_string(count) + " values, found " + std::to_string(parsed);
+			return false;
+		}
+
+		out += chunks[0].Count;
+		for(std::size_t i = 1; i < chunkCount; ++i)
+		{
+			std::memcpy(out, chunks[i].Values.data(), chunks[i].Count*sizeof(T));
+			out += chunks[i].Count;
+		}
+
+		p = close + 1;
+		return true;
+	}
+}
+
+bool MeshTextParser::Parse(const char* text, std::size_t size, const std::string& name, TextMesh& mesh,
+	std::string& error, unsigned threadCount)
+{
+	if(threadCount == 0)
+		threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+
+	const char* p = text;
+	const char* end = text + size;
+
+	std::uint32_t vcount = 0;
+	std::uint32_t tcount = 0;
+	ParseError e;
+
+	bool ok =
+		ExpectWord(p, end, "VertexCount:", e) && ReadCount(p, end, MinBytesPerVertex, vcount, e) &&
+		ExpectWord(p, end, "TriangleCount:", e) && ReadCount(p, end, MinBytesPerTriangle, tcount, e) &&
+		ExpectWord(p, end, "VertexList", e);
+
+	if(ok)
+	{
+		// Skip the "(pos, normal)" description.
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		p = newline != nullptr ? newline : end;
+
+		// Both lists together must fit as well; each count was only checked on its own.
+		if((std::uint64_t)vcount*MinBytesPerVertex + (std::uint64_t)tcount*MinBytesPerTriangle > (std::uint64_t)(end - p))
+		{
+			ok = false;
+			e.Position = p;
+			e.Message = "vertex and triangle counts do not fit in the file";
+		}
+	}
+
+	if(ok)
+	{
+		mesh.Vertices.resize(vcount);
+		mesh.Indices.resize((std::size_t)tcount*3);
+
+		static_assert(sizeof(TextMeshVertex) == 6*sizeof(float), "TextMeshVertex must be 6 packed floats.");
+
+		ok = ExpectWord(p, end, "{", e) &&
+			ParseList(p, end, reinterpret_cast<float*>(mesh.Vertices.data()), (std::size_t)vcount*6, 0, threadCount, e) &&
+			ExpectWord(p, end, "TriangleList", e) && ExpectWord(p, end, "{", e) &&
+			ParseList(p, end, mesh.Indices.data(), mesh.Indices.size(), vcount, threadCount, e);
+	}
+
+	if(!ok)
+	{
+		std::size_t line = 1 + std::count(text, e.Position, '\n');
+		error = name + ":" + std::to_string(line) + ": " + e.Message + ".";
+		mesh.Vertices.clear();
+		mesh.Indices.clear();
+	}
+
+	return ok;
+}
+
+bool MeshTextParser::Load(const std::string& path, TextMesh& mesh, std::string& error, unsigned threadCount)
+{
+	MappedFile file;
+	if(!file.Open(path))
+	{
+		error = path + ": cannot open file.";
+		return false;
+	}
+
+	return Parse(reinterpret_cast<const char*>(file.Data()), file.Size(), path, mesh, error, threadCount);
+}
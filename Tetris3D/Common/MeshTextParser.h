@@ -0,0 +1,53 @@
+//***************************************************************************************
+// MeshTextParser.h
+//
+// Parser for the VertexList/TriangleList text mesh format:
+//
+//   VertexCount: n
+//   TriangleCount: m
+//   VertexList (pos, normal)
+//   {
+//   	px py pz nx ny nz        (n lines)
+//   }
+//   TriangleList
+//   {
+//   	i0 i1 i2                 (m lines)
+//   }
+//
+// The file is mapped and numbers are converted with std::from_chars.  Large lists are
+// split into line-aligned chunks that are parsed in parallel.  Malformed input is
+// reported with the line of the problem instead of being read as zeros, and counts
+// the rest of the file is too short to hold are rejected before the lists are
+// allocated.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct TextMeshVertex
+{
+	float Position[3];
+	float Normal[3];
+};
+
+struct TextMesh
+{
+	std::vector<TextMeshVertex> Vertices;
+	std::vector<std::uint32_t> Indices;
+};
+
+namespace MeshTextParser
+{
+	///<summary>
+	/// Parses size bytes of mesh text.  On failure returns false and sets error to
+	/// "name:line: message".  threadCount 0 uses every hardware thread.
+	///</summary>
+	bool Parse(const char* text, std::size_t size, const std::string& name, TextMesh& mesh,
+		std::string& error, unsigned threadCount = 0);
+
+	bool Load(const std::string& path, TextMesh& mesh, std::string& error, unsigned threadCount = 0);
+}
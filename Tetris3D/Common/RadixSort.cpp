@@ -0,0 +1,60 @@
+//***************************************************************************************
+// RadixSort.cpp
+//***************************************************************************************
+
+#include "RadixSort.h"
+#include <cstring>
+#include <utility>
+
+void RadixSort(SortKeyEntry* entries, SortKeyEntry* scratch, std::size_t count)
+{
+	const int RadixBits = 8;
+	const int PassCount = 64 / RadixBits;
+	const int BucketCount = 1 << RadixBits;
+
+	if(count < 2)
+		return;
+
+	// Build the histograms of every pass in one read of the keys.
+	std::size_t histograms[PassCount][BucketCount];
+	std::memset(histograms, 0, sizeof(histograms));
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		std::uint64_t key = entries[i].Key;
+		for(int pass = 0; pass < PassCount; ++pass)
+			histograms[pass][(key >> (pass*RadixBits)) & (BucketCount - 1)]++;
+	}
+
+	SortKeyEntry* src = entries;
+	SortKeyEntry* dst = scratch;
+
+	for(int pass = 0; pass < PassCount; ++pass)
+	{
+		std::size_t* histogram = histograms[pass];
+		int shift = pass*RadixBits;
+
+		// Every key has the same byte here; this pass would not move anything.
+		if(histogram[(src[0].Key >> shift) & (BucketCount - 1)] == count)
+			continue;
+
+		std::size_t offset = 0;
+		for(int b = 0; b < BucketCount; ++b)
+		{
+			std::size_t n = histogram[b];
+			histogram[b] = offset;
+			offset += n;
+		}
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			std::size_t bucket = (src[i].Key >> shift) & (BucketCount - 1);
+			dst[histogram[bucket]++] = src[i];
+		}
+
+		std::swap(src, dst);
+	}
+
+	if(src != entries)
+		std::memcpy(entries, src, count*sizeof(SortKeyEntry));
+}
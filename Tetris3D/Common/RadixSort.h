@@ -0,0 +1,24 @@
+//***************************************************************************************
+// RadixSort.h
+//
+// LSD radix sort of 64-bit keys carrying a 32-bit payload (usually the index of the
+// element the key was made for).  The sort is stable and runs in linear time; passes
+// over bytes that are equal in every key are skipped.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+struct SortKeyEntry
+{
+	std::uint64_t Key;
+	std::uint32_t Value;
+};
+
+///<summary>
+/// Sorts entries[0..count) by Key.  scratch must hold count entries.  The result
+/// is left in entries.
+///</summary>
+void RadixSort(SortKeyEntry* entries, SortKeyEntry* scratch, std::size_t count);
@@ -0,0 +1,257 @@
+//***************************************************************************************
+// RenderCommandStream.cpp
+//***************************************************************************************
+
+#include "RenderCommandStream.h"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+void RenderCommandStream::Clear()
+{
+	mWords.clear();
+	mBindCount = 0;
+	mDrawCount = 0;
+	mElidedBindCount = 0;
+}
+
+void RenderCommandStream::Replay(RenderBackend& backend)const
+{
+	const std::uint32_t* w = mWords.data();
+	const std::uint32_t* end = w + mWords.size();
+
+	while(w < end)
+	{
+		switch(static_cast<RenderCommand>(w[0]))
+		{
+		case RenderCommand::SetPipelineState:
+			backend.SetPipelineState(w[1]);
+			w += 2;
+			break;
+		case RenderCommand::SetGeometry:
+			backend.SetGeometry(w[1]);
+			w += 2;
+			break;
+		case RenderCommand::SetPrimitiveTopology:
+			backend.SetPrimitiveTopology(w[1]);
+			w += 2;
+			break;
+		case RenderCommand::SetMeshConstants:
+			backend.SetMeshConstants(w[1]);
+			w += 2;
+			break;
+		case RenderCommand::SetObjectConstants:
+			backend.SetObjectConstants(w[1]);
+			w += 2;
+			break;
+		case RenderCommand::SetInstanceRange:
+			backend.SetInstanceRange(w[1]);
+			w += 2;
+			break;
+		case RenderCommand::DrawIndexedInstanced:
+			backend.DrawIndexedInstanced(w[1], w[2], w[3], static_cast<std::int32_t>(w[4]));
+			w += 5;
+			break;
+		default:
+			assert(false && "Corrupt render command stream.");
+			return;
+		}
+	}
+}
+
+RenderCommandEncoder::RenderCommandEncoder(RenderCommandStream& stream)
+	: mStream(stream)
+{
+	Invalidate();
+}
+
+void RenderCommandEncoder::Invalidate()
+{
+	std::fill(std::begin(mState), std::end(mState), DrawPacket::Unused);
+}
+
+void RenderCommandEncoder::Bind(RenderCommand cmd, std::uint32_t value)
+{
+	std::uint32_t& bound = mState[static_cast<int>(cmd)];
+	if(bound == value)
+	{
+		mStream.mElidedBindCount++;
+		return;
+	}
+
+	bound = value;
+	mStream.mWords.push_back(static_cast<std::uint32_t>(cmd));
+	mStream.mWords.push_back(value);
+	mStream.mBindCount++;
+}
+
+void RenderCommandEncoder::SetPipelineState(std::uint32_t pso)
+{
+	Bind(RenderCommand::SetPipelineState, pso);
+}
+
+void RenderCommandEncoder::SetGeometry(std::uint32_t geometry)
+{
+	Bind(RenderCommand::SetGeometry, geometry);
+}
+
+void RenderCommandEncoder::SetPrimitiveTopology(std::uint32_t topology)
+{
+	Bind(RenderCommand::SetPrimitiveTopology, topology);
+}
+
+void RenderCommandEncoder::SetMeshConstants(std::uint32_t mesh)
+{
+	Bind(RenderCommand::SetMeshConstants, mesh);
+}
+
+void RenderCommandEncoder::SetObjectConstants(std::uint32_t slot)
+{
+	Bind(RenderCommand::SetObjectConstants, slot);
+}
+
+void RenderCommandEncoder::SetInstanceRange(std::uint32_t firstInstance)
+{
+	Bind(RenderCommand::SetInstanceRange, firstInstance);
+}
+
+void RenderCommandEncoder::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+	std::uint32_t startIndexLocation, std::int32_t baseVertexLocation)
+{
+	std::vector<std::uint32_t>& words = mStream.mWords;
+	words.push_back(static_cast<std::uint32_t>(RenderCommand::DrawIndexedInstanced));
+	words.push_back(indexCount);
+	words.push_back(instanceCount);
+	words.push_back(startIndexLocation);
+	words.push_back(static_cast<std::uint32_t>(baseVertexLocation));
+	mStream.mDrawCount++;
+}
+
+void RenderQueue::Clear()
+{
+	mPackets.clear();
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	mPackets.push_back(packet);
+	mPackets.back().SortKey = DrawKey::Make(packet.Layer, packet.PipelineState, packet.Topology,
+		packet.Geometry, packet.Mesh, packet.Material, packet.Depth);
+}
+
+void RenderQueue::Sort()
+{
+	std::size_t count = mPackets.size();
+
+	mSortEntries.resize(count);
+	mSortScratch.resize(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		mSortEntries[i].Key = mPackets[i].SortKey;
+		mSortEntries[i].Value = static_cast<std::uint32_t>(i);
+	}
+
+	RadixSort(mSortEntries.data(), mSortScratch.data(), count);
+
+	mSortedPackets.resize(count);
+	for(std::size_t i = 0; i < count; ++i)
+		mSortedPackets[i] = mPackets[mSortEntries[i].Value];
+
+	mPackets.swap(mSortedPackets);
+}
+
+void RenderQueue::Encode(RenderCommandStream& stream)const
+{
+	RenderCommandEncoder encoder(stream);
+
+	for(const DrawPacket& p : mPackets)
+	{
+		encoder.SetPipelineState(p.PipelineState);
+		encoder.SetGeometry(p.Geometry);
+		encoder.SetPrimitiveTopology(p.Topology);
+		encoder.SetMeshConstants(p.Mesh);
+
+		if(p.ObjectConstants != DrawPacket::Unused)
+			encoder.SetObjectConstants(p.ObjectConstants);
+		if(p.FirstInstance != DrawPacket::Unused)
+			encoder.SetInstanceRange(p.FirstInstance);
+
+		encoder.DrawIndexedInstanced(p.IndexCount, p.InstanceCount, p.StartIndexLocation, p.BaseVertexLocation);
+	}
+}
+
+std::uint64_t DrawKey::Make(std::uint32_t layer, std::uint32_t pso, std::uint32_t topology,
+	std::uint32_t geometry, std::uint32_t mesh, std::uint32_t material, std::uint32_t depth)
+{
+	assert(layer < (1u << LayerBits) && pso < (1u << PipelineStateBits) && topology < (1u << TopologyBits));
+	assert(geometry < (1u << GeometryBits) && mesh < (1u << MeshBits) && material < (1u << MaterialBits));
+	assert(depth < (1u << DepthBits));
+
+	std::uint64_t key = layer;
+	key = (key << PipelineStateBits) | pso;
+	key = (key << TopologyBits) | topology;
+	key = (key << GeometryBits) | geometry;
+	key = (key << MeshBits) | mesh;
+	key = (key << MaterialBits) | material;
+	key = (key << DepthBits) | depth;
+
+	return key;
+}
+
+std::uint32_t DrawKey::QuantizeDepth(float viewZ, float nearZ, float farZ)
+{
+	const std::uint32_t maxDepth = (1u << DepthBits) - 1;
+
+	float t = (viewZ - nearZ) / (farZ - nearZ);
+	t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+	return static_cast<std::uint32_t>(t*maxDepth);
+}
+
+void RecordingBackend::Record(RenderCommand cmd, std::uint32_t a0, std::uint32_t a1, std::uint32_t a2, std::uint32_t a3)
+{
+	Call c;
+	c.Command = cmd;
+	c.Args[0] = a0;
+	c.Args[1] = a1;
+	c.Args[2] = a2;
+	c.Args[3] = a3;
+	mCalls.push_back(c);
+}
+
+void RecordingBackend::SetPipelineState(std::uint32_t pso)
+{
+	Record(RenderCommand::SetPipelineState, pso);
+}
+
+void RecordingBackend::SetGeometry(std::uint32_t geometry)
+{
+	Record(RenderCommand::SetGeometry, geometry);
+}
+
+void RecordingBackend::SetPrimitiveTopology(std::uint32_t topology)
+{
+	Record(RenderCommand::SetPrimitiveTopology, topology);
+}
+
+void RecordingBackend::SetMeshConstants(std::uint32_t mesh)
+{
+	Record(RenderCommand::SetMeshConstants, mesh);
+}
+
+void RecordingBackend::SetObjectConstants(std::uint32_t slot)
+{
+	Record(RenderCommand::SetObjectConstants, slot);
+}
+
+void RecordingBackend::SetInstanceRange(std::uint32_t firstInstance)
+{
+	Record(RenderCommand::SetInstanceRange, firstInstance);
+}
+
+void RecordingBackend::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+	std::uint32_t startIndexLocation, std::int32_t baseVertexLocation)
+{
+	Record(RenderCommand::DrawIndexedInstanced, indexCount, instanceCount, startIndexLocation,
+		static_cast<std::uint32_t>(baseVertexLocation));
+}
@@ -0,0 +1,206 @@
+//***************************************************************************************
+// RenderCommandStream.h
+//
+// A compact, API-independent stream of draw commands.  Draws are submitted to a
+// RenderQueue as DrawPackets, radix sorted by their DrawKey and encoded into a
+// RenderCommandStream by a state-tracking encoder that drops redundant binds.  The
+// stream is then replayed on a RenderBackend (Direct3D 12, or the RecordingBackend
+// for tests and measurements).
+//
+// Handles are small integers whose meaning is defined by the backend, e.g. indices
+// into its table of pipeline states.  This file has no Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "RadixSort.h"
+
+enum class RenderCommand : std::uint32_t
+{
+	SetPipelineState = 0,
+	SetGeometry,
+	SetPrimitiveTopology,
+	SetMeshConstants,
+	SetObjectConstants,
+	SetInstanceRange,
+	DrawIndexedInstanced,
+
+	BindCount = DrawIndexedInstanced
+};
+
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual void SetPipelineState(std::uint32_t pso) = 0;
+	virtual void SetGeometry(std::uint32_t geometry) = 0;
+	virtual void SetPrimitiveTopology(std::uint32_t topology) = 0;
+	virtual void SetMeshConstants(std::uint32_t mesh) = 0;
+	virtual void SetObjectConstants(std::uint32_t slot) = 0;
+	virtual void SetInstanceRange(std::uint32_t firstInstance) = 0;
+	virtual void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+		std::uint32_t startIndexLocation, std::int32_t baseVertexLocation) = 0;
+};
+
+///<summary>
+/// Command words: one word holding the RenderCommand followed by its arguments
+/// (one for binds, four for draws).
+///</summary>
+class RenderCommandStream
+{
+public:
+	void Clear();
+	void Replay(RenderBackend& backend)const;
+
+	const std::vector<std::uint32_t>& Words()const { return mWords; }
+
+	std::uint32_t BindCount()const { return mBindCount; }
+	std::uint32_t DrawCount()const { return mDrawCount; }
+	std::uint32_t ElidedBindCount()const { return mElidedBindCount; }
+
+private:
+	friend class RenderCommandEncoder;
+
+	std::vector<std::uint32_t> mWords;
+	std::uint32_t mBindCount = 0;
+	std::uint32_t mDrawCount = 0;
+	std::uint32_t mElidedBindCount = 0;
+};
+
+///<summary>
+/// Appends commands to a stream, dropping binds of the state that is already bound.
+/// The encoder starts with nothing bound.
+///</summary>
+class RenderCommandEncoder
+{
+public:
+	explicit RenderCommandEncoder(RenderCommandStream& stream);
+
+	void SetPipelineState(std::uint32_t pso);
+	void SetGeometry(std::uint32_t geometry);
+	void SetPrimitiveTopology(std::uint32_t topology);
+	void SetMeshConstants(std::uint32_t mesh);
+	void SetObjectConstants(std::uint32_t slot);
+	void SetInstanceRange(std::uint32_t firstInstance);
+	void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+		std::uint32_t startIndexLocation, std::int32_t baseVertexLocation);
+
+	// Forget the tracked state, e.g. after the command list was used directly.
+	void Invalidate();
+
+private:
+	void Bind(RenderCommand cmd, std::uint32_t value);
+
+	RenderCommandStream& mStream;
+	std::uint32_t mState[(int)RenderCommand::BindCount];
+};
+
+///<summary>
+/// 64-bit draw sort key, most significant field first:
+///   layer:4 | pipeline state:8 | topology:4 | geometry:8 | mesh:12 | material:10 | depth:18
+/// Sorting by it groups draws by state in order of bind cost and draws each group
+/// front to back.
+///</summary>
+struct DrawKey
+{
+	static const int LayerBits = 4;
+	static const int PipelineStateBits = 8;
+	static const int TopologyBits = 4;
+	static const int GeometryBits = 8;
+	static const int MeshBits = 12;
+	static const int MaterialBits = 10;
+	static const int DepthBits = 18;
+
+	static std::uint64_t Make(std::uint32_t layer, std::uint32_t pso, std::uint32_t topology,
+		std::uint32_t geometry, std::uint32_t mesh, std::uint32_t material, std::uint32_t depth);
+
+	// Maps a view space depth in [nearZ, farZ] to DepthBits bits, nearer is smaller.
+	static std::uint32_t QuantizeDepth(float viewZ, float nearZ, float farZ);
+};
+
+struct DrawPacket
+{
+	static const std::uint32_t Unused = 0xffffffff;
+
+	std::uint64_t SortKey = 0;
+
+	std::uint32_t PipelineState = 0;
+	std::uint32_t Geometry = 0;
+	std::uint32_t Topology = 0;
+	std::uint32_t Material = 0;
+
+	// Render layer and quantized depth (DrawKey::QuantizeDepth) only order the draws.
+	// Mesh also selects the per-submesh constants, e.g. the vertex dequantization.
+	std::uint32_t Layer = 0;
+	std::uint32_t Mesh = 0;
+	std::uint32_t Depth = 0;
+
+	// Per-draw bindings; Unused ones are not bound.
+	std::uint32_t ObjectConstants = Unused;
+	std::uint32_t FirstInstance = Unused;
+
+	std::uint32_t IndexCount = 0;
+	std::uint32_t InstanceCount = 1;
+	std::uint32_t StartIndexLocation = 0;
+	std::int32_t BaseVertexLocation = 0;
+};
+
+///<summary>
+/// Collects the draw packets of a frame, orders them by state and encodes them.
+///</summary>
+class RenderQueue
+{
+public:
+	void Clear();
+
+	// Adds a packet; its SortKey is computed from its state.
+	void Submit(const DrawPacket& packet);
+
+	// Reorders the packets by SortKey.  Packets with equal keys keep their order.
+	void Sort();
+	void Encode(RenderCommandStream& stream)const;
+
+	const std::vector<DrawPacket>& Packets()const { return mPackets; }
+
+private:
+	std::vector<DrawPacket> mPackets;
+
+	// Reused between frames to avoid allocating while sorting.
+	std::vector<SortKeyEntry> mSortEntries;
+	std::vector<SortKeyEntry> mSortScratch;
+	std::vector<DrawPacket> mSortedPackets;
+};
+
+///<summary>
+/// Backend that records what it is asked to do.  Used to test and measure the
+/// encoding without a GPU.
+///</summary>
+class RecordingBackend : public RenderBackend
+{
+public:
+	struct Call
+	{
+		RenderCommand Command;
+		std::uint32_t Args[4];
+	};
+
+	void Clear() { mCalls.clear(); }
+	const std::vector<Call>& Calls()const { return mCalls; }
+
+	virtual void SetPipelineState(std::uint32_t pso)override;
+	virtual void SetGeometry(std::uint32_t geometry)override;
+	virtual void SetPrimitiveTopology(std::uint32_t topology)override;
+	virtual void SetMeshConstants(std::uint32_t mesh)override;
+	virtual void SetObjectConstants(std::uint32_t slot)override;
+	virtual void SetInstanceRange(std::uint32_t firstInstance)override;
+	virtual void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount,
+		std::uint32_t startIndexLocation, std::int32_t baseVertexLocation)override;
+
+private:
+	void Record(RenderCommand cmd, std::uint32_t a0, std::uint32_t a1 = 0, std::uint32_t a2 = 0, std::uint32_t a3 = 0);
+
+	std::vector<Call> mCalls;
+};
@@ -0,0 +1,59 @@
+//***************************************************************************************
+// RingAllocator.cpp
+//***************************************************************************************
+
+#include "RingAllocator.h"
+#include <cassert>
+
+RingAllocator::RingAllocator(std::uint64_t capacity)
+	: mCapacity(capacity)
+{
+	assert(capacity > 0);
+}
+
+std::uint64_t RingAllocator::Allocate(std::uint64_t size, std::uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	assert(mCapacity % alignment == 0);
+
+	if(size > mCapacity)
+		return InvalidOffset;
+
+	std::uint64_t start = (mHead + alignment - 1) & ~(alignment - 1);
+	std::uint64_t offset = start % mCapacity;
+	if(offset + size > mCapacity)
+	{
+		start += mCapacity - offset;
+		offset = 0;
+	}
+
+	if(start + size - mTail > mCapacity)
+		return InvalidOffset;
+
+	mHead = start + size;
+	return offset;
+}
+
+void RingAllocator::FinishFrame(std::uint64_t fence)
+{
+	assert(mFrames.empty() || mFrames.back().Fence < fence);
+
+	Frame frame;
+	frame.Fence = fence;
+	frame.End = mHead;
+	mFrames.push_back(frame);
+}
+
+void RingAllocator::Reclaim(std::uint64_t completedFence)
+{
+	while(!mFrames.empty() && mFrames.front().Fence <= completedFence)
+	{
+		mTail = mFrames.front().End;
+		mFrames.pop_front();
+	}
+
+	// Nothing is live: start over at offset 0 so a large chunk does not have to skip
+	// the end of the buffer.
+	if(mFrames.empty() && mTail == mHead)
+		mHead = mTail = 0;
+}
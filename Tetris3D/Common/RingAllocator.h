@@ -0,0 +1,57 @@
+//***************************************************************************************
+// RingAllocator.h
+//
+// Hands out aligned chunks of a fixed-size buffer with a bump pointer that wraps around
+// to the start.  Allocations are grouped by frame: FinishFrame tags everything allocated
+// since the previous call with the fence value signaled after the frame, and Reclaim
+// frees the frames whose fence has completed, oldest first.  Only offsets are managed,
+// so the buffer can be any memory, e.g. a mapped upload heap.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+class RingAllocator
+{
+public:
+	static const std::uint64_t InvalidOffset = ~0ull;
+
+	// capacity must be a multiple of every alignment that is requested.
+	explicit RingAllocator(std::uint64_t capacity);
+
+	///<summary>
+	/// Returns the offset of size bytes aligned to alignment (a power of two), or
+	/// InvalidOffset when the frames still in flight leave no room.  A chunk never
+	/// wraps: when it does not fit before the end, the rest of the buffer is skipped
+	/// and the chunk starts at offset 0.
+	///</summary>
+	std::uint64_t Allocate(std::uint64_t size, std::uint64_t alignment);
+
+	// Tags the allocations since the previous call with fence.  Fences must increase.
+	void FinishFrame(std::uint64_t fence);
+
+	// Frees the allocations of every finished frame whose fence is <= completedFence.
+	void Reclaim(std::uint64_t completedFence);
+
+	std::uint64_t Capacity()const { return mCapacity; }
+
+	// Bytes from the oldest live allocation to the bump pointer, skipped ends included.
+	std::uint64_t UsedBytes()const { return mHead - mTail; }
+
+private:
+	struct Frame
+	{
+		std::uint64_t Fence;
+		std::uint64_t End;
+	};
+
+	std::uint64_t mCapacity;
+
+	// Positions only grow; the offset in the buffer is the position modulo capacity.
+	std::uint64_t mHead = 0;
+	std::uint64_t mTail = 0;
+
+	std::deque<Frame> mFrames;
+};
@@ -0,0 +1,110 @@
+//***************************************************************************************
+// StagingUploader.cpp
+//***************************************************************************************
+
+#include "StagingUploader.h"
+#include "WriteCombined.h"
+
+namespace
+{
+	// Staging chunks start on a 16-byte boundary for the streaming stores.
+	const UINT64 StagingAlignment = 16;
+
+	ID3D12Resource* ToResource(UploadBatch::Destination dst)
+	{
+		return const_cast<ID3D12Resource*>(static_cast<const ID3D12Resource*>(dst));
+	}
+}
+
+StagingUploader::StagingUploader(ID3D12Device* device, UINT64 capacity)
+	: mDevice(device), mCapacity(capacity)
+{
+}
+
+BYTE* StagingUploader::Stage(ID3D12Resource* dst, UINT64 dstOffset, UINT64 size,
+	D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	if(mRing == nullptr)
+		mRing = std::make_unique<UploadRing>(mDevice, mCapacity);
+
+	UploadRing::Allocation chunk = mRing->Allocate(size, StagingAlignment);
+	mBatch.Add(dst, dstOffset, chunk.Offset, size, (std::uint32_t)before, (std::uint32_t)after);
+	mBatchBytes += size;
+	return chunk.CpuAddress;
+}
+
+void StagingUploader::Upload(ID3D12Resource* dst, UINT64 dstOffset, const void* data, UINT64 size,
+	D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	BYTE* staging = Stage(dst, dstOffset, size, before, after);
+	WriteCombined::Write(staging, data, (std::size_t)size);
+}
+
+void StagingUploader::Record(ID3D12GraphicsCommandList* cmdList)
+{
+	mLastBatch = BatchStats();
+	if(mBatch.Empty())
+		return;
+
+	mBatch.Build();
+	const auto& transitions = mBatch.Transitions();
+
+	mBarriers.clear();
+	for(const UploadBatch::Transition& t : transitions)
+	{
+		if(t.Before != D3D12_RESOURCE_STATE_COPY_DEST)
+		{
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(ToResource(t.Dst),
+				(D3D12_RESOURCE_STATES)t.Before, D3D12_RESOURCE_STATE_COPY_DEST));
+		}
+	}
+	if(!mBarriers.empty())
+		cmdList->ResourceBarrier((UINT)mBarriers.size(), mBarriers.data());
+	mLastBatch.Barriers += (UINT)mBarriers.size();
+
+	for(const UploadBatch::Copy& copy : mBatch.Copies())
+		cmdList->CopyBufferRegion(ToResource(copy.Dst), copy.DstOffset, mRing->Resource(), copy.SrcOffset, copy.Size);
+
+	mBarriers.clear();
+	for(const UploadBatch::Transition& t : transitions)
+	{
+		if(t.After != D3D12_RESOURCE_STATE_COPY_DEST)
+		{
+			mBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(ToResource(t.Dst),
+				D3D12_RESOURCE_STATE_COPY_DEST, (D3D12_RESOURCE_STATES)t.After));
+		}
+	}
+	if(!mBarriers.empty())
+		cmdList->ResourceBarrier((UINT)mBarriers.size(), mBarriers.data());
+	mLastBatch.Barriers += (UINT)mBarriers.size();
+
+	mLastBatch.Uploads = (UINT)mBatch.AddedCount();
+	mLastBatch.Copies = (UINT)mBatch.Copies().size();
+	mLastBatch.Bytes = mBatchBytes;
+
+	mBatch.Clear();
+	mBatchBytes = 0;
+}
+
+void StagingUploader::FinishFrame(UINT64 fence)
+{
+	if(mRing != nullptr)
+		mRing->FinishFrame(fence);
+}
+
+void StagingUploader::Reclaim(UINT64 completedFence)
+{
+	if(mRing == nullptr)
+		return;
+
+	mRing->Reclaim(completedFence);
+
+	// Every copy out of the heap has executed.
+	if(mRing->UsedBytes() == 0 && mBatch.Empty())
+		mRing = nullptr;
+}
+
+UINT64 StagingUploader::ResidentBytes()const
+{
+	return mRing != nullptr ? d3dUtil::CommittedBytes(mRing->Resource()) : 0;
+}
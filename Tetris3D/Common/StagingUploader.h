@@ -0,0 +1,76 @@
+//***************************************************************************************
+// StagingUploader.h
+//
+// Uploads buffer data through one persistent staging heap instead of a committed
+// upload resource per buffer.  Stage sub-allocates staging memory from an UploadRing
+// and adds the copy to an UploadBatch; Record then issues all the staged uploads as
+// one batch, with one merged barrier before and after the copies.  Staging memory
+// is reused once the fence signaled after the batch completes: the owner calls
+// FinishFrame and Reclaim as for the UploadRing.  Uploads are mostly done at load
+// time, so the staging heap is only created by the first Stage and is released
+// again by the Reclaim that finds every staged upload complete.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "UploadBatch.h"
+#include "UploadRing.h"
+
+class StagingUploader
+{
+public:
+	// Commands of the last recorded batch.
+	struct BatchStats
+	{
+		UINT Uploads = 0;
+		UINT Copies = 0;
+		UINT Barriers = 0;
+		UINT64 Bytes = 0;
+	};
+
+	// device must outlive the uploader.
+	StagingUploader(ID3D12Device* device, UINT64 capacity);
+	StagingUploader(const StagingUploader& rhs) = delete;
+	StagingUploader& operator=(const StagingUploader& rhs) = delete;
+
+	///<summary>
+	/// Returns size bytes of staging memory for the data of dst at dstOffset, to be
+	/// written (never read) before Record.  dst is in state before until the batch
+	/// executes and in state after once it has.  Throws when the frames in flight
+	/// leave no room in the staging heap.
+	///</summary>
+	BYTE* Stage(ID3D12Resource* dst, UINT64 dstOffset, UINT64 size,
+		D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+
+	// Stages a copy of size bytes of data.
+	void Upload(ID3D12Resource* dst, UINT64 dstOffset, const void* data, UINT64 size,
+		D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+
+	// Records the uploads staged since the last call on cmdList and starts a new batch.
+	void Record(ID3D12GraphicsCommandList* cmdList);
+
+	void FinishFrame(UINT64 fence);
+
+	// Reuses the staging memory of the batches that completed, and releases the
+	// staging heap once nothing staged is pending.
+	void Reclaim(UINT64 completedFence);
+
+	UINT64 Capacity()const { return mCapacity; }
+	UINT64 UsedBytes()const { return mRing != nullptr ? mRing->UsedBytes() : 0; }
+
+	// Memory taken by the staging heap, 0 while it is released.
+	UINT64 ResidentBytes()const;
+	const BatchStats& LastBatch()const { return mLastBatch; }
+
+private:
+	ID3D12Device* mDevice;
+	std::unique_ptr<UploadRing> mRing;
+	UINT64 mCapacity;
+
+	UploadBatch mBatch;
+	UINT64 mBatchBytes = 0;
+	BatchStats mLastBatch;
+
+	std::vector<D3D12_RESOURCE_BARRIER> mBarriers;
+};
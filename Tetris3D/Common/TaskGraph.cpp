@@ -0,0 +1,156 @@
+//***************************************************************************************
+// TaskGraph.cpp
+//***************************************************************************************
+
+#include "TaskGraph.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+TaskGraph::TaskId TaskGraph::Add(const std::string& name, std::function<void()> work, const std::vector<TaskId>& dependencies)
+{
+	TaskId id = (TaskId)mTasks.size();
+
+	Task task;
+	task.Work = std::move(work);
+	task.DependencyCount = (std::uint32_t)dependencies.size();
+	mTasks.push_back(std::move(task));
+
+	for(TaskId dependency : dependencies)
+	{
+		assert(dependency < id && "A task can only depend on tasks added before it.");
+		mTasks[dependency].Dependents.push_back(id);
+	}
+
+	TimelineEntry entry;
+	entry.Name = name;
+	mTimeline.push_back(entry);
+
+	return id;
+}
+
+void TaskGraph::Run(unsigned threadCount)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	if(threadCount == 0)
+		threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+
+	std::mutex mutex;
+	std::condition_variable wake;
+
+	std::vector<std::uint32_t> pending(mTasks.size());
+	// Tasks start in the order they were added and became ready.
+	std::deque<TaskId> ready;
+	for(TaskId id = 0; id < (TaskId)mTasks.size(); ++id)
+	{
+		pending[id] = mTasks[id].DependencyCount;
+		if(pending[id] == 0)
+			ready.push_back(id);
+	}
+
+	std::size_t finished = 0;
+	std::size_t running = 0;
+	std::exception_ptr failure;
+
+	const Clock::time_point start = Clock::now();
+	auto elapsedMs = [start]()
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+
+	auto worker = [&](unsigned thread)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for(;;)
+		{
+			wake.wait(lock, [&]()
+			{
+				return !ready.empty() || finished == mTasks.size() || (failure && running == 0);
+			});
+
+			if(ready.empty() || failure)
+				return;
+
+			TaskId id = ready.front();
+			ready.pop_front();
+			running++;
+			lock.unlock();
+
+			TimelineEntry& entry = mTimeline[id];
+			entry.Thread = thread;
+			entry.StartMs = elapsedMs();
+
+			std::exception_ptr error;
+			try
+			{
+				if(mTasks[id].Work)
+					mTasks[id].Work();
+			}
+			catch(...)
+			{
+				error = std::current_exception();
+			}
+
+			entry.EndMs = elapsedMs();
+
+			lock.lock();
+			running--;
+			finished++;
+			if(error && !failure)
+				failure = error;
+
+			for(TaskId dependent : mTasks[id].Dependents)
+			{
+				if(--pending[dependent] == 0)
+					ready.push_back(dependent);
+			}
+
+			wake.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker, i);
+	worker(0);
+	for(std::thread& t : threads)
+		t.join();
+
+	mTotalMs = elapsedMs();
+
+	if(failure)
+		std::rethrow_exception(failure);
+}
+
+std::string TaskGraph::TimelineText()const
+{
+	std::vector<const TimelineEntry*> order;
+	for(const TimelineEntry& entry : mTimeline)
+		order.push_back(&entry);
+
+	std::stable_sort(order.begin(), order.end(), [](const TimelineEntry* a, const TimelineEntry* b)
+	{
+		return a->StartMs < b->StartMs;
+	});
+
+	std::string text;
+	char line[256];
+	for(const TimelineEntry* entry : order)
+	{
+		std::snprintf(line, sizeof(line), "%9.2f %9.2f ms  thread %u  %s\n",
+			entry->StartMs, entry->EndMs, entry->Thread, entry->Name.c_str());
+		text += line;
+	}
+
+	std::snprintf(line, sizeof(line), "total %.2f ms\n", mTotalMs);
+	text += line;
+
+	return text;
+}
@@ -0,0 +1,61 @@
+//***************************************************************************************
+// TaskGraph.h
+//
+// Runs a set of named tasks on a pool of threads.  A task starts as soon as every task
+// it depends on has finished, so independent work (file loading, mesh generation,
+// shader compilation) overlaps.  The start and end time and the thread of every task
+// are recorded for a startup timeline.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class TaskGraph
+{
+public:
+	using TaskId = std::uint32_t;
+
+	struct TimelineEntry
+	{
+		std::string Name;
+		double StartMs = 0.0; // From the start of Run.
+		double EndMs = 0.0;
+		unsigned Thread = 0;  // 0 is the thread that called Run.
+	};
+
+	///<summary>
+	/// Adds a task.  Dependencies must be tasks that were added before it, so the
+	/// graph cannot have cycles.  Tasks without work only join their dependencies.
+	///</summary>
+	TaskId Add(const std::string& name, std::function<void()> work, const std::vector<TaskId>& dependencies = {});
+
+	///<summary>
+	/// Runs every task on threadCount threads, including the calling one (0 uses every
+	/// hardware thread).  If a task throws, tasks that have not started are skipped and
+	/// the first exception is rethrown once the running ones have finished.
+	///</summary>
+	void Run(unsigned threadCount = 0);
+
+	// In the order the tasks were added.
+	const std::vector<TimelineEntry>& Timeline()const { return mTimeline; }
+	double TotalMs()const { return mTotalMs; }
+
+	// One line per task, in start order, followed by the total.
+	std::string TimelineText()const;
+
+private:
+	struct Task
+	{
+		std::function<void()> Work;
+		std::vector<TaskId> Dependents;
+		std::uint32_t DependencyCount = 0;
+	};
+
+	std::vector<Task> mTasks;
+	std::vector<TimelineEntry> mTimeline;
+	double mTotalMs = 0.0;
+};
@@ -0,0 +1,44 @@
+//***************************************************************************************
+// Bench.h
+//
+// Timing for the benchmarks in this directory.  A benchmark reports the best of several
+// runs after an untimed warm-up run, the run least disturbed by the rest of the
+// machine.  Benchmarks are built with the tests but only run by hand, e.g.
+//
+//   cmake --build build --target InstanceStreamBench && build/Tests/InstanceStreamBench
+//***************************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace Bench
+{
+	///<summary>
+	/// Calls run runs + 1 times and returns the shortest time of the last runs calls,
+	/// in seconds.
+	///</summary>
+	template<typename Function>
+	double BestOf(int runs, Function&& run)
+	{
+		double best = 1e30;
+		for(int i = 0; i <= runs; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			run();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if(i > 0)
+				best = (std::min)(best, seconds);
+		}
+		return best;
+	}
+
+	inline const void* volatile Sink = nullptr;
+
+	// Keeps the compiler from discarding the work that produced data.
+	inline void Use(const void* data)
+	{
+		Sink = data;
+	}
+}
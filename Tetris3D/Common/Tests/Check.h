@@ -0,0 +1,31 @@
+//***************************************************************************************
+// Check.h
+//
+// Minimal test harness for the portable Common sources.  TEST_CASE registers a test
+// with the main in CheckMain.cpp; CHECK reports a failed expression with its file and
+// line and marks the running test as failed without stopping it.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdio>
+
+namespace Check
+{
+	typedef void (*TestFunction)();
+
+	struct Registrar
+	{
+		Registrar(const char* name, TestFunction test);
+	};
+
+	void Fail(const char* file, int line, const char* expression);
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static Check::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if(!(expression)) Check::Fail(__FILE__, __LINE__, #expression); } while(false)
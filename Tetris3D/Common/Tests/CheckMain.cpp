@@ -0,0 +1,62 @@
+//***************************************************************************************
+// CheckMain.cpp
+//
+// Runs every TEST_CASE of the test executable and returns the number of failed tests.
+//***************************************************************************************
+
+#include "Check.h"
+#include <exception>
+#include <vector>
+
+namespace
+{
+	struct Test
+	{
+		const char* Name;
+		Check::TestFunction Function;
+	};
+
+	std::vector<Test>& Tests()
+	{
+		static std::vector<Test> tests;
+		return tests;
+	}
+
+	int gFailures = 0;
+}
+
+Check::Registrar::Registrar(const char* name, TestFunction test)
+{
+	Tests().push_back({ name, test });
+}
+
+void Check::Fail(const char* file, int line, const char* expression)
+{
+	std::printf("%s(%d): CHECK failed: %s\n", file, line, expression);
+	++gFailures;
+}
+
+int main()
+{
+	int failedTests = 0;
+	for(const Test& test : Tests())
+	{
+		const int failuresBefore = gFailures;
+		try
+		{
+			test.Function();
+		}
+		catch(const std::exception& e)
+		{
+			std::printf("%s: unexpected exception: %s\n", test.Name, e.what());
+			++gFailures;
+		}
+
+		const bool passed = gFailures == failuresBefore;
+		std::printf("[%s] %s\n", passed ? "pass" : "FAIL", test.Name);
+		failedTests += passed ? 0 : 1;
+	}
+
+	std::printf("%d of %d tests failed\n", failedTests, (int)Tests().size());
+	return failedTests;
+}
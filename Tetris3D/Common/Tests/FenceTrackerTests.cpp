@@ -0,0 +1,131 @@
+//***************************************************************************************
+// FenceTrackerTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "FenceTracker.h"
+
+#include <vector>
+
+namespace
+{
+	// A fence the test completes by hand.  WaitFor completes the value it waits for,
+	// as the GPU eventually would.
+	class SimulatedFence : public FenceTracker::Fence
+	{
+	public:
+		std::uint64_t CompletedValue() override { return Completed; }
+
+		void WaitFor(std::uint64_t value) override
+		{
+			Waits++;
+			if(Completed < value)
+				Completed = value;
+		}
+
+		std::uint64_t Completed = 0;
+		int Waits = 0;
+	};
+}
+
+TEST_CASE(CallbacksRunInValueThenRegistrationOrder)
+{
+	SimulatedFence fence;
+	FenceTracker tracker(fence);
+	for(int i = 0; i < 3; ++i)
+		tracker.NextValue();
+
+	std::vector<int> order;
+	tracker.OnCompleted(3, [&] { order.push_back(30); });
+	tracker.OnCompleted(1, [&] { order.push_back(10); });
+	tracker.OnCompleted(2, [&] { order.push_back(20); });
+	tracker.OnCompleted(1, [&] { order.push_back(11); });
+	tracker.OnCompleted(3, [&] { order.push_back(31); });
+	CHECK(order.empty() && tracker.PendingCallbacks() == 5);
+
+	// Nothing runs before its value completes.
+	tracker.Poll();
+	CHECK(order.empty());
+
+	fence.Completed = 2;
+	tracker.Poll();
+	CHECK((order == std::vector<int>{ 10, 11, 20 }));
+	CHECK(tracker.PendingCallbacks() == 2);
+
+	fence.Completed = 3;
+	tracker.Poll();
+	CHECK((order == std::vector<int>{ 10, 11, 20, 30, 31 }));
+	CHECK(tracker.PendingCallbacks() == 0);
+}
+
+TEST_CASE(CallbacksOfCompletedValuesRunRightAway)
+{
+	SimulatedFence fence;
+	FenceTracker tracker(fence);
+	tracker.NextValue();
+	tracker.NextValue();
+
+	std::vector<int> order;
+	tracker.OnCompleted(2, [&] { order.push_back(2); });
+	fence.Completed = 2;
+
+	// The due callback of the lower value runs before the new one.
+	tracker.OnCompleted(1, [&] { order.push_back(1); });
+	CHECK((order == std::vector<int>{ 1, 2 }));
+
+	// A callback may register further callbacks; due ones run in the same pass.
+	tracker.OnCompleted(2, [&]
+	{
+		order.push_back(3);
+		tracker.OnCompleted(1, [&] { order.push_back(4); });
+	});
+	CHECK((order == std::vector<int>{ 1, 2, 3, 4 }));
+	CHECK(tracker.PendingCallbacks() == 0);
+}
+
+TEST_CASE(WaitBlocksOnlyWhenNeeded)
+{
+	SimulatedFence fence;
+	FenceTracker tracker(fence);
+	CHECK(tracker.NextValue() == 1);
+	CHECK(tracker.NextValue() == 2);
+	CHECK(tracker.NextValue() == 3);
+	CHECK(tracker.LastSignaled() == 3);
+
+	std::vector<int> order;
+	tracker.OnCompleted(1, [&] { order.push_back(1); });
+	tracker.OnCompleted(2, [&] { order.push_back(2); });
+	tracker.OnCompleted(3, [&] { order.push_back(3); });
+
+	fence.Completed = 1;
+	tracker.Wait(1);
+	CHECK(fence.Waits == 0 && (order == std::vector<int>{ 1 }));
+
+	// Blocking on 2 runs the callbacks up to 2 only.
+	tracker.Wait(2);
+	CHECK(fence.Waits == 1 && (order == std::vector<int>{ 1, 2 }));
+
+	tracker.WaitIdle();
+	CHECK(fence.Waits == 2 && (order == std::vector<int>{ 1, 2, 3 }));
+
+	const FenceTracker::WaitStats& stats = tracker.TotalStats();
+	CHECK(stats.Waits == 3 && stats.BlockedWaits == 2);
+	CHECK(tracker.FrameStats().Waits == 3);
+	tracker.ResetFrameStats();
+	CHECK(tracker.FrameStats().Waits == 0 && tracker.TotalStats().Waits == 3);
+}
+
+TEST_CASE(CompletedValueNeverDecreases)
+{
+	SimulatedFence fence;
+	FenceTracker tracker(fence);
+	for(int i = 0; i < 5; ++i)
+		tracker.NextValue();
+
+	fence.Completed = 4;
+	CHECK(tracker.CompletedValue() == 4 && tracker.IsComplete(4) && !tracker.IsComplete(5));
+
+	// E.g. a fence read while the device is being removed.
+	fence.Completed = 2;
+	CHECK(tracker.CompletedValue() == 4 && tracker.IsComplete(3));
+}
@@ -0,0 +1,58 @@
+//***************************************************************************************
+// FrustumCullBench.cpp
+//
+// Boxes culled per second by CullBoxList::Cull (four boxes at a time with SSE) and
+// CullScalar, for boxes scattered around a camera at the origin looking down +z, about
+// a fifth of them visible.  Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "FrustumCull.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+int main()
+{
+	// Left-handed perspective projection, 90 degrees vertically, with an identity view.
+	const float nearZ = 1.0f, farZ = 100.0f;
+	const float yScale = 1.0f / std::tan(0.25f*3.14159265f);
+	const float range = farZ / (farZ - nearZ);
+	const float viewProj[16] =
+	{
+		yScale/1.5f, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, range, 1.0f,
+		0.0f, 0.0f, -range*nearZ, 0.0f
+	};
+	const Frustum frustum = Frustum::FromViewProj(viewProj);
+
+	std::printf("  boxes   visible   sse M boxes/s   scalar M boxes/s   speedup\n");
+
+	for(std::size_t count : { 1000, 10000, 100000 })
+	{
+		std::mt19937 rng(29);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+		CullBoxList boxes;
+		boxes.Reserve(count);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			float center[3] = { position(rng), position(rng), position(rng) };
+			float extents[3] = { size(rng), size(rng), size(rng) };
+			boxes.Add(center, extents);
+		}
+
+		std::vector<std::uint8_t> visible(count);
+		std::size_t visibleCount = 0;
+		double simd = Bench::BestOf(50, [&] { visibleCount = boxes.Cull(frustum, visible.data()); });
+		double scalar = Bench::BestOf(50, [&] { visibleCount = boxes.CullScalar(frustum, visible.data()); });
+
+		std::printf("%7zu   %7zu   %13.1f   %16.1f   %6.1fx\n", count, visibleCount,
+			count/simd/1e6, count/scalar/1e6, scalar/simd);
+	}
+	return 0;
+}
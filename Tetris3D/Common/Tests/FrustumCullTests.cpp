@@ -0,0 +1,177 @@
+//***************************************************************************************
+// FrustumCullTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "FrustumCull.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+	void Multiply(const float a[16], const float b[16], float out[16])
+	{
+		for(int r = 0; r < 4; ++r)
+		{
+			for(int c = 0; c < 4; ++c)
+			{
+				float sum = 0.0f;
+				for(int k = 0; k < 4; ++k)
+					sum += a[r*4 + k]*b[k*4 + c];
+				out[r*4 + c] = sum;
+			}
+		}
+	}
+
+	// Left-handed perspective camera at eye looking at the origin, as
+	// XMMatrixLookAtLH * XMMatrixPerspectiveFovLH would build it.
+	Frustum MakeFrustum(const float eye[3], float fovY, float aspect, float nearZ, float farZ)
+	{
+		float zAxis[3] = { -eye[0], -eye[1], -eye[2] };
+		float len = std::sqrt(zAxis[0]*zAxis[0] + zAxis[1]*zAxis[1] + zAxis[2]*zAxis[2]);
+		for(float& v : zAxis)
+			v /= len;
+
+		// x = normalize(cross(up, z)), y = cross(z, x) with up = +y.
+		float xAxis[3] = { zAxis[2], 0.0f, -zAxis[0] };
+		len = std::sqrt(xAxis[0]*xAxis[0] + xAxis[2]*xAxis[2]);
+		xAxis[0] /= len;
+		xAxis[2] /= len;
+		float yAxis[3] =
+		{
+			zAxis[1]*xAxis[2] - zAxis[2]*xAxis[1],
+			zAxis[2]*xAxis[0] - zAxis[0]*xAxis[2],
+			zAxis[0]*xAxis[1] - zAxis[1]*xAxis[0]
+		};
+
+		auto dot = [](const float a[3], const float b[3]) { return a[0]*b[0] + a[1]*b[1] + a[2]*b[2]; };
+		float view[16] =
+		{
+			xAxis[0], yAxis[0], zAxis[0], 0.0f,
+			xAxis[1], yAxis[1], zAxis[1], 0.0f,
+			xAxis[2], yAxis[2], zAxis[2], 0.0f,
+			-dot(xAxis, eye), -dot(yAxis, eye), -dot(zAxis, eye), 1.0f
+		};
+
+		float yScale = 1.0f / std::tan(0.5f*fovY);
+		float range = farZ / (farZ - nearZ);
+		float proj[16] =
+		{
+			yScale/aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, yScale, 0.0f, 0.0f,
+			0.0f, 0.0f, range, 1.0f,
+			0.0f, 0.0f, -range*nearZ, 0.0f
+		};
+
+		float viewProj[16];
+		Multiply(view, proj, viewProj);
+		return Frustum::FromViewProj(viewProj);
+	}
+
+	bool SameMasks(const CullBoxList& boxes, const Frustum& frustum, std::size_t* visibleCount = nullptr)
+	{
+		std::vector<std::uint8_t> simd(boxes.Count() + 1, 0xcd);
+		std::vector<std::uint8_t> scalar(boxes.Count() + 1, 0xcd);
+
+		std::size_t simdVisible = boxes.Cull(frustum, simd.data());
+		std::size_t scalarVisible = boxes.CullScalar(frustum, scalar.data());
+		if(visibleCount != nullptr)
+			*visibleCount = scalarVisible;
+
+		// The byte past the end must be left alone.
+		return simdVisible == scalarVisible && simd == scalar && simd.back() == 0xcd;
+	}
+}
+
+TEST_CASE(KnownBoxes)
+{
+	const float eye[3] = { 0.0f, 0.0f, -20.0f };
+	Frustum frustum = MakeFrustum(eye, 0.785f, 16.0f/9.0f, 1.0f, 1000.0f);
+
+	const float extents[3] = { 1.0f, 1.0f, 1.0f };
+	const float centers[][3] =
+	{
+		{ 0.0f, 0.0f, 0.0f },      // in front of the camera
+		{ 0.0f, 0.0f, -30.0f },    // behind it
+		{ 500.0f, 0.0f, 0.0f },    // far to the right
+		{ 0.0f, 0.0f, 2000.0f },   // past the far plane
+		{ 0.0f, 0.0f, -19.5f },    // overlapping the near plane
+	};
+
+	CullBoxList boxes;
+	for(const auto& c : centers)
+		boxes.Add(c, extents);
+
+	std::uint8_t visible[5];
+	CHECK(boxes.Cull(frustum, visible) == 2);
+	CHECK(visible[0] == 1 && visible[1] == 0 && visible[2] == 0 && visible[3] == 0 && visible[4] == 1);
+	CHECK(SameMasks(boxes, frustum));
+
+	// A unit box scaled by 2 and moved to (3, 4, 5) stays inside.
+	const float world[16] = { 2, 0, 0, 0,  0, 2, 0, 0,  0, 0, 2, 0,  3, 4, 5, 1 };
+	CullBoxList moved;
+	moved.AddTransformed(centers[0], extents, world);
+	CHECK(moved.Cull(frustum, visible) == 1);
+}
+
+TEST_CASE(SimdMatchesScalarOnRandomBoxes)
+{
+	std::mt19937 rng(29);
+	std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> size(0.05f, 3.0f);
+	std::uniform_real_distribution<float> fov(0.3f, 1.5f);
+
+	for(int f = 0; f < 16; ++f)
+	{
+		const float eye[3] = { position(rng), position(rng), position(rng) - 80.0f };
+		Frustum frustum = MakeFrustum(eye, fov(rng), 4.0f/3.0f, 0.5f, 200.0f);
+
+		// Every count from 0 to 13 exercises each SIMD remainder, plus a large list.
+		for(std::size_t count : { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 10007 })
+		{
+			CullBoxList boxes;
+			for(std::size_t i = 0; i < count; ++i)
+			{
+				const float c[3] = { position(rng), position(rng), position(rng) };
+				const float e[3] = { size(rng), size(rng), size(rng) };
+				boxes.Add(c, e);
+			}
+			CHECK(SameMasks(boxes, frustum));
+		}
+	}
+}
+
+TEST_CASE(SimdMatchesScalarOnStraddlingBoxes)
+{
+	std::mt19937 rng(30);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> size(0.01f, 4.0f);
+
+	const float eye[3] = { 5.0f, 12.0f, -25.0f };
+	Frustum frustum = MakeFrustum(eye, 0.9f, 1.5f, 1.0f, 100.0f);
+
+	// Boxes whose support distance to one plane is exactly zero, a hair inside or a
+	// hair outside, so rounding decides the answer.
+	CullBoxList boxes;
+	for(int i = 0; i < 6000; ++i)
+	{
+		const float* n = frustum.Planes[i % 6];
+		const float e[3] = { size(rng), size(rng), size(rng) };
+		float r = std::fabs(n[0])*e[0] + std::fabs(n[1])*e[1] + std::fabs(n[2])*e[2];
+
+		// A point on the plane near the view direction, pushed out by the box radius.
+		float p[3] = { 10.0f*unit(rng), 10.0f*unit(rng), 30.0f*unit(rng) };
+		float d = n[0]*p[0] + n[1]*p[1] + n[2]*p[2] + n[3];
+		float offset = -d - r + 1e-6f*(float)((i / 6) % 3 - 1);
+		const float c[3] = { p[0] + offset*n[0], p[1] + offset*n[1], p[2] + offset*n[2] };
+		boxes.Add(c, e);
+	}
+
+	std::size_t visible = 0;
+	CHECK(SameMasks(boxes, frustum, &visible));
+
+	// The set really straddles: neither everything culled nor everything kept.
+	CHECK(visible > 0 && visible < boxes.Count());
+}
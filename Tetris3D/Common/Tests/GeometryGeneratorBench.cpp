@@ -0,0 +1,226 @@
+//***************************************************************************************
+// GeometryGeneratorBench.cpp
+//
+// Times CreateSphere, CreateCylinder and CreateGrid from 16 to 4096 slices and stacks
+// (grid rows and columns) against the per-vertex sinf/cosf code they replaced.  Meshes
+// with 32K vertices per thread or more are split across the hardware threads, so run it
+// on a multi-core machine to measure the split.  Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "GeometryGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	typedef GeometryGenerator::MeshData MeshData;
+	typedef GeometryGenerator::Vertex Vertex;
+	typedef GeometryGenerator::uint32 uint32;
+
+	const float Pi = 3.1415926535f;
+
+	// The sphere as it was built before the sine and cosine tables.
+	MeshData PerVertexSphere(float radius, uint32 sliceCount, uint32 stackCount)
+	{
+		MeshData mesh;
+		mesh.Vertices.push_back(Vertex(0.0f, radius, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+
+		float phiStep = Pi/stackCount;
+		float thetaStep = 2.0f*Pi/sliceCount;
+		for(uint32 i = 1; i <= stackCount - 1; ++i)
+		{
+			float phi = i*phiStep;
+			for(uint32 j = 0; j <= sliceCount; ++j)
+			{
+				float theta = j*thetaStep;
+				float x = radius*sinf(phi)*cosf(theta);
+				float y = radius*cosf(phi);
+				float z = radius*sinf(phi)*sinf(theta);
+
+				float tx = -radius*sinf(phi)*sinf(theta);
+				float tz = radius*sinf(phi)*cosf(theta);
+				float tLength = sqrtf(tx*tx + tz*tz);
+				mesh.Vertices.push_back(Vertex(x, y, z, x/radius, y/radius, z/radius,
+					tx/tLength, 0.0f, tz/tLength, theta/(2.0f*Pi), phi/Pi));
+			}
+		}
+		mesh.Vertices.push_back(Vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+
+		for(uint32 i = 1; i <= sliceCount; ++i)
+		{
+			mesh.Indices32.push_back(0);
+			mesh.Indices32.push_back(i + 1);
+			mesh.Indices32.push_back(i);
+		}
+		uint32 ringVertexCount = sliceCount + 1;
+		for(uint32 i = 0; i < stackCount - 2; ++i)
+		{
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				uint32 a = 1 + i*ringVertexCount + j;
+				mesh.Indices32.push_back(a);
+				mesh.Indices32.push_back(a + 1);
+				mesh.Indices32.push_back(a + ringVertexCount);
+				mesh.Indices32.push_back(a + ringVertexCount);
+				mesh.Indices32.push_back(a + 1);
+				mesh.Indices32.push_back(a + ringVertexCount + 1);
+			}
+		}
+		uint32 southPoleIndex = (uint32)mesh.Vertices.size() - 1;
+		uint32 baseIndex = southPoleIndex - ringVertexCount;
+		for(uint32 i = 0; i < sliceCount; ++i)
+		{
+			mesh.Indices32.push_back(southPoleIndex);
+			mesh.Indices32.push_back(baseIndex + i);
+			mesh.Indices32.push_back(baseIndex + i + 1);
+		}
+		return mesh;
+	}
+
+	void PerVertexCap(float radius, float y, float ny, float height, uint32 sliceCount, bool top, MeshData& mesh)
+	{
+		uint32 baseIndex = (uint32)mesh.Vertices.size();
+		float dTheta = 2.0f*Pi/sliceCount;
+		for(uint32 i = 0; i <= sliceCount; ++i)
+		{
+			float x = radius*cosf(i*dTheta);
+			float z = radius*sinf(i*dTheta);
+			mesh.Vertices.push_back(Vertex(x, y, z, 0.0f, ny, 0.0f, 1.0f, 0.0f, 0.0f, x/height + 0.5f, z/height + 0.5f));
+		}
+		mesh.Vertices.push_back(Vertex(0.0f, y, 0.0f, 0.0f, ny, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f));
+
+		uint32 centerIndex = (uint32)mesh.Vertices.size() - 1;
+		for(uint32 i = 0; i < sliceCount; ++i)
+		{
+			mesh.Indices32.push_back(centerIndex);
+			mesh.Indices32.push_back(baseIndex + (top ? i + 1 : i));
+			mesh.Indices32.push_back(baseIndex + (top ? i : i + 1));
+		}
+	}
+
+	// The cylinder as it was built before the sine and cosine tables.
+	MeshData PerVertexCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+	{
+		MeshData mesh;
+		float stackHeight = height/stackCount;
+		float radiusStep = (topRadius - bottomRadius)/stackCount;
+		float dTheta = 2.0f*Pi/sliceCount;
+		float dr = bottomRadius - topRadius;
+		for(uint32 i = 0; i <= stackCount; ++i)
+		{
+			float y = -0.5f*height + i*stackHeight;
+			float r = bottomRadius + i*radiusStep;
+			for(uint32 j = 0; j <= sliceCount; ++j)
+			{
+				float c = cosf(j*dTheta);
+				float s = sinf(j*dTheta);
+
+				// N = T x B with T = (-s, 0, c) and B = (dr c, -h, dr s).
+				float n[3] = { height*c, dr, height*s };
+				float length = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+				mesh.Vertices.push_back(Vertex(r*c, y, r*s, n[0]/length, n[1]/length, n[2]/length,
+					-s, 0.0f, c, (float)j/sliceCount, 1.0f - (float)i/stackCount));
+			}
+		}
+
+		uint32 ringVertexCount = sliceCount + 1;
+		for(uint32 i = 0; i < stackCount; ++i)
+		{
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				uint32 a = i*ringVertexCount + j;
+				mesh.Indices32.push_back(a);
+				mesh.Indices32.push_back(a + ringVertexCount);
+				mesh.Indices32.push_back(a + ringVertexCount + 1);
+				mesh.Indices32.push_back(a);
+				mesh.Indices32.push_back(a + ringVertexCount + 1);
+				mesh.Indices32.push_back(a + 1);
+			}
+		}
+
+		PerVertexCap(topRadius, 0.5f*height, 1.0f, height, sliceCount, true, mesh);
+		PerVertexCap(bottomRadius, -0.5f*height, -1.0f, height, sliceCount, false, mesh);
+		return mesh;
+	}
+
+	// The grid as it was built before rows were split across threads.
+	MeshData PerVertexGrid(float width, float depth, uint32 m, uint32 n)
+	{
+		MeshData mesh;
+		mesh.Vertices.resize(m*n);
+		float dx = width/(n - 1);
+		float dz = depth/(m - 1);
+		for(uint32 i = 0; i < m; ++i)
+		{
+			float z = 0.5f*depth - i*dz;
+			for(uint32 j = 0; j < n; ++j)
+			{
+				float x = -0.5f*width + j*dx;
+				mesh.Vertices[i*n + j] = Vertex(x, 0.0f, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+					j*(1.0f/(n - 1)), i*(1.0f/(m - 1)));
+			}
+		}
+
+		mesh.Indices32.resize((m - 1)*(n - 1)*6);
+		uint32 k = 0;
+		for(uint32 i = 0; i < m - 1; ++i)
+		{
+			for(uint32 j = 0; j < n - 1; ++j)
+			{
+				mesh.Indices32[k] = i*n + j;
+				mesh.Indices32[k + 1] = i*n + j + 1;
+				mesh.Indices32[k + 2] = (i + 1)*n + j;
+				mesh.Indices32[k + 3] = (i + 1)*n + j;
+				mesh.Indices32[k + 4] = i*n + j + 1;
+				mesh.Indices32[k + 5] = (i + 1)*n + j + 1;
+				k += 6;
+			}
+		}
+		return mesh;
+	}
+
+	// Best time of building a mesh, in ms.  Each run frees the previous mesh first, so
+	// that only one is held at a time; both columns pay for the free alike.
+	template<typename Build>
+	double Time(int runs, Build&& build)
+	{
+		MeshData mesh;
+		return Bench::BestOf(runs, [&]
+		{
+			mesh = MeshData();
+			mesh = build();
+			Bench::Use(mesh.Vertices.data());
+		})*1e3;
+	}
+}
+
+int main()
+{
+	GeometryGenerator geoGen;
+
+	std::printf("%u hardware thread(s)\n\n", (std::max)(1u, std::thread::hardware_concurrency()));
+	std::printf("Best time in ms, n slices x n stacks (grid n x n), per-vertex / tabled:\n\n");
+	std::printf("     n      vertices           sphere              cylinder                  grid\n");
+
+	for(uint32 n = 16; n <= 4096; n *= 4)
+	{
+		// The largest meshes take seconds and a gigabyte each.
+		const int runs = n >= 1024 ? 1 : 5;
+
+		double sphereOld = Time(runs, [&] { return PerVertexSphere(0.5f, n, n); });
+		double sphereNew = Time(runs, [&] { return geoGen.CreateSphere(0.5f, n, n); });
+		double cylinderOld = Time(runs, [&] { return PerVertexCylinder(0.5f, 0.3f, 3.0f, n, n); });
+		double cylinderNew = Time(runs, [&] { return geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, n, n); });
+		double gridOld = Time(runs, [&] { return PerVertexGrid(20.0f, 30.0f, n, n); });
+		double gridNew = Time(runs, [&] { return geoGen.CreateGrid(20.0f, 30.0f, n, n); });
+
+		const unsigned long long vertices = (unsigned long long)(n - 1)*(n + 1) + 2;
+		std::printf("%6u  %12llu  %8.3f / %8.3f  %8.3f / %8.3f  %8.3f / %8.3f\n", n, vertices,
+			sphereOld, sphereNew, cylinderOld, cylinderNew, gridOld, gridNew);
+	}
+	return 0;
+}
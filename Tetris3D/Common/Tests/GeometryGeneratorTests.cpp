@@ -0,0 +1,210 @@
+//***************************************************************************************
+// GeometryGeneratorTests.cpp
+//
+// The tabled sphere, cylinder and grid tessellation against the per-vertex sinf/cosf
+// code it replaced, evaluated here in double precision.
+//***************************************************************************************
+
+#include "Check.h"
+#include "GeometryGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	typedef GeometryGenerator::MeshData MeshData;
+	typedef GeometryGenerator::Vertex Vertex;
+
+	const double Pi = 3.14159265358979323846;
+
+	Vertex MakeVertex(double px, double py, double pz, double nx, double ny, double nz,
+		double tx, double ty, double tz, double u, double v)
+	{
+		return Vertex((float)px, (float)py, (float)pz, (float)nx, (float)ny, (float)nz,
+			(float)tx, (float)ty, (float)tz, (float)u, (float)v);
+	}
+
+	MeshData ReferenceSphere(double radius, std::uint32_t sliceCount, std::uint32_t stackCount)
+	{
+		MeshData mesh;
+		mesh.Vertices.push_back(MakeVertex(0, radius, 0, 0, 1, 0, 1, 0, 0, 0, 0));
+		for(std::uint32_t i = 1; i < stackCount; ++i)
+		{
+			double phi = i*Pi/stackCount;
+			for(std::uint32_t j = 0; j <= sliceCount; ++j)
+			{
+				double theta = j*2.0*Pi/sliceCount;
+				double x = std::sin(phi)*std::cos(theta);
+				double z = std::sin(phi)*std::sin(theta);
+				mesh.Vertices.push_back(MakeVertex(radius*x, radius*std::cos(phi), radius*z, x, std::cos(phi), z,
+					-std::sin(theta), 0, std::cos(theta), theta/(2.0*Pi), phi/Pi));
+			}
+		}
+		mesh.Vertices.push_back(MakeVertex(0, -radius, 0, 0, -1, 0, 1, 0, 0, 0, 1));
+
+		std::uint32_t ring = sliceCount + 1;
+		for(std::uint32_t i = 1; i <= sliceCount; ++i)
+			mesh.Indices32.insert(mesh.Indices32.end(), { 0, i + 1, i });
+		for(std::uint32_t i = 0; i + 2 < stackCount; ++i)
+		{
+			for(std::uint32_t j = 0; j < sliceCount; ++j)
+			{
+				std::uint32_t a = 1 + i*ring + j;
+				mesh.Indices32.insert(mesh.Indices32.end(), { a, a + 1, a + ring, a + ring, a + 1, a + ring + 1 });
+			}
+		}
+		std::uint32_t south = (std::uint32_t)mesh.Vertices.size() - 1;
+		for(std::uint32_t i = 0; i < sliceCount; ++i)
+			mesh.Indices32.insert(mesh.Indices32.end(), { south, south - ring + i, south - ring + i + 1 });
+		return mesh;
+	}
+
+	void ReferenceCap(double radius, double y, double ny, double height, std::uint32_t sliceCount, bool top, MeshData& mesh)
+	{
+		std::uint32_t base = (std::uint32_t)mesh.Vertices.size();
+		for(std::uint32_t i = 0; i <= sliceCount; ++i)
+		{
+			double x = radius*std::cos(i*2.0*Pi/sliceCount);
+			double z = radius*std::sin(i*2.0*Pi/sliceCount);
+			mesh.Vertices.push_back(MakeVertex(x, y, z, 0, ny, 0, 1, 0, 0, x/height + 0.5, z/height + 0.5));
+		}
+		mesh.Vertices.push_back(MakeVertex(0, y, 0, 0, ny, 0, 1, 0, 0, 0.5, 0.5));
+
+		std::uint32_t center = (std::uint32_t)mesh.Vertices.size() - 1;
+		for(std::uint32_t i = 0; i < sliceCount; ++i)
+		{
+			if(top)
+				mesh.Indices32.insert(mesh.Indices32.end(), { center, base + i + 1, base + i });
+			else
+				mesh.Indices32.insert(mesh.Indices32.end(), { center, base + i, base + i + 1 });
+		}
+	}
+
+	MeshData ReferenceCylinder(double bottomRadius, double topRadius, double height, std::uint32_t sliceCount, std::uint32_t stackCount)
+	{
+		MeshData mesh;
+		double dr = bottomRadius - topRadius;
+		for(std::uint32_t i = 0; i <= stackCount; ++i)
+		{
+			double y = -0.5*height + i*height/stackCount;
+			double r = bottomRadius + i*(topRadius - bottomRadius)/stackCount;
+			for(std::uint32_t j = 0; j <= sliceCount; ++j)
+			{
+				double c = std::cos(j*2.0*Pi/sliceCount);
+				double s = std::sin(j*2.0*Pi/sliceCount);
+
+				// T x B with T = (-s, 0, c) and B = (dr c, -h, dr s).
+				double n[3] = { height*c, dr, height*s };
+				double length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+				mesh.Vertices.push_back(MakeVertex(r*c, y, r*s, n[0]/length, n[1]/length, n[2]/length,
+					-s, 0, c, (double)j/sliceCount, 1.0 - (double)i/stackCount));
+			}
+		}
+
+		std::uint32_t ring = sliceCount + 1;
+		for(std::uint32_t i = 0; i < stackCount; ++i)
+		{
+			for(std::uint32_t j = 0; j < sliceCount; ++j)
+			{
+				std::uint32_t a = i*ring + j;
+				mesh.Indices32.insert(mesh.Indices32.end(), { a, a + ring, a + ring + 1, a, a + ring + 1, a + 1 });
+			}
+		}
+
+		ReferenceCap(topRadius, 0.5*height, 1.0, height, sliceCount, true, mesh);
+		ReferenceCap(bottomRadius, -0.5*height, -1.0, height, sliceCount, false, mesh);
+		return mesh;
+	}
+
+	MeshData ReferenceGrid(double width, double depth, std::uint32_t m, std::uint32_t n)
+	{
+		MeshData mesh;
+		for(std::uint32_t i = 0; i < m; ++i)
+		{
+			for(std::uint32_t j = 0; j < n; ++j)
+			{
+				mesh.Vertices.push_back(MakeVertex(-0.5*width + j*width/(n - 1), 0, 0.5*depth - i*depth/(m - 1),
+					0, 1, 0, 1, 0, 0, (double)j/(n - 1), (double)i/(m - 1)));
+			}
+		}
+		for(std::uint32_t i = 0; i + 1 < m; ++i)
+		{
+			for(std::uint32_t j = 0; j + 1 < n; ++j)
+			{
+				std::uint32_t a = i*n + j;
+				mesh.Indices32.insert(mesh.Indices32.end(), { a, a + 1, a + n, a + n, a + 1, a + n + 1 });
+			}
+		}
+		return mesh;
+	}
+
+	// Largest difference of any vertex component, scaled by the size of the mesh for
+	// positions; -1 if the index lists or vertex counts differ.
+	double MaxDifference(const MeshData& a, const MeshData& b, double size)
+	{
+		if(a.Vertices.size() != b.Vertices.size() || a.Indices32 != b.Indices32)
+			return -1.0;
+
+		double maxDifference = 0.0;
+		for(std::size_t i = 0; i < a.Vertices.size(); ++i)
+		{
+			const Vertex& u = a.Vertices[i];
+			const Vertex& v = b.Vertices[i];
+			const double d[] =
+			{
+				std::fabs(u.Position.x - v.Position.x)/size, std::fabs(u.Position.y - v.Position.y)/size,
+				std::fabs(u.Position.z - v.Position.z)/size,
+				std::fabs(u.Normal.x - v.Normal.x), std::fabs(u.Normal.y - v.Normal.y), std::fabs(u.Normal.z - v.Normal.z),
+				std::fabs(u.TangentU.x - v.TangentU.x), std::fabs(u.TangentU.y - v.TangentU.y),
+				std::fabs(u.TangentU.z - v.TangentU.z),
+				std::fabs(u.TexC.x - v.TexC.x), std::fabs(u.TexC.y - v.TexC.y)
+			};
+			maxDifference = (std::max)(maxDifference, *std::max_element(std::begin(d), std::end(d)));
+		}
+		return maxDifference;
+	}
+
+	// A few float roundings of sin/cos tables and products.
+	const double Tolerance = 2e-6;
+}
+
+TEST_CASE(SphereMatchesThePerVertexCode)
+{
+	// The app's sphere, the smallest one, and one large enough to be split across threads.
+	const std::uint32_t sizes[][2] = { { 20, 20 }, { 3, 2 }, { 7, 3 }, { 256, 300 } };
+	for(const auto& size : sizes)
+	{
+		MeshData sphere = GeometryGenerator().CreateSphere(0.5f, size[0], size[1]);
+		double difference = MaxDifference(sphere, ReferenceSphere(0.5, size[0], size[1]), 0.5);
+		CHECK(difference >= 0.0 && difference < Tolerance);
+	}
+}
+
+TEST_CASE(CylinderMatchesThePerVertexCode)
+{
+	// Tapered both ways, straight, and large enough to be split across threads.
+	struct Params { float Bottom, Top, Height; std::uint32_t Slices, Stacks; };
+	const Params cylinders[] =
+	{
+		{ 0.5f, 0.3f, 3.0f, 20, 20 }, { 0.2f, 1.5f, 0.5f, 3, 1 }, { 1.0f, 1.0f, 2.0f, 9, 4 }, { 2.0f, 0.0f, 4.0f, 256, 300 }
+	};
+	for(const Params& c : cylinders)
+	{
+		MeshData cylinder = GeometryGenerator().CreateCylinder(c.Bottom, c.Top, c.Height, c.Slices, c.Stacks);
+		double size = (std::max)((std::max)(c.Bottom, c.Top), c.Height);
+		double difference = MaxDifference(cylinder, ReferenceCylinder(c.Bottom, c.Top, c.Height, c.Slices, c.Stacks), size);
+		CHECK(difference >= 0.0 && difference < Tolerance);
+	}
+}
+
+TEST_CASE(GridMatchesThePerVertexCode)
+{
+	const std::uint32_t sizes[][2] = { { 60, 40 }, { 2, 2 }, { 3, 7 }, { 300, 257 } };
+	for(const auto& size : sizes)
+	{
+		MeshData grid = GeometryGenerator().CreateGrid(20.0f, 30.0f, size[0], size[1]);
+		double difference = MaxDifference(grid, ReferenceGrid(20.0, 30.0, size[0], size[1]), 30.0);
+		CHECK(difference >= 0.0 && difference < Tolerance);
+	}
+}
@@ -0,0 +1,74 @@
+//***************************************************************************************
+// IndexFormatBench.cpp
+//
+// Throughput of IndexFormat::MaxIndex and of the 16-bit IndexFormat::Write against
+// scalar loops, in GB/s of 32-bit input, for a list that fits in L2 and one that only
+// fits in DRAM.  The 32-bit Write is a copy and is shown for reference.  Not run by
+// ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "IndexFormat.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	std::uint32_t ScalarMax(const std::uint32_t* indices, std::size_t count)
+	{
+		std::uint32_t result = 0;
+		for(std::size_t i = 0; i < count; ++i)
+			result = (std::max)(result, indices[i]);
+		return result;
+	}
+
+	void ScalarNarrow(const std::uint32_t* indices, std::size_t count, std::uint16_t* destination)
+	{
+		for(std::size_t i = 0; i < count; ++i)
+			destination[i] = (std::uint16_t)indices[i];
+	}
+
+	void Measure(const char* name, std::size_t count, int runs)
+	{
+		std::mt19937 rng(40);
+		std::vector<std::uint32_t> indices(count);
+		for(std::uint32_t& index : indices)
+			index = rng() % 0x10000;
+		std::vector<std::uint32_t> destination(count);
+
+		volatile std::uint32_t maxIndex = 0;
+		double maxScalar = Bench::BestOf(runs, [&] { maxIndex = ScalarMax(indices.data(), count); });
+		double maxSse = Bench::BestOf(runs, [&] { maxIndex = IndexFormat::MaxIndex(indices.data(), count); });
+
+		double narrowScalar = Bench::BestOf(runs, [&]
+		{
+			ScalarNarrow(indices.data(), count, (std::uint16_t*)destination.data());
+			Bench::Use(destination.data());
+		});
+		double narrowSse = Bench::BestOf(runs, [&]
+		{
+			IndexFormat::Write(indices.data(), count, 2, destination.data());
+			Bench::Use(destination.data());
+		});
+		double copy = Bench::BestOf(runs, [&]
+		{
+			IndexFormat::Write(indices.data(), count, 4, destination.data());
+			Bench::Use(destination.data());
+		});
+
+		const double gigabytes = count*sizeof(std::uint32_t)/1e9;
+		std::printf("%-20s %8.1f / %5.1f %11.1f / %5.1f %10.1f\n", name,
+			gigabytes/maxScalar, gigabytes/maxSse, gigabytes/narrowScalar, gigabytes/narrowSse, gigabytes/copy);
+	}
+}
+
+int main()
+{
+	std::printf("GB/s of 32-bit input  max scalar / SIMD  narrow scalar / SIMD  32-bit copy\n");
+	Measure("36K indices (L2)", 36*1024, 2000);
+	Measure("16M indices (DRAM)", 16*1024*1024, 10);
+	return 0;
+}
@@ -0,0 +1,112 @@
+//***************************************************************************************
+// IndexFormatTests.cpp
+//
+// The SSE max and 16-bit narrowing against scalar loops, at every list length around
+// the 8-index blocks so the tails of 1 to 7 indices are covered.
+//***************************************************************************************
+
+#include "Check.h"
+#include "IndexFormat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	std::uint32_t ScalarMax(const std::uint32_t* indices, std::size_t count)
+	{
+		std::uint32_t result = 0;
+		for(std::size_t i = 0; i < count; ++i)
+			result = (std::max)(result, indices[i]);
+		return result;
+	}
+
+	const std::size_t MaxCount = 41;
+}
+
+TEST_CASE(MaxIndexMatchesScalarForEveryTail)
+{
+	std::mt19937 random(7);
+	std::vector<std::uint32_t> storage(MaxCount + 1);
+
+	// Both alignments of the list: the loads are unaligned.
+	for(std::size_t offset = 0; offset < 2; ++offset)
+	{
+		std::uint32_t* indices = storage.data() + offset;
+		for(std::size_t count = 0; count <= MaxCount; ++count)
+		{
+			// The largest value at every position, including the scalar tail, and large
+			// values that are negative as signed integers.
+			const std::uint32_t largest[] = { 1u, 0xffffu, 0x7fffffffu, 0x80000000u, 0xfffffffeu, 0xffffffffu };
+			for(std::uint32_t value : largest)
+			{
+				for(std::size_t at = 0; at < count; ++at)
+				{
+					for(std::size_t i = 0; i < count; ++i)
+						indices[i] = random() % value;
+					indices[at] = value;
+					CHECK(IndexFormat::MaxIndex(indices, count) == value);
+				}
+			}
+
+			for(std::size_t i = 0; i < count; ++i)
+				indices[i] = (std::uint32_t)random();
+			CHECK(IndexFormat::MaxIndex(indices, count) == ScalarMax(indices, count));
+
+			std::fill(indices, indices + count, 0u);
+			CHECK(IndexFormat::MaxIndex(indices, count) == 0);
+		}
+	}
+}
+
+TEST_CASE(SizeForChoosesTheSmallestFormat)
+{
+	CHECK(IndexFormat::SizeFor(0) == 2);
+	CHECK(IndexFormat::SizeFor(0xffff) == 2);
+	CHECK(IndexFormat::SizeFor(0x10000) == 4);
+	CHECK(IndexFormat::SizeFor(0xffffffff) == 4);
+}
+
+TEST_CASE(NarrowingMatchesScalarForEveryTail)
+{
+	std::mt19937 random(11);
+	std::vector<std::uint32_t> source(MaxCount + 1);
+
+	// Guard values after the written range must survive.
+	const std::uint16_t Guard = 0xcdcd;
+	std::vector<std::uint16_t> destination(MaxCount + 9);
+
+	for(std::size_t offset = 0; offset < 2; ++offset)
+	{
+		const std::uint32_t* indices = source.data() + offset;
+		std::uint16_t* out = destination.data() + offset;
+		for(std::size_t count = 0; count <= MaxCount; ++count)
+		{
+			// The values around the signed pack's saturation points.
+			const std::uint32_t edges[] = { 0u, 1u, 0x7fffu, 0x8000u, 0x8001u, 0xfffeu, 0xffffu };
+			for(std::size_t i = 0; i < count; ++i)
+				source[offset + i] = i < std::size(edges) ? edges[(i + count) % std::size(edges)] : random() & 0xffff;
+
+			std::fill(destination.begin(), destination.end(), Guard);
+			IndexFormat::Write(indices, count, 2, out);
+
+			bool same = true;
+			for(std::size_t i = 0; i < count; ++i)
+				same = same && out[i] == (std::uint16_t)indices[i];
+			CHECK(same);
+			CHECK(std::all_of(out + count, destination.data() + destination.size(), [Guard](std::uint16_t v) { return v == Guard; }));
+			CHECK(std::all_of(destination.data(), out, [Guard](std::uint16_t v) { return v == Guard; }));
+		}
+	}
+}
+
+TEST_CASE(WideWriteCopies)
+{
+	std::vector<std::uint32_t> indices = { 0, 70000, 0xffffffffu, 3, 0x10000 };
+	std::vector<std::uint32_t> out(indices.size() + 1, 0xcdcdcdcd);
+	IndexFormat::Write(indices.data(), indices.size(), 4, out.data());
+	CHECK(std::equal(indices.begin(), indices.end(), out.begin()));
+	CHECK(out.back() == 0xcdcdcdcd);
+}
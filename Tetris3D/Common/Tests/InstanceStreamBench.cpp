@@ -0,0 +1,56 @@
+//***************************************************************************************
+// InstanceStreamBench.cpp
+//
+// Throughput of InstanceStreamBuilder: Reset, Add and Build of a stream of instances
+// added in random order over 3 meshes and 8 materials, like the map cells.  Not run by
+// ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "InstanceStream.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+int main()
+{
+	struct Source
+	{
+		std::uint32_t Mesh;
+		std::uint32_t Material;
+		float World[16];
+	};
+
+	std::printf("instances   build ms   M instances/s\n");
+
+	for(std::size_t count : { 1000, 10000, 100000 })
+	{
+		std::mt19937 rng(26);
+		std::vector<Source> sources(count);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			Source& s = sources[i];
+			s.Mesh = rng() % 3;
+			s.Material = rng() % 8;
+			for(int j = 0; j < 16; ++j)
+				s.World[j] = (j % 5 == 0) ? 1.0f : 0.0f;
+			s.World[12] = (float)(i % 10);
+			s.World[13] = (float)(i / 10 % 20);
+		}
+
+		InstanceStreamBuilder builder;
+		double seconds = Bench::BestOf(20, [&]
+		{
+			builder.Reset();
+			builder.Reserve(count);
+			for(std::size_t i = 0; i < count; ++i)
+				builder.Add(0, sources[i].Mesh, sources[i].Material, sources[i].World, (std::uint32_t)i);
+			builder.Build();
+			Bench::Use(builder.Instances().data());
+		});
+
+		std::printf("%9zu   %8.3f   %13.2f\n", count, seconds*1e3, count/seconds/1e6);
+	}
+	return 0;
+}
@@ -0,0 +1,160 @@
+//***************************************************************************************
+// InstanceStreamTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "InstanceStream.h"
+#include <random>
+
+namespace
+{
+	void Translation(float x, float y, float z, float world[16])
+	{
+		for(int i = 0; i < 16; ++i)
+			world[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+		world[12] = x;
+		world[13] = y;
+		world[14] = z;
+	}
+}
+
+TEST_CASE(GroupsByPipelineStateAndMesh)
+{
+	float world[16];
+	Translation(0.0f, 0.0f, 0.0f, world);
+
+	InstanceStreamBuilder builder;
+	builder.Add(1, 7, 0, world, 0);
+	builder.Add(0, 7, 0, world, 1);
+	builder.Add(0, 3, 0, world, 2);
+	builder.Add(1, 7, 0, world, 3);
+	builder.Add(0, 7, 0, world, 4);
+	builder.Build();
+
+	// Ordered by pipeline state, then mesh.
+	const auto& batches = builder.Batches();
+	CHECK(batches.size() == 3);
+	CHECK(batches[0].PipelineState == 0 && batches[0].Mesh == 3 && batches[0].InstanceCount == 1);
+	CHECK(batches[1].PipelineState == 0 && batches[1].Mesh == 7 && batches[1].InstanceCount == 2);
+	CHECK(batches[2].PipelineState == 1 && batches[2].Mesh == 7 && batches[2].InstanceCount == 2);
+
+	// FirstSource is the first instance added to the batch.
+	CHECK(batches[0].FirstSource == 2);
+	CHECK(batches[1].FirstSource == 1);
+	CHECK(batches[2].FirstSource == 0);
+}
+
+TEST_CASE(SortsByMaterialInsideBatch)
+{
+	float world[16];
+	Translation(0.0f, 0.0f, 0.0f, world);
+
+	InstanceStreamBuilder builder;
+	builder.Add(0, 0, 5, world, 0);
+	builder.Add(0, 0, 2, world, 1);
+	builder.Add(0, 0, 5, world, 2);
+	builder.Add(0, 0, 2, world, 3);
+	builder.Build();
+
+	// Ties keep their Add order.
+	const auto& instances = builder.Instances();
+	CHECK(builder.Batches().size() == 1);
+	CHECK(instances[0].MaterialIndex == 2 && instances[0].Color == 1);
+	CHECK(instances[1].MaterialIndex == 2 && instances[1].Color == 3);
+	CHECK(instances[2].MaterialIndex == 5 && instances[2].Color == 0);
+	CHECK(instances[3].MaterialIndex == 5 && instances[3].Color == 2);
+}
+
+TEST_CASE(BatchesAreContiguousRanges)
+{
+	std::mt19937 rng(26);
+	InstanceStreamBuilder builder;
+
+	for(int round = 0; round < 50; ++round)
+	{
+		builder.Reset();
+		const int count = 1 + (int)(rng() % 500);
+		for(int i = 0; i < count; ++i)
+		{
+			float world[16];
+			Translation((float)i, 0.0f, 0.0f, world);
+			builder.Add(rng() % 3, rng() % 5, rng() % 8, world, (std::uint32_t)i);
+		}
+		builder.Build();
+
+		CHECK(builder.InstanceCount() == (std::size_t)count);
+
+		// The ranges tile the stream in order, and every instance of a range belongs
+		// to its batch: the color holds the Add index, the translation too.
+		std::uint32_t next = 0;
+		for(const auto& batch : builder.Batches())
+		{
+			CHECK(batch.StartInstance == next);
+			CHECK(batch.InstanceCount > 0);
+			next += batch.InstanceCount;
+
+			std::uint32_t previousMaterial = 0;
+			for(std::uint32_t i = batch.StartInstance; i < next; ++i)
+			{
+				const InstanceData& instance = builder.Instances()[i];
+				CHECK(instance.World[0][3] == (float)instance.Color);
+				CHECK(instance.MaterialIndex >= previousMaterial);
+				CHECK(instance.Color >= batch.FirstSource);
+				previousMaterial = instance.MaterialIndex;
+			}
+		}
+		CHECK(next == (std::uint32_t)count);
+
+		for(std::size_t b = 1; b < builder.Batches().size(); ++b)
+		{
+			const auto& prev = builder.Batches()[b - 1];
+			const auto& batch = builder.Batches()[b];
+			CHECK(prev.PipelineState < batch.PipelineState ||
+				(prev.PipelineState == batch.PipelineState && prev.Mesh < batch.Mesh));
+		}
+	}
+}
+
+TEST_CASE(StoresAffineColumns)
+{
+	float world[16] = { 1, 2, 3, 0,  4, 5, 6, 0,  7, 8, 9, 0,  10, 11, 12, 1 };
+
+	InstanceStreamBuilder builder;
+	builder.Add(0, 0, 0, world, InstanceStreamBuilder::PackColor(1.0f, 0.0f, 0.5f, 1.0f));
+	builder.Build();
+
+	const InstanceData& instance = builder.Instances()[0];
+	for(int c = 0; c < 3; ++c)
+	{
+		for(int r = 0; r < 4; ++r)
+			CHECK(instance.World[c][r] == world[r*4 + c]);
+	}
+	CHECK(instance.Color == 0xff8000ff);
+}
+
+TEST_CASE(CapacityGrowsOnOverflow)
+{
+	// Fits: the buffer is kept.
+	CHECK(InstanceStreamBuilder::CapacityFor(0, 256) == 256);
+	CHECK(InstanceStreamBuilder::CapacityFor(256, 256) == 256);
+
+	// Overflows: twice the count, at least MinCapacity.
+	CHECK(InstanceStreamBuilder::CapacityFor(257, 256) == 514);
+	CHECK(InstanceStreamBuilder::CapacityFor(10, 4) == InstanceStreamBuilder::MinCapacity);
+
+	// No buffer yet.
+	CHECK(InstanceStreamBuilder::CapacityFor(0, 0) == InstanceStreamBuilder::MinCapacity);
+	CHECK(InstanceStreamBuilder::CapacityFor(300, 0) == 600);
+
+	// A stream that keeps growing reallocates a logarithmic number of times.
+	std::size_t capacity = 0;
+	int reallocations = 0;
+	for(std::size_t count = 0; count < 100000; ++count)
+	{
+		std::size_t next = InstanceStreamBuilder::CapacityFor(count, capacity);
+		CHECK(next >= count);
+		reallocations += next != capacity ? 1 : 0;
+		capacity = next;
+	}
+	CHECK(reallocations <= 10);
+}
@@ -0,0 +1,69 @@
+//***************************************************************************************
+// MathHelperBench.cpp
+//
+// MathHelper::InverseRigid and InversePerspective against XMMatrixInverse on 1024
+// random look-at views and perspective projections, the two inverses UpdateMainPassCB
+// computes each frame.  Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "MathHelper.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const std::size_t MatrixCount = 1024;
+
+	template<typename Inverse>
+	double NanosecondsPerInverse(const std::vector<XMFLOAT4X4>& matrices, std::vector<XMFLOAT4X4>& out, Inverse&& inverse)
+	{
+		double seconds = Bench::BestOf(200, [&]
+		{
+			for(std::size_t i = 0; i < matrices.size(); ++i)
+				XMStoreFloat4x4(&out[i], inverse(XMLoadFloat4x4(&matrices[i])));
+			Bench::Use(out.data());
+		});
+		return seconds*1e9/matrices.size();
+	}
+}
+
+int main()
+{
+	std::mt19937 random(45);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	std::vector<XMFLOAT4X4> views(MatrixCount);
+	std::vector<XMFLOAT4X4> projections(MatrixCount);
+	for(std::size_t i = 0; i < MatrixCount; ++i)
+	{
+		XMVECTOR eye = XMVectorSet(100.0f*unit(random) - 50.0f, 100.0f*unit(random) - 50.0f, 100.0f*unit(random) - 50.0f, 1.0f);
+		XMVECTOR target = XMVectorSet(10.0f*unit(random), 10.0f*unit(random), 10.0f*unit(random), 1.0f);
+		XMStoreFloat4x4(&views[i], XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+
+		float nearZ = 0.1f + unit(random);
+		XMStoreFloat4x4(&projections[i], XMMatrixPerspectiveFovLH(0.2f + 2.5f*unit(random), 0.3f + 3.0f*unit(random),
+			nearZ, nearZ + 10.0f + 1000.0f*unit(random)));
+	}
+
+	std::vector<XMFLOAT4X4> out(MatrixCount);
+	auto general = [](CXMMATRIX m)
+	{
+		XMVECTOR det;
+		return XMMatrixInverse(&det, m);
+	};
+
+	double viewGeneral = NanosecondsPerInverse(views, out, general);
+	double viewRigid = NanosecondsPerInverse(views, out, [](CXMMATRIX m) { return MathHelper::InverseRigid(m); });
+	double projGeneral = NanosecondsPerInverse(projections, out, general);
+	double projPerspective = NanosecondsPerInverse(projections, out, [](CXMMATRIX m) { return MathHelper::InversePerspective(m); });
+
+	std::printf("ns per inverse   XMMatrixInverse   closed form   speedup\n");
+	std::printf("view             %15.2f   %11.2f   %6.1fx  (InverseRigid)\n", viewGeneral, viewRigid, viewGeneral/viewRigid);
+	std::printf("projection       %15.2f   %11.2f   %6.1fx  (InversePerspective)\n", projGeneral, projPerspective, projGeneral/projPerspective);
+	return 0;
+}
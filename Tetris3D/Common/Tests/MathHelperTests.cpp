@@ -0,0 +1,183 @@
+//***************************************************************************************
+// MathHelperTests.cpp
+//
+// The closed-form view and projection inverses against XMMatrixInverse and a double
+// precision reference.
+//***************************************************************************************
+
+#include "Check.h"
+#include "MathHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// Gauss-Jordan inverse with partial pivoting, in double.
+	void ReferenceInverse(const XMFLOAT4X4& m, double out[4][4])
+	{
+		double a[4][8];
+		for(int i = 0; i < 4; ++i)
+			for(int j = 0; j < 8; ++j)
+				a[i][j] = j < 4 ? m.m[i][j] : (j - 4 == i ? 1.0 : 0.0);
+
+		for(int c = 0; c < 4; ++c)
+		{
+			int pivot = c;
+			for(int r = c + 1; r < 4; ++r)
+				if(std::fabs(a[r][c]) > std::fabs(a[pivot][c]))
+					pivot = r;
+			for(int j = 0; j < 8; ++j)
+				std::swap(a[c][j], a[pivot][j]);
+
+			double d = a[c][c];
+			for(int j = 0; j < 8; ++j)
+				a[c][j] /= d;
+			for(int r = 0; r < 4; ++r)
+			{
+				if(r == c)
+					continue;
+				double f = a[r][c];
+				for(int j = 0; j < 8; ++j)
+					a[r][j] -= f*a[c][j];
+			}
+		}
+
+		for(int i = 0; i < 4; ++i)
+			for(int j = 0; j < 4; ++j)
+				out[i][j] = a[i][j + 4];
+	}
+
+	// Largest difference from the reference inverse of m, relative to its largest entry.
+	double InverseError(CXMMATRIX m, CXMMATRIX inverse)
+	{
+		XMFLOAT4X4 source;
+		XMFLOAT4X4 result;
+		XMStoreFloat4x4(&source, m);
+		XMStoreFloat4x4(&result, inverse);
+
+		double reference[4][4];
+		ReferenceInverse(source, reference);
+
+		double error = 0.0;
+		double size = 0.0;
+		for(int i = 0; i < 4; ++i)
+		{
+			for(int j = 0; j < 4; ++j)
+			{
+				error = (std::max)(error, std::fabs(result.m[i][j] - reference[i][j]));
+				size = (std::max)(size, std::fabs(reference[i][j]));
+			}
+		}
+		return error/size;
+	}
+
+	double GeneralError(CXMMATRIX m)
+	{
+		XMVECTOR determinant;
+		return InverseError(m, XMMatrixInverse(&determinant, m));
+	}
+}
+
+TEST_CASE(InverseRigidMatchesTheGeneralInverse)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	double worst = 0.0;
+	bool asGoodAsGeneral = true;
+	for(int i = 0; i < 10000; ++i)
+	{
+		// Orbit views like the app's camera, around the origin and other targets.
+		float radius = 1.0f + 200.0f*unit(random);
+		float theta = 6.2831853f*unit(random);
+		float phi = 0.05f + 3.04f*unit(random);
+		XMVECTOR eye = MathHelper::SphericalToCartesian(radius, theta, phi);
+		XMVECTOR target = i % 2 == 0 ? XMVectorZero() :
+			XMVectorSet(10.0f*unit(random) - 5.0f, 10.0f*unit(random) - 5.0f, 10.0f*unit(random) - 5.0f, 1.0f);
+		XMMATRIX view = XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+		double error = InverseError(view, MathHelper::InverseRigid(view));
+		worst = (std::max)(worst, error);
+		asGoodAsGeneral = asGoodAsGeneral && error <= 4.0*GeneralError(view) + 1e-6;
+	}
+
+	CHECK(worst < 2e-6);
+	CHECK(asGoodAsGeneral);
+}
+
+TEST_CASE(InversePerspectiveMatchesTheGeneralInverse)
+{
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	double worst = 0.0;
+	bool asGoodAsGeneral = true;
+	for(int i = 0; i < 10000; ++i)
+	{
+		float nearZ = 0.1f + 5.0f*unit(random);
+		float farZ = nearZ + 10.0f + 5000.0f*unit(random);
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.2f + 2.5f*unit(random), 0.3f + 3.0f*unit(random), nearZ, farZ);
+
+		double error = InverseError(proj, MathHelper::InversePerspective(proj));
+		worst = (std::max)(worst, error);
+		asGoodAsGeneral = asGoodAsGeneral && error <= 4.0*GeneralError(proj) + 1e-6;
+	}
+
+	CHECK(worst < 1e-6);
+	CHECK(asGoodAsGeneral);
+}
+
+TEST_CASE(InversePerspectiveHandlesOffCenterFrustums)
+{
+	std::mt19937 random(13);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// A frustum shifted entirely to one side, as used for a tile of the screen.
+	XMMATRIX shifted = XMMatrixPerspectiveOffCenterLH(0.25f, 1.75f, -0.5f, 0.1f, 1.0f, 1000.0f);
+	CHECK(InverseError(shifted, MathHelper::InversePerspective(shifted)) < 1e-6);
+
+	// inverse(P)*P is the identity, including the off-center third row.
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixMultiply(MathHelper::InversePerspective(shifted), shifted));
+	bool isIdentity = true;
+	for(int i = 0; i < 4; ++i)
+		for(int j = 0; j < 4; ++j)
+			isIdentity = isIdentity && std::fabs(identity.m[i][j] - (i == j ? 1.0f : 0.0f)) < 1e-5f;
+	CHECK(isIdentity);
+
+	double worst = 0.0;
+	for(int i = 0; i < 10000; ++i)
+	{
+		float left = -2.0f*unit(random);
+		float right = left + 0.1f + 3.0f*unit(random);
+		float bottom = -2.0f*unit(random) + 1.0f;
+		float top = bottom + 0.1f + 3.0f*unit(random);
+		float nearZ = 0.1f + 5.0f*unit(random);
+		float farZ = nearZ + 10.0f + 5000.0f*unit(random);
+		XMMATRIX proj = XMMatrixPerspectiveOffCenterLH(left, right, bottom, top, nearZ, farZ);
+		worst = (std::max)(worst, InverseError(proj, MathHelper::InversePerspective(proj)));
+	}
+	CHECK(worst < 1e-6);
+}
+
+TEST_CASE(InverseViewProjectionComposes)
+{
+	// The pass constants build inverse(view*proj) as inverse(proj)*inverse(view).
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(10.0f, 20.0f, -30.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX projections[] =
+	{
+		XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 1.6f, 1.0f, 1000.0f),
+		XMMatrixPerspectiveOffCenterLH(-0.3f, 0.7f, -0.2f, 0.4f, 1.0f, 1000.0f)
+	};
+	for(const XMMATRIX& proj : projections)
+	{
+		XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+		XMMATRIX inverse = XMMatrixMultiply(MathHelper::InversePerspective(proj), MathHelper::InverseRigid(view));
+		CHECK(InverseError(viewProj, inverse) < 1e-4);
+		CHECK(InverseError(viewProj, inverse) <= 4.0*GeneralError(viewProj) + 1e-5);
+	}
+}
@@ -0,0 +1,197 @@
+//***************************************************************************************
+// MeshCacheTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "MeshCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+	typedef GeometryGenerator::MeshData MeshData;
+
+	// Fresh directory for the cache files of one test.
+	std::string TestDirectory(const char* name)
+	{
+		std::filesystem::path dir = std::filesystem::temp_directory_path() / "Tetris3DMeshCacheTests" / name;
+		std::filesystem::remove_all(dir);
+		return dir.string();
+	}
+
+	MeshData Sphere()
+	{
+		return GeometryGenerator().CreateSphere(0.5f, 8, 6);
+	}
+
+	bool SameMesh(const GeometryGenerator::MeshView& view, const MeshData& mesh)
+	{
+		return view.VertexCount == mesh.Vertices.size() && view.IndexCount == mesh.Indices32.size() &&
+			std::memcmp(view.Vertices, mesh.Vertices.data(), mesh.Vertices.size()*sizeof(GeometryGenerator::Vertex)) == 0 &&
+			std::memcmp(view.Indices32, mesh.Indices32.data(), mesh.Indices32.size()*sizeof(std::uint32_t)) == 0;
+	}
+
+	// The only file in directory.
+	std::filesystem::path CacheFile(const std::string& directory)
+	{
+		std::filesystem::path found;
+		int count = 0;
+		for(const auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			found = entry.path();
+			count++;
+		}
+		return count == 1 ? found : std::filesystem::path();
+	}
+}
+
+TEST_CASE(RequestsForOneKeyShareOneMesh)
+{
+	MeshCache cache;
+	int created = 0;
+	auto create = [&created] { created++; return Sphere(); };
+
+	MeshCache::MeshPtr a = cache.GetOrCreate(MeshKey("CreateSphere", 0.5f, 8u, 6u), create);
+	MeshCache::MeshPtr b = cache.GetOrCreate(MeshKey("CreateSphere", 0.5f, 8u, 6u), create);
+	CHECK(created == 1 && a == b && !a->IsMapped());
+	CHECK(SameMesh(a->View(), Sphere()));
+
+	// Other parameters, or the same value with another type, are other keys.
+	cache.GetOrCreate(MeshKey("CreateSphere", 0.5f, 8u, 7u), create);
+	cache.GetOrCreate(MeshKey("CreateSphere", 0.5, 8u, 6u), create);
+	CHECK(created == 3);
+
+	MeshCache::Stats stats = cache.GetStats();
+	CHECK(stats.Hits == 1 && stats.Misses == 3 && stats.DiskLoads == 0);
+
+	// Clear forgets the meshes; the ones still referenced stay valid.
+	cache.Clear();
+	MeshCache::MeshPtr c = cache.GetOrCreate(MeshKey("CreateSphere", 0.5f, 8u, 6u), create);
+	CHECK(created == 4 && c != a && SameMesh(a->View(), Sphere()));
+}
+
+TEST_CASE(HashCollisionsAreNotShared)
+{
+	MeshCache cache;
+	const MeshKey sphere("CreateSphere", 0.5f, 8u, 6u);
+	const MeshKey box = MeshKey::WithHash(MeshKey("CreateBox", 1.0f, 1.0f, 1.0f, 0u), sphere.Hash());
+
+	int created = 0;
+	MeshCache::MeshPtr first = cache.GetOrCreate(sphere, [&] { created++; return Sphere(); });
+
+	// The box has the hash of the sphere: it is created, not given the sphere, and
+	// not cached, so each request creates it again.
+	MeshData boxMesh = GeometryGenerator().CreateBox(1.0f, 1.0f, 1.0f, 0);
+	MeshCache::MeshPtr second = cache.GetOrCreate(box, [&] { created++; return boxMesh; });
+	MeshCache::MeshPtr third = cache.GetOrCreate(box, [&] { created++; return boxMesh; });
+	CHECK(created == 3 && second != first && third != second);
+	CHECK(SameMesh(second->View(), boxMesh));
+
+	// The sphere keeps its slot.
+	CHECK(cache.GetOrCreate(sphere, [&] { created++; return Sphere(); }) == first && created == 3);
+
+	MeshCache::Stats stats = cache.GetStats();
+	CHECK(stats.Hits == 1 && stats.Misses == 3);
+}
+
+TEST_CASE(FailedCreationIsNotCached)
+{
+	MeshCache cache;
+	const MeshKey key("CreateSphere", 0.5f, 8u, 6u);
+
+	bool threw = false;
+	try
+	{
+		cache.GetOrCreate(key, []() -> MeshData { throw std::runtime_error("out of memory"); });
+	}
+	catch(const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+
+	MeshCache::MeshPtr mesh = cache.GetOrCreate(key, [] { return Sphere(); });
+	CHECK(mesh != nullptr && SameMesh(mesh->View(), Sphere()));
+}
+
+TEST_CASE(MeshesAreMappedFromTheDirectory)
+{
+	const std::string dir = TestDirectory("RoundTrip");
+	const MeshKey key("CreateSphere", 0.5f, 8u, 6u);
+	const MeshData sphere = Sphere();
+
+	{
+		MeshCache cache;
+		cache.SetDirectory(dir);
+		cache.GetOrCreate(key, [&] { return sphere; });
+		CHECK(cache.GetStats().DiskLoads == 0);
+	}
+
+	// A new cache over the same directory maps the file instead of creating the mesh.
+	MeshCache cache;
+	cache.SetDirectory(dir);
+	bool created = false;
+	MeshCache::MeshPtr mesh = cache.GetOrCreate(key, [&] { created = true; return sphere; });
+	CHECK(!created && mesh->IsMapped() && SameMesh(mesh->View(), sphere));
+
+	// The vertices are used in place, so they must be aligned.
+	CHECK(reinterpret_cast<std::uintptr_t>(mesh->View().Vertices) % alignof(GeometryGenerator::Vertex) == 0);
+	CHECK(reinterpret_cast<std::uintptr_t>(mesh->View().Indices32) % alignof(std::uint32_t) == 0);
+
+	// Later requests are served from memory.
+	CHECK(cache.GetOrCreate(key, [&] { created = true; return sphere; }) == mesh && !created);
+	MeshCache::Stats stats = cache.GetStats();
+	CHECK(stats.Hits == 1 && stats.Misses == 1 && stats.DiskLoads == 1);
+
+	mesh.reset();
+	cache.Clear();
+	std::filesystem::remove_all(dir);
+}
+
+TEST_CASE(StaleAndDamagedFilesAreRegenerated)
+{
+	const std::string dir = TestDirectory("Stale");
+	const MeshKey key("CreateSphere", 0.5f, 8u, 6u);
+	const MeshData sphere = Sphere();
+
+	{
+		MeshCache cache;
+		cache.SetDirectory(dir);
+		cache.GetOrCreate(key, [&] { return sphere; });
+	}
+
+	const std::filesystem::path path = CacheFile(dir);
+	CHECK(!path.empty());
+	if(path.empty())
+		return;
+
+	auto loadsFromDisk = [&]()
+	{
+		MeshCache cache;
+		cache.SetDirectory(dir);
+		bool created = false;
+		MeshCache::MeshPtr mesh = cache.GetOrCreate(key, [&] { created = true; return sphere; });
+		return !created && cache.GetStats().DiskLoads == 1 && SameMesh(mesh->View(), sphere);
+	};
+	CHECK(loadsFromDisk());
+
+	// Written by another generator version: regenerated, and the file rewritten.
+	{
+		std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+		const std::uint32_t oldVersion = GeometryGenerator::Version - 1;
+		file.seekp(8);
+		file.write(reinterpret_cast<const char*>(&oldVersion), sizeof(oldVersion));
+	}
+	CHECK(!loadsFromDisk());
+	CHECK(loadsFromDisk());
+
+	// Cut short: regenerated too.
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+	CHECK(!loadsFromDisk());
+	CHECK(loadsFromDisk());
+
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,300 @@
+//***************************************************************************************
+// MeshFileTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "MeshBake.h"
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	std::string ReadText(const std::string& path)
+	{
+		std::ifstream fin(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	}
+
+	void WriteText(const std::string& path, const std::string& text)
+	{
+		std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+		fout << text;
+	}
+
+	// Fresh directory for the files of one test.
+	std::string TestDirectory(const char* name)
+	{
+		std::filesystem::path dir = std::filesystem::temp_directory_path() / "Tetris3DMeshFileTests" / name;
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir);
+		return dir.string() + "/";
+	}
+
+	const MeshBakeSettings DefaultSettings;
+
+	bool BakeCar(TextMesh& text, MeshFileData& data)
+	{
+		std::string error;
+		if(!MeshTextParser::Load(MODELS_DIR "car.txt", text, error, 1))
+			return false;
+		MeshBake::Bake(text, DefaultSettings, data);
+		return true;
+	}
+
+	double SurfaceArea(const float* positions, std::size_t stride, const std::uint32_t* indices, std::size_t count)
+	{
+		double area = 0.0;
+		for(std::size_t t = 0; t + 2 < count; t += 3)
+		{
+			const float* a = positions + indices[t]*stride;
+			const float* b = positions + indices[t + 1]*stride;
+			const float* c = positions + indices[t + 2]*stride;
+			double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			double n[3] = { e0[1]*e1[2] - e0[2]*e1[1], e0[2]*e1[0] - e0[0]*e1[2], e0[0]*e1[1] - e0[1]*e1[0] };
+			area += 0.5*std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+		}
+		return area;
+	}
+}
+
+TEST_CASE(BakedCarKeepsItsSurface)
+{
+	TextMesh text;
+	MeshFileData data;
+	CHECK(BakeCar(text, data));
+	if(text.Vertices.empty())
+		return;
+
+	CHECK(data.Vertices.size() == text.Vertices.size());
+	CHECK(data.Lods.size() >= 2 && data.Lods.size() <= DefaultSettings.LodCount);
+	CHECK(data.Lods[0].StartIndex == 0 && data.Lods[0].IndexCount == text.Indices.size());
+	for(std::size_t i = 1; i < data.Lods.size(); ++i)
+	{
+		CHECK(data.Lods[i].IndexCount < data.Lods[i - 1].IndexCount);
+		CHECK(data.Lods[i].Error >= data.Lods[i - 1].Error);
+		CHECK(data.Lods[i].StartIndex == data.Lods[i - 1].StartIndex + data.Lods[i - 1].IndexCount);
+	}
+
+	// Decode the packed vertices and compare the full level with the text mesh.
+	QuantizationBounds bounds = QuantizationBounds::FromCenterExtents(data.BoundsCenter, data.BoundsExtents);
+	std::vector<float> decoded(data.Vertices.size()*3);
+	for(std::size_t i = 0; i < data.Vertices.size(); ++i)
+		VertexQuantize::UnpackPosition(data.Vertices[i], bounds, &decoded[i*3]);
+
+	double textArea = SurfaceArea(text.Vertices[0].Position, 6, text.Indices.data(), text.Indices.size());
+	double bakedArea = SurfaceArea(decoded.data(), 3, data.Indices.data(), data.Lods[0].IndexCount);
+	CHECK(std::fabs(bakedArea - textArea) < 1e-3*textArea);
+
+	// Every baked vertex is a quantized text vertex.
+	float tolerance = 0.0f;
+	for(int a = 0; a < 3; ++a)
+		tolerance = (std::max)(tolerance, 2.0f*bounds.MaxError(a) + 1e-5f);
+	bool allMatched = true;
+	for(std::size_t i = 0; i < data.Vertices.size() && allMatched; ++i)
+	{
+		bool matched = false;
+		for(std::size_t j = 0; j < text.Vertices.size() && !matched; ++j)
+		{
+			const float* p = text.Vertices[j].Position;
+			matched = std::fabs(p[0] - decoded[i*3]) <= tolerance && std::fabs(p[1] - decoded[i*3 + 1]) <= tolerance &&
+				std::fabs(p[2] - decoded[i*3 + 2]) <= tolerance;
+		}
+		allMatched = matched;
+	}
+	CHECK(allMatched);
+}
+
+TEST_CASE(SerializedImageOpens)
+{
+	TextMesh text;
+	MeshFileData data;
+	CHECK(BakeCar(text, data));
+
+	MeshFile file;
+	std::string error;
+	CHECK(file.Adopt(MeshFile::Serialize(data, 123, 456, 789), "car.mesh", error));
+	if(!file.IsOpen())
+		return;
+
+	const MeshFileHeader& h = file.Header();
+	CHECK(h.VertexStride == sizeof(PackedVertex) && h.VertexCount == data.Vertices.size());
+	CHECK(h.IndexCount == data.Indices.size() && h.LodCount == data.Lods.size());
+	CHECK(h.SourceSize == 123 && h.SourceHash == 456 && h.SettingsHash == 789);
+	CHECK(h.VertexOffset % MeshFileHeader::BlobAlignment == 0 && h.IndexOffset % MeshFileHeader::BlobAlignment == 0);
+
+	// The vertex blob is the upload layout byte for byte.
+	CHECK(std::memcmp(file.Vertices(), data.Vertices.data(), data.Vertices.size()*sizeof(PackedVertex)) == 0);
+	CHECK(std::equal(data.Indices.begin(), data.Indices.end(), file.Indices()));
+	CHECK(file.Lods()[1].IndexCount == data.Lods[1].IndexCount && file.Lods()[1].Error == data.Lods[1].Error);
+}
+
+TEST_CASE(CorruptFilesAreRejected)
+{
+	TextMesh text;
+	MeshFileData data;
+	CHECK(BakeCar(text, data));
+	const std::vector<unsigned char> good = MeshFile::Serialize(data, 0, 0, 0);
+
+	auto openError = [](std::vector<unsigned char> image)
+	{
+		MeshFile file;
+		std::string error;
+		bool opened = file.Adopt(std::move(image), "bad.mesh", error);
+		return opened ? std::string() : error;
+	};
+	auto header = [](std::vector<unsigned char>& image) { return reinterpret_cast<MeshFileHeader*>(image.data()); };
+
+	CHECK(openError(good).empty());
+
+	std::vector<unsigned char> image = good;
+	header(image)->Magic = 0;
+	CHECK(openError(image) == "bad.mesh: not a mesh file.");
+
+	// Version 1 files held float3 positions and normals.
+	image = good;
+	header(image)->Version = 1;
+	CHECK(openError(image) == "bad.mesh: unsupported version 1.");
+
+	// Version 2 files hashed the text and the settings together.
+	image = good;
+	header(image)->Version = 2;
+	CHECK(openError(image) == "bad.mesh: unsupported version 2.");
+
+	image = good;
+	image.pop_back();
+	CHECK(openError(image) == "bad.mesh: file is truncated.");
+
+	image = std::vector<unsigned char>(good.begin(), good.begin() + 40);
+	CHECK(openError(image) == "bad.mesh: file is smaller than the header.");
+
+	image = good;
+	header(image)->IndexOffset = ~std::uint64_t(MeshFileHeader::BlobAlignment - 1);
+	CHECK(openError(image) == "bad.mesh: blobs are out of range.");
+
+	image = good;
+	header(image)->VertexCount += 1000;
+	CHECK(openError(image) == "bad.mesh: blobs are out of range.");
+
+	// One index past the last vertex, anywhere in the blob.
+	for(std::size_t at : { std::size_t(0), data.Indices.size() / 2, data.Indices.size() - 1 })
+	{
+		image = good;
+		std::uint32_t* indices = reinterpret_cast<std::uint32_t*>(image.data() + header(image)->IndexOffset);
+		indices[at] = header(image)->VertexCount;
+		CHECK(openError(image) == "bad.mesh: indices are out of range.");
+	}
+
+	image = good;
+	MeshFileLod* lods = reinterpret_cast<MeshFileLod*>(image.data() + header(image)->LodOffset);
+	lods[1].IndexCount += 3;
+	CHECK(openError(image) == "bad.mesh: level of detail ranges are out of range.");
+
+	image = good;
+	header(image)->LodCount = 0;
+	CHECK(openError(image) == "bad.mesh: level of detail ranges are out of range.");
+
+	MeshFile missing;
+	std::string error;
+	CHECK(!missing.Open(TestDirectory("Missing") + "none.mesh", error));
+}
+
+TEST_CASE(StaleFilesAreRebuilt)
+{
+	const std::string dir = TestDirectory("Stale");
+	const std::string textPath = dir + "car.txt";
+	const std::string meshPath = dir + "car.mesh";
+	std::string text = ReadText(MODELS_DIR "car.txt");
+	WriteText(textPath, text);
+
+	MeshFile file;
+	std::string error;
+	bool rebuilt = false;
+
+	// Missing: baked and written.
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(rebuilt && std::filesystem::exists(meshPath));
+	const std::uint32_t vertexCount = file.IsOpen() ? file.Header().VertexCount : 0;
+	CHECK(vertexCount == 1860);
+
+	// Current: mapped as it is.
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(!rebuilt);
+
+	// Written again unchanged: hashed, not rebuilt, and the .mesh file is touched so
+	// the text is older again.
+	WriteText(textPath, text);
+	CHECK(std::filesystem::last_write_time(textPath) >= std::filesystem::last_write_time(meshPath));
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(!rebuilt && file.IsOpen());
+	CHECK(std::filesystem::last_write_time(textPath) < std::filesystem::last_write_time(meshPath));
+
+	// Same size, one digit changed: the hash catches it.
+	std::size_t digit = text.find("-1.65064");
+	CHECK(digit != std::string::npos);
+	text[digit + 1] = '2';
+	WriteText(textPath, text);
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(rebuilt);
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(!rebuilt);
+
+	// Same size and written before the .mesh file: trusted without reading the text.
+	const std::filesystem::file_time_type textTime = std::filesystem::last_write_time(textPath);
+	text[digit + 1] = '3';
+	WriteText(textPath, text);
+	std::filesystem::last_write_time(textPath, textTime);
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(!rebuilt);
+
+	// Other settings.
+	MeshBakeSettings fewerLods;
+	fewerLods.LodCount = 2;
+	CHECK(MeshBake::Load(textPath, meshPath, fewerLods, file, error, &rebuilt));
+	CHECK(rebuilt && file.IsOpen() && file.Header().LodCount <= 2);
+
+	// Without the text the file is used as it is.
+	std::filesystem::remove(textPath);
+	CHECK(MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(!rebuilt && file.IsOpen() && file.Header().LodCount <= 2);
+
+	// A file that cannot be written still loads from memory.
+	WriteText(textPath, text);
+	CHECK(MeshBake::Load(textPath, dir + "missing/car.mesh", DefaultSettings, file, error, &rebuilt));
+	CHECK(rebuilt && file.IsOpen() && file.Header().VertexCount == vertexCount);
+
+	// Malformed text is an error naming the line.
+	WriteText(textPath, "VertexCount: 1\nTriangleCount: 0\nVertexList\n{\n0 0 x 0 0 1\n}\nTriangleList\n{\n}\n");
+	CHECK(!MeshBake::Load(textPath, meshPath, DefaultSettings, file, error, &rebuilt));
+	CHECK(error == textPath + ":5: malformed number.");
+	CHECK(!file.IsOpen());
+
+	std::filesystem::remove_all(dir);
+}
+
+TEST_CASE(ShippedModelsAreCurrent)
+{
+	// The checked in .mesh files must be baked from the checked in text with the
+	// default settings, or every run of the app rebuilds them.
+	for(const char* name : { "skull", "car" })
+	{
+		const std::string base = std::string(MODELS_DIR) + name;
+		std::string text = ReadText(base + ".txt");
+
+		MeshFile file;
+		std::string error;
+		CHECK(file.Open(base + ".mesh", error));
+		if(!file.IsOpen())
+			continue;
+
+		CHECK(file.Header().SourceSize == text.size());
+		CHECK(file.Header().SourceHash == MeshBake::SourceHash(text.data(), text.size()));
+		CHECK(file.Header().SettingsHash == MeshBake::SettingsHash(DefaultSettings));
+	}
+}
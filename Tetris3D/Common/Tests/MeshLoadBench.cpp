@@ -0,0 +1,79 @@
+//***************************************************************************************
+// MeshLoadBench.cpp
+//
+// Startup cost of the models in both formats, side by side: parsing the text, opening
+// the .mesh file, and MeshBake::Load as the app calls it, both when the .mesh file is
+// current and when the text was written after it (e.g. by a fresh checkout) and has
+// to be hashed.  The MeshBake::Load runs work on copies in the temporary directory.
+// Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "MeshBake.h"
+#include "MeshFile.h"
+#include "MeshTextParser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+int main()
+{
+	namespace fs = std::filesystem;
+
+	const fs::path dir = fs::temp_directory_path() / "Tetris3DMeshLoadBench";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+
+	const int Runs = 20;
+	const MeshBakeSettings settings;
+
+	std::printf("model   text parse ms   .mesh open ms   bake load ms   bake load, text newer ms\n");
+
+	for(const char* name : { "skull", "car" })
+	{
+		const std::string base = std::string(MODELS_DIR) + name;
+		std::string error;
+
+		double parse = Bench::BestOf(Runs, [&]
+		{
+			TextMesh mesh;
+			if(!MeshTextParser::Load(base + ".txt", mesh, error))
+				std::fprintf(stderr, "%s\n", error.c_str());
+			Bench::Use(mesh.Vertices.data());
+		});
+
+		MeshFile file;
+		double open = Bench::BestOf(Runs, [&]
+		{
+			if(!file.Open(base + ".mesh", error))
+				std::fprintf(stderr, "%s\n", error.c_str());
+		});
+
+		// The text first, so the .mesh copy is newer.
+		const std::string textPath = (dir / (std::string(name) + ".txt")).string();
+		const std::string meshPath = (dir / (std::string(name) + ".mesh")).string();
+		fs::copy_file(base + ".txt", textPath);
+		fs::copy_file(base + ".mesh", meshPath);
+
+		bool rebuilt = false;
+		auto bakeLoad = [&]
+		{
+			if(!MeshBake::Load(textPath, meshPath, settings, file, error, &rebuilt))
+				std::fprintf(stderr, "%s\n", error.c_str());
+		};
+		double current = Bench::BestOf(Runs, bakeLoad);
+
+		// Text written in the future stays newer than the .mesh file however often the
+		// load touches it, so every run hashes the text.
+		fs::last_write_time(textPath, fs::file_time_type::clock::now() + std::chrono::hours(1));
+		double hashed = Bench::BestOf(Runs, bakeLoad);
+		if(rebuilt)
+			std::fprintf(stderr, "%s.mesh is stale; rebake the shipped models.\n", name);
+
+		std::printf("%-5s   %13.3f   %13.3f   %12.3f   %24.3f\n", name, parse*1e3, open*1e3, current*1e3, hashed*1e3);
+	}
+
+	fs::remove_all(dir);
+	return 0;
+}
@@ -0,0 +1,185 @@
+//***************************************************************************************
+// MeshOptimizeTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "MeshOptimize.h"
+#include "MeshTextParser.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+	typedef std::array<std::uint32_t, 3> Triangle;
+
+	// Triangles rotated to start at their smallest index, which keeps the winding,
+	// and sorted; equal lists mean one order is a permutation of the other.
+	std::vector<Triangle> Canonical(const std::vector<std::uint32_t>& indices, const std::vector<std::uint32_t>* remap = nullptr)
+	{
+		std::vector<Triangle> tris;
+		for(std::size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			Triangle tri = { indices[t], indices[t + 1], indices[t + 2] };
+			if(remap != nullptr)
+			{
+				for(std::uint32_t& v : tri)
+					v = (*remap)[v];
+			}
+			std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+			tris.push_back(tri);
+		}
+		std::sort(tris.begin(), tris.end());
+		return tris;
+	}
+
+	// n x n vertex grid, triangles row by row.
+	std::vector<std::uint32_t> MakeGrid(std::uint32_t n)
+	{
+		std::vector<std::uint32_t> indices;
+		for(std::uint32_t i = 0; i + 1 < n; ++i)
+		{
+			for(std::uint32_t j = 0; j + 1 < n; ++j)
+			{
+				std::uint32_t a = i*n + j, b = a + 1, c = a + n, d = c + 1;
+				indices.insert(indices.end(), { a, b, c, c, b, d });
+			}
+		}
+		return indices;
+	}
+
+	std::vector<std::uint32_t> ShuffleTriangles(const std::vector<std::uint32_t>& indices, unsigned seed)
+	{
+		std::vector<std::size_t> order(indices.size() / 3);
+		for(std::size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::mt19937 rng(seed);
+		std::shuffle(order.begin(), order.end(), rng);
+
+		std::vector<std::uint32_t> shuffled;
+		for(std::size_t t : order)
+			shuffled.insert(shuffled.end(), &indices[t*3], &indices[t*3] + 3);
+		return shuffled;
+	}
+
+	float Acmr(const std::vector<std::uint32_t>& indices, std::size_t vertexCount)
+	{
+		return MeshOptimize::ComputeAcmr(indices.data(), indices.size(), vertexCount);
+	}
+}
+
+TEST_CASE(AcmrOfKnownOrders)
+{
+	// One triangle misses three times, a strip of two shares an edge.
+	std::vector<std::uint32_t> one = { 0, 1, 2 };
+	CHECK(Acmr(one, 3) == 3.0f);
+	std::vector<std::uint32_t> two = { 0, 1, 2, 2, 1, 3 };
+	CHECK(Acmr(two, 4) == 2.0f);
+	CHECK(MeshOptimize::ComputeAcmr(nullptr, 0, 0) == 0.0f);
+}
+
+TEST_CASE(VertexCacheOrderIsAPermutation)
+{
+	const std::uint32_t n = 120;
+	std::vector<std::uint32_t> shuffled = ShuffleTriangles(MakeGrid(n), 31);
+	std::vector<std::uint32_t> optimized = shuffled;
+	MeshOptimize::OptimizeVertexCache(optimized.data(), optimized.size(), n*n);
+
+	CHECK(Canonical(optimized) == Canonical(shuffled));
+	CHECK(Acmr(optimized, n*n) < 0.8f);
+	CHECK(Acmr(optimized, n*n) < Acmr(shuffled, n*n) / 2.0f);
+
+	// Other cache sizes, and a mesh with unused vertices.
+	for(unsigned cacheSize : { 4u, 8u, 32u })
+	{
+		std::vector<std::uint32_t> sized = shuffled;
+		MeshOptimize::OptimizeVertexCache(sized.data(), sized.size(), n*n + 50, cacheSize);
+		CHECK(Canonical(sized) == Canonical(shuffled));
+	}
+}
+
+TEST_CASE(KeepsABetterInputOrder)
+{
+	// A single strip is already ideal for any cache.
+	std::vector<std::uint32_t> strip;
+	for(std::uint32_t i = 0; i < 100; ++i)
+	{
+		if(i % 2 == 0)
+			strip.insert(strip.end(), { i, i + 1, i + 2 });
+		else
+			strip.insert(strip.end(), { i + 1, i, i + 2 });
+	}
+
+	std::vector<std::uint32_t> optimized = strip;
+	MeshOptimize::OptimizeVertexCache(optimized.data(), optimized.size(), 102);
+	CHECK(Acmr(optimized, 102) <= Acmr(strip, 102));
+	CHECK(Canonical(optimized) == Canonical(strip));
+}
+
+TEST_CASE(VertexFetchRemapsByFirstUse)
+{
+	const std::uint32_t n = 40;
+	std::vector<std::uint32_t> indices = ShuffleTriangles(MakeGrid(n), 32);
+	const std::size_t vertexCount = n*n + 7; // 7 unused vertices
+	std::vector<std::uint32_t> original = indices;
+
+	std::vector<std::uint32_t> remap = MeshOptimize::OptimizeVertexFetch(indices.data(), indices.size(), vertexCount);
+	CHECK(remap.size() == vertexCount);
+
+	// remap is a permutation and maps the old triangles onto the new ones.
+	std::vector<std::uint32_t> sorted = remap;
+	std::sort(sorted.begin(), sorted.end());
+	bool permutation = true;
+	for(std::size_t i = 0; i < sorted.size(); ++i)
+		permutation = permutation && sorted[i] == i;
+	CHECK(permutation);
+	CHECK(Canonical(original, &remap) == Canonical(indices));
+
+	// New indices appear in increasing order and unused vertices go last.
+	std::uint32_t next = 0;
+	bool firstUse = true;
+	for(std::uint32_t v : indices)
+	{
+		if(v == next)
+			++next;
+		firstUse = firstUse && v < next;
+	}
+	CHECK(firstUse && next == n*n);
+	for(std::uint32_t v = n*n; v < vertexCount; ++v)
+		CHECK(remap[v] >= n*n);
+
+	// RemapVertices moves each vertex to its new slot.
+	std::vector<std::uint32_t> vertices(vertexCount);
+	for(std::uint32_t v = 0; v < vertexCount; ++v)
+		vertices[v] = v;
+	MeshOptimize::RemapVertices(vertices, remap);
+	for(std::uint32_t v = 0; v < vertexCount; ++v)
+		CHECK(vertices[remap[v]] == v);
+}
+
+TEST_CASE(CarAcmrDoesNotRegress)
+{
+	TextMesh car;
+	std::string error;
+	CHECK(MeshTextParser::Load(MODELS_DIR "car.txt", car, error, 1));
+	if(car.Indices.empty())
+		return;
+
+	const std::size_t vertexCount = car.Vertices.size();
+	std::vector<std::uint32_t> indices = car.Indices;
+	float before = Acmr(indices, vertexCount);
+
+	MeshOptimize::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+	float after = Acmr(indices, vertexCount);
+	CHECK(Canonical(indices) == Canonical(car.Indices));
+
+	// 1.258 before and 1.115 after when this test was written.
+	CHECK(after < before);
+	CHECK(after <= 1.12f);
+
+	std::vector<std::uint32_t> remap = MeshOptimize::OptimizeVertexFetch(indices.data(), indices.size(), vertexCount);
+	CHECK(Acmr(indices, vertexCount) == after);
+	CHECK(remap.size() == vertexCount);
+}
@@ -0,0 +1,92 @@
+//***************************************************************************************
+// MeshSimplifyBench.cpp
+//
+// Builds the level of detail chain of Models/skull.txt with the settings the app bakes
+// it with (MeshBakeSettings, without the error limit) on one thread and on every
+// hardware thread, and prints the time, triangle count and error of each level.  The
+// time of a level is that of simplifying the full mesh to its triangle count.  Not run
+// by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "MeshBake.h"
+#include "MeshSimplify.h"
+#include "MeshTextParser.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+int main()
+{
+	std::ifstream fin(MODELS_DIR "skull.txt", std::ios::binary);
+	std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+	TextMesh mesh;
+	std::string error;
+	if(!MeshTextParser::Parse(text.data(), text.size(), "skull.txt", mesh, error))
+	{
+		std::fprintf(stderr, "%s\n", text.empty() ? "cannot read " MODELS_DIR "skull.txt" : error.c_str());
+		return 1;
+	}
+
+	float minP[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxP[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for(const TextMeshVertex& v : mesh.Vertices)
+	{
+		for(int a = 0; a < 3; ++a)
+		{
+			minP[a] = (std::min)(minP[a], v.Position[a]);
+			maxP[a] = (std::max)(maxP[a], v.Position[a]);
+		}
+	}
+	const float diagonal = std::sqrt((maxP[0] - minP[0])*(maxP[0] - minP[0]) +
+		(maxP[1] - minP[1])*(maxP[1] - minP[1]) + (maxP[2] - minP[2])*(maxP[2] - minP[2]));
+
+	const MeshBakeSettings settings;
+	const MeshSimplifier simplifier(mesh.Vertices[0].Position, sizeof(TextMeshVertex), mesh.Vertices.size());
+	const unsigned threads = (std::max)(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned> threadCounts = { 1 };
+	if(threads > 1)
+		threadCounts.push_back(threads);
+	const int Runs = 3;
+
+	std::vector<LodLevel> lods;
+	for(unsigned threadCount : threadCounts)
+	{
+		double seconds = Bench::BestOf(Runs, [&]
+		{
+			lods = simplifier.BuildLodChain(mesh.Indices, settings.LodCount, settings.LodReduction, 0.0f, threadCount);
+		});
+		std::printf("chain of %zu levels, %2u thread(s): %8.2f ms\n", lods.size(), threadCount, seconds*1e3);
+	}
+
+	std::printf("\nlevel   triangles   error   error/diagonal");
+	for(unsigned threadCount : threadCounts)
+		std::printf("   %2u thread(s) ms", threadCount);
+	std::printf("\n");
+
+	for(std::size_t i = 0; i < lods.size(); ++i)
+	{
+		const std::size_t triangles = lods[i].Indices.size()/3;
+		std::printf("%5zu   %9zu   %5.3f   %14.5f", i, triangles, lods[i].Error, lods[i].Error/diagonal);
+		for(unsigned threadCount : threadCounts)
+		{
+			double seconds = 0.0;
+			if(i > 0)
+			{
+				seconds = Bench::BestOf(Runs, [&]
+				{
+					Bench::Use(simplifier.Simplify(mesh.Indices, triangles, 0.0f, threadCount).Indices.data());
+				});
+			}
+			std::printf("   %16.2f", seconds*1e3);
+		}
+		std::printf("\n");
+	}
+	return 0;
+}
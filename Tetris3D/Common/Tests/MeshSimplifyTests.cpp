@@ -0,0 +1,302 @@
+//***************************************************************************************
+// MeshSimplifyTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "MeshSimplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<float> Positions; // xyz per vertex
+		std::vector<std::uint32_t> Indices;
+
+		std::size_t VertexCount()const { return Positions.size() / 3; }
+		const float* Position(std::uint32_t v)const { return &Positions[v*3]; }
+
+		// Welds vertices at the same position so the mesh is closed.
+		std::uint32_t Vertex(float x, float y, float z)
+		{
+			auto key = std::make_tuple(std::lround(x*1e4f), std::lround(y*1e4f), std::lround(z*1e4f));
+			auto it = mWeld.find(key);
+			if(it != mWeld.end())
+				return it->second;
+
+			std::uint32_t v = static_cast<std::uint32_t>(VertexCount());
+			Positions.insert(Positions.end(), { x, y, z });
+			mWeld[key] = v;
+			return v;
+		}
+
+	private:
+		std::map<std::tuple<long, long, long>, std::uint32_t> mWeld;
+	};
+
+	// Cube [-1, 1]^3 with each face split into n x n quads.
+	TestMesh MakeCube(int n)
+	{
+		TestMesh mesh;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			for(float side : { -1.0f, 1.0f })
+			{
+				std::vector<std::uint32_t> grid;
+				for(int j = 0; j <= n; ++j)
+				{
+					for(int i = 0; i <= n; ++i)
+					{
+						float p[3];
+						p[axis] = side;
+						p[(axis + 1) % 3] = -1.0f + 2.0f*i/n;
+						p[(axis + 2) % 3] = -1.0f + 2.0f*j/n;
+						grid.push_back(mesh.Vertex(p[0], p[1], p[2]));
+					}
+				}
+
+				for(int j = 0; j < n; ++j)
+				{
+					for(int i = 0; i < n; ++i)
+					{
+						std::uint32_t a = grid[j*(n + 1) + i], b = grid[j*(n + 1) + i + 1];
+						std::uint32_t c = grid[(j + 1)*(n + 1) + i], d = grid[(j + 1)*(n + 1) + i + 1];
+						if(side > 0.0f)
+							mesh.Indices.insert(mesh.Indices.end(), { a, b, d, a, d, c });
+						else
+							mesh.Indices.insert(mesh.Indices.end(), { a, d, b, a, c, d });
+					}
+				}
+			}
+		}
+		return mesh;
+	}
+
+	// Unit sphere made of stacks x slices quads.
+	TestMesh MakeSphere(int stacks, int slices)
+	{
+		const float pi = 3.14159265f;
+		TestMesh mesh;
+		std::vector<std::uint32_t> grid;
+		for(int j = 0; j <= stacks; ++j)
+		{
+			float phi = pi*j/stacks;
+			for(int i = 0; i <= slices; ++i)
+			{
+				float theta = 2.0f*pi*(i % slices)/slices;
+				float x = j == 0 || j == stacks ? 0.0f : std::sin(phi)*std::cos(theta);
+				float z = j == 0 || j == stacks ? 0.0f : std::sin(phi)*std::sin(theta);
+				grid.push_back(mesh.Vertex(x, std::cos(phi), z));
+			}
+		}
+
+		for(int j = 0; j < stacks; ++j)
+		{
+			for(int i = 0; i < slices; ++i)
+			{
+				std::uint32_t a = grid[j*(slices + 1) + i], b = grid[j*(slices + 1) + i + 1];
+				std::uint32_t c = grid[(j + 1)*(slices + 1) + i], d = grid[(j + 1)*(slices + 1) + i + 1];
+				if(j != 0)
+					mesh.Indices.insert(mesh.Indices.end(), { a, b, c });
+				if(j != stacks - 1)
+					mesh.Indices.insert(mesh.Indices.end(), { b, d, c });
+			}
+		}
+		return mesh;
+	}
+
+	// Every triangle references existing vertices and none is degenerate.
+	bool IsValid(const TestMesh& mesh, const std::vector<std::uint32_t>& indices)
+	{
+		if(indices.size() % 3 != 0)
+			return false;
+
+		for(std::size_t t = 0; t < indices.size(); t += 3)
+		{
+			std::uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+			if(a >= mesh.VertexCount() || b >= mesh.VertexCount() || c >= mesh.VertexCount())
+				return false;
+			if(a == b || b == c || a == c)
+				return false;
+		}
+		return true;
+	}
+
+	float SignedVolume(const TestMesh& mesh, const std::vector<std::uint32_t>& indices)
+	{
+		double volume = 0.0;
+		for(std::size_t t = 0; t < indices.size(); t += 3)
+		{
+			const float* a = mesh.Position(indices[t]);
+			const float* b = mesh.Position(indices[t + 1]);
+			const float* c = mesh.Position(indices[t + 2]);
+			volume += a[0]*(b[1]*c[2] - b[2]*c[1]) - a[1]*(b[0]*c[2] - b[2]*c[0]) + a[2]*(b[0]*c[1] - b[1]*c[0]);
+		}
+		return static_cast<float>(volume / 6.0);
+	}
+
+	// Largest distance from an original vertex to the plane of the nearest simplified
+	// triangle it projects into.  For a convex mesh this is the surface deviation.
+	float MaxDeviation(const TestMesh& mesh, const std::vector<std::uint32_t>& indices)
+	{
+		float worst = 0.0f;
+		for(std::uint32_t v = 0; v < mesh.VertexCount(); ++v)
+		{
+			const float* p = mesh.Position(v);
+			float best = HUGE_VALF;
+			for(std::size_t t = 0; t < indices.size(); t += 3)
+			{
+				const float* a = mesh.Position(indices[t]);
+				const float* b = mesh.Position(indices[t + 1]);
+				const float* c = mesh.Position(indices[t + 2]);
+
+				// Ray from the center through p against the triangle's plane.
+				float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				float n[3] = { e0[1]*e1[2] - e0[2]*e1[1], e0[2]*e1[0] - e0[0]*e1[2], e0[0]*e1[1] - e0[1]*e1[0] };
+				float np = n[0]*p[0] + n[1]*p[1] + n[2]*p[2];
+				if(np <= 0.0f)
+					continue;
+				float s = (n[0]*a[0] + n[1]*a[1] + n[2]*a[2]) / np;
+				float q[3] = { s*p[0], s*p[1], s*p[2] };
+
+				// Inside test with barycentric signs.
+				bool inside = true;
+				const float* corners[3] = { a, b, c };
+				for(int k = 0; k < 3 && inside; ++k)
+				{
+					const float* u = corners[k];
+					const float* w = corners[(k + 1) % 3];
+					float ux = w[0] - u[0], uy = w[1] - u[1], uz = w[2] - u[2];
+					float qx = q[0] - u[0], qy = q[1] - u[1], qz = q[2] - u[2];
+					float cx = uy*qz - uz*qy, cy = uz*qx - ux*qz, cz = ux*qy - uy*qx;
+					inside = cx*n[0] + cy*n[1] + cz*n[2] >= -1e-6f;
+				}
+				if(!inside)
+					continue;
+
+				float len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+				best = std::min(best, std::fabs(np - (n[0]*a[0] + n[1]*a[1] + n[2]*a[2])) / len);
+			}
+			worst = std::max(worst, best);
+		}
+		return worst;
+	}
+}
+
+TEST_CASE(FlatCubeFacesCollapseToTwelveTriangles)
+{
+	TestMesh cube = MakeCube(8);
+	CHECK(cube.VertexCount() == 6*9*9 - 12*9 + 8);
+	CHECK(cube.Indices.size() / 3 == 6*8*8*2);
+
+	MeshSimplifier simplifier(cube.Positions.data(), 3*sizeof(float), cube.VertexCount());
+	LodLevel level = simplifier.Simplify(cube.Indices, 12, 0.0f, 1);
+
+	// Every collapse on a flat face is free; the corners cannot move.
+	CHECK(level.Indices.size() / 3 == 12);
+	CHECK(level.Error < 1e-4f);
+	CHECK(IsValid(cube, level.Indices));
+	CHECK(std::fabs(SignedVolume(cube, level.Indices) - 8.0f) < 1e-4f);
+
+	for(std::uint32_t v : level.Indices)
+	{
+		const float* p = cube.Position(v);
+		CHECK(std::fabs(p[0]) == 1.0f && std::fabs(p[1]) == 1.0f && std::fabs(p[2]) == 1.0f);
+	}
+}
+
+TEST_CASE(ReachesTriangleTargets)
+{
+	TestMesh sphere = MakeSphere(24, 48);
+	const std::size_t triCount = sphere.Indices.size() / 3;
+	CHECK(triCount == 2*48*23);
+
+	MeshSimplifier simplifier(sphere.Positions.data(), 3*sizeof(float), sphere.VertexCount());
+	for(std::size_t target : { triCount, triCount - 1, triCount / 2, triCount / 8, std::size_t(100) })
+	{
+		LodLevel level = simplifier.Simplify(sphere.Indices, target, 0.0f, 1);
+		std::size_t count = level.Indices.size() / 3;
+
+		// Each collapse removes two triangles of a closed mesh.
+		CHECK(count <= target && count + 2 >= target);
+		CHECK(IsValid(sphere, level.Indices));
+	}
+}
+
+TEST_CASE(ErrorBoundsTheSurfaceDeviation)
+{
+	TestMesh sphere = MakeSphere(16, 32);
+	const std::size_t triCount = sphere.Indices.size() / 3;
+	MeshSimplifier simplifier(sphere.Positions.data(), 3*sizeof(float), sphere.VertexCount());
+
+	float lastError = 0.0f;
+	for(std::size_t target : { triCount / 2, triCount / 4, triCount / 8 })
+	{
+		LodLevel level = simplifier.Simplify(sphere.Indices, target, 0.0f, 1);
+		float deviation = MaxDeviation(sphere, level.Indices);
+
+		CHECK(deviation <= level.Error);
+		CHECK(level.Error >= lastError);
+		CHECK(SignedVolume(sphere, level.Indices) > 0.0f);
+		lastError = level.Error;
+	}
+
+	// A tight limit stops the collapses before the target and is respected.
+	const float maxError = 0.02f;
+	LodLevel limited = simplifier.Simplify(sphere.Indices, 10, maxError, 1);
+	CHECK(limited.Indices.size() / 3 > 10);
+	CHECK(limited.Error <= maxError);
+	CHECK(MaxDeviation(sphere, limited.Indices) <= maxError);
+}
+
+TEST_CASE(ParallelRegionsKeepTheMeshValid)
+{
+	// Large enough to be split into slabs.
+	TestMesh sphere = MakeSphere(96, 192);
+	const std::size_t triCount = sphere.Indices.size() / 3;
+	MeshSimplifier simplifier(sphere.Positions.data(), 3*sizeof(float), sphere.VertexCount());
+
+	LodLevel serial = simplifier.Simplify(sphere.Indices, triCount / 10, 0.0f, 1);
+	LodLevel parallel = simplifier.Simplify(sphere.Indices, triCount / 10, 0.0f, 4);
+
+	CHECK(parallel.Indices.size() / 3 <= triCount / 10);
+	CHECK(IsValid(sphere, parallel.Indices));
+	CHECK(std::fabs(SignedVolume(sphere, parallel.Indices) - SignedVolume(sphere, serial.Indices)) < 0.01f);
+	CHECK(parallel.Error < 2.0f*serial.Error);
+}
+
+TEST_CASE(LodChainAndSelection)
+{
+	TestMesh sphere = MakeSphere(24, 48);
+	MeshSimplifier simplifier(sphere.Positions.data(), 3*sizeof(float), sphere.VertexCount());
+
+	std::vector<LodLevel> chain = simplifier.BuildLodChain(sphere.Indices, 4, 0.5f, 0.0f, 1);
+	CHECK(chain.size() == 4);
+	CHECK(chain[0].Indices == sphere.Indices && chain[0].Error == 0.0f);
+
+	std::vector<float> errors;
+	for(std::size_t i = 0; i < chain.size(); ++i)
+	{
+		errors.push_back(chain[i].Error);
+		if(i > 0)
+		{
+			CHECK(chain[i].Indices.size() < chain[i - 1].Indices.size());
+			CHECK(chain[i].Error >= chain[i - 1].Error);
+		}
+	}
+
+	// Close up the full mesh, far away the coarsest level.
+	CHECK(MeshSimplifier::SelectLod(errors, 1.0f, 1e6f) == 0);
+	CHECK(MeshSimplifier::SelectLod(errors, 1.0f, 1.0f) == chain.size() - 1);
+
+	// The chain stops once the accumulated error would pass the limit.
+	std::vector<LodLevel> limited = simplifier.BuildLodChain(sphere.Indices, 10, 0.5f, chain[2].Error, 1);
+	CHECK(limited.size() >= 2);
+	CHECK(limited.back().Error <= chain[2].Error);
+}
@@ -0,0 +1,120 @@
+//***************************************************************************************
+// MeshTextParserBench.cpp
+//
+// Load time of Models/skull.txt with MeshTextParser, on one thread and on every
+// hardware thread, against the ifstream >> loop GeometryGenerator::CreateFromFile used
+// before it.  Both read the file (from the page cache after the warm-up run); the
+// parse alone from memory is reported too.  Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "MeshTextParser.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// The loader MeshTextParser replaced, reading into a TextMesh.
+	bool StreamLoad(const char* path, TextMesh& mesh)
+	{
+		std::ifstream fin(path);
+		if(!fin)
+			return false;
+
+		std::uint32_t vcount = 0;
+		std::uint32_t tcount = 0;
+		std::string ignore;
+
+		fin >> ignore >> vcount;
+		fin >> ignore >> tcount;
+		fin >> ignore >> ignore >> ignore >> ignore;
+
+		mesh.Vertices.resize(vcount);
+		mesh.Indices.resize(tcount*3);
+
+		for(std::uint32_t i = 0; i < vcount; ++i)
+		{
+			TextMeshVertex& v = mesh.Vertices[i];
+			fin >> v.Position[0] >> v.Position[1] >> v.Position[2];
+			fin >> v.Normal[0] >> v.Normal[1] >> v.Normal[2];
+		}
+
+		fin >> ignore;
+		fin >> ignore;
+		fin >> ignore;
+
+		for(std::uint32_t i = 0; i < tcount; ++i)
+			fin >> mesh.Indices[i*3 + 0] >> mesh.Indices[i*3 + 1] >> mesh.Indices[i*3 + 2];
+
+		return !fin.fail();
+	}
+}
+
+int main()
+{
+	const char* path = MODELS_DIR "skull.txt";
+	std::ifstream fin(path, std::ios::binary);
+	std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+	if(text.empty())
+	{
+		std::fprintf(stderr, "cannot read %s\n", path);
+		return 1;
+	}
+
+	const int Runs = 20;
+	bool ok = true;
+
+	TextMesh reference;
+	double stream = Bench::BestOf(5, [&]
+	{
+		TextMesh mesh;
+		ok = StreamLoad(path, mesh) && ok;
+		reference = std::move(mesh);
+	});
+	std::printf("ifstream >>:          %7.2f ms, %7.1f MB/s\n", stream*1e3, text.size()/stream/1e6);
+
+	std::vector<unsigned> threadCounts = { 1 };
+	unsigned threads = std::thread::hardware_concurrency();
+	if(threads > 1)
+		threadCounts.push_back(threads);
+
+	for(unsigned threadCount : threadCounts)
+	{
+		std::string error;
+		TextMesh mesh;
+		double load = Bench::BestOf(Runs, [&]
+		{
+			ok = MeshTextParser::Load(path, mesh, error, threadCount) && ok;
+		});
+
+		double parse = Bench::BestOf(Runs, [&]
+		{
+			ok = MeshTextParser::Parse(text.data(), text.size(), "skull.txt", mesh, error, threadCount) && ok;
+		});
+
+		// Both loaders must read the same mesh.
+		ok = ok && mesh.Indices == reference.Indices && mesh.Vertices.size() == reference.Vertices.size() &&
+			std::equal(mesh.Vertices.begin(), mesh.Vertices.end(), reference.Vertices.begin(),
+				[](const TextMeshVertex& a, const TextMeshVertex& b)
+			{
+				return std::equal(a.Position, a.Position + 3, b.Position) && std::equal(a.Normal, a.Normal + 3, b.Normal);
+			});
+
+		std::printf("Load, %2u thread(s):   %7.2f ms, %7.1f MB/s, %5.1fx the ifstream loop\n",
+			threadCount, load*1e3, text.size()/load/1e6, stream/load);
+		std::printf("Parse, %2u thread(s):  %7.2f ms, %7.1f MB/s, %5.1fx the ifstream loop\n",
+			threadCount, parse*1e3, text.size()/parse/1e6, stream/parse);
+	}
+
+	if(!ok)
+	{
+		std::fprintf(stderr, "the loaders disagree or failed\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+//***************************************************************************************
+// MeshTextParserTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "MeshTextParser.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	// Mesh text with the given counts, vertex lines and triangle lines.
+	std::string MeshText(const std::string& vertexCount, const std::string& triangleCount,
+		const std::string& vertices, const std::string& triangles)
+	{
+		return "VertexCount: " + vertexCount + "\n" +
+			"TriangleCount: " + triangleCount + "\n" +
+			"VertexList (pos, normal)\n{\n" + vertices + "}\n" +
+			"TriangleList\n{\n" + triangles + "}\n";
+	}
+
+	const char* const ThreeVertices =
+		"\t0 0 0 0 0 1\n"
+		"\t1 0 0 0 0 1\n"
+		"\t0 1 0 0 0 1\n";
+
+	// Parses text and returns the error, or an empty string on success.
+	std::string ParseError(const std::string& text, unsigned threadCount = 1)
+	{
+		TextMesh mesh;
+		std::string error;
+		if(MeshTextParser::Parse(text.data(), text.size(), "m.txt", mesh, error, threadCount))
+			return std::string();
+
+		// A failed parse leaves nothing behind.
+		CHECK(mesh.Vertices.empty() && mesh.Indices.empty());
+		return error;
+	}
+
+	// A grid of quads large enough to be split into several chunks.
+	std::string LargeMeshText(int size)
+	{
+		std::string vertices;
+		std::string triangles;
+		int triangleCount = 0;
+		for(int y = 0; y < size; ++y)
+		{
+			for(int x = 0; x < size; ++x)
+			{
+				vertices += "\t" + std::to_string(x*0.125) + " -" + std::to_string(y) + ".5 1e-3 0 0.6 0.8\n";
+				if(x + 1 < size && y + 1 < size)
+				{
+					int i = y*size + x;
+					triangles += "\t" + std::to_string(i) + " " + std::to_string(i + 1) + " " + std::to_string(i + size) + "\n";
+					triangles += "\t" + std::to_string(i + 1) + " " + std::to_string(i + size + 1) + " " + std::to_string(i + size) + "\n";
+					triangleCount += 2;
+				}
+			}
+		}
+		return MeshText(std::to_string(size*size), std::to_string(triangleCount), vertices, triangles);
+	}
+}
+
+TEST_CASE(ParsesASmallMesh)
+{
+	std::string text = MeshText("3", "1", "\t-1.5 2 3.25 0 -1 0\n\t1e2 0.001 -0 0 0 1\n\t0 0 0 1 0 0\n", "\t2 0 1\n");
+	TextMesh mesh;
+	std::string error;
+	CHECK(MeshTextParser::Parse(text.data(), text.size(), "m.txt", mesh, error));
+	CHECK(mesh.Vertices.size() == 3 && mesh.Indices.size() == 3);
+	if(mesh.Vertices.size() != 3 || mesh.Indices.size() != 3)
+		return;
+
+	CHECK(mesh.Vertices[0].Position[0] == -1.5f && mesh.Vertices[0].Position[2] == 3.25f);
+	CHECK(mesh.Vertices[0].Normal[1] == -1.0f);
+	CHECK(mesh.Vertices[1].Position[0] == 100.0f && mesh.Vertices[1].Position[1] == 0.001f);
+	CHECK(mesh.Vertices[2].Normal[0] == 1.0f);
+	CHECK(mesh.Indices[0] == 2 && mesh.Indices[1] == 0 && mesh.Indices[2] == 1);
+
+	// Line breaks are not significant and the last value may touch the brace.
+	std::string compact = "VertexCount: 3 TriangleCount: 1 VertexList\n{0 0 0 0 0 1 1 0 0 0 0 1 0 1 0 0 0 1}TriangleList{0 1 2}";
+	CHECK(ParseError(compact).empty());
+}
+
+TEST_CASE(FastPathMatchesFromChars)
+{
+	// Numbers on both sides of the fast path limits: 2^24, 9 digits, exponents.
+	const char* numbers[] = { "0.1", "-0.796365", "16777216", "16777217", "1.6777217", "0.000000001",
+		"123456789", "1234567891", "3.4e38", "1e-3", "-0", "0.30000001", "5.5759" };
+
+	std::string vertices;
+	for(const char* n : numbers)
+		vertices += std::string("\t") + n + " 0 0 0 0 0\n";
+	std::string text = MeshText(std::to_string(std::size(numbers)), "0", vertices, "");
+
+	TextMesh mesh;
+	std::string error;
+	CHECK(MeshTextParser::Parse(text.data(), text.size(), "m.txt", mesh, error));
+	CHECK(mesh.Vertices.size() == std::size(numbers));
+	for(std::size_t i = 0; i < mesh.Vertices.size(); ++i)
+		CHECK(mesh.Vertices[i].Position[0] == std::strtof(numbers[i], nullptr));
+}
+
+TEST_CASE(RejectsCountsLargerThanTheFile)
+{
+	// Before the lists are allocated: these would need gigabytes.
+	CHECK(ParseError(MeshText("4000000000", "1", ThreeVertices, "0 1 2\n")) ==
+		"m.txt:1: count 4000000000 does not fit in the file.");
+	CHECK(ParseError(MeshText("3", "4000000000", ThreeVertices, "0 1 2\n")) ==
+		"m.txt:2: count 4000000000 does not fit in the file.");
+
+	// Each count fits on its own but not both together.
+	std::string padding(40, ' ');
+	CHECK(ParseError(MeshText("4", "4", padding, "")) == "m.txt:3: vertex and triangle counts do not fit in the file.");
+
+	CHECK(ParseError(MeshText("99999999999", "1", ThreeVertices, "0 1 2\n")) == "m.txt:1: expected a count.");
+	CHECK(ParseError(MeshText("-3", "1", ThreeVertices, "0 1 2\n")) == "m.txt:1: expected a count.");
+}
+
+TEST_CASE(RejectsWrongCounts)
+{
+	// Too few values: reported at the closing brace.
+	CHECK(ParseError(MeshText("4", "1", ThreeVertices, "0 1 2\n")) == "m.txt:8: expected 24 values, found 18.");
+	CHECK(ParseError(MeshText("3", "2", ThreeVertices, "0 1 2\n")) == "m.txt:12: expected 6 values, found 3.");
+
+	// Too many: reported at the first value that does not fit.
+	CHECK(ParseError(MeshText("2", "1", ThreeVertices, "0 1 1\n")) == "m.txt:7: expected 12 values.");
+	CHECK(ParseError(MeshText("3", "1", ThreeVertices, "0 1 2\n2 1 0\n")) == "m.txt:12: expected 3 values.");
+
+	// Half a vertex.
+	CHECK(ParseError(MeshText("3", "1", std::string(ThreeVertices) + "1 2 3\n", "0 1 2\n")) == "m.txt:8: expected 18 values.");
+}
+
+TEST_CASE(ReportsTheLineOfMalformedInput)
+{
+	CHECK(ParseError("") == "m.txt:1: expected 'VertexCount:'.");
+	CHECK(ParseError("VertexCount 3\n") == "m.txt:1: expected 'VertexCount:'.");
+	CHECK(ParseError("VertexCount: 0\nTriangles: 0\n") == "m.txt:2: expected 'TriangleCount:'.");
+
+	CHECK(ParseError(MeshText("3", "1", "\t0 0 0 0 0 1\n\t1 0 0 0 0 x\n\t0 1 0 0 0 1\n", "0 1 2\n")) ==
+		"m.txt:6: malformed number.");
+	CHECK(ParseError(MeshText("3", "1", "\t0 0 0 0 0 1\n\t1 0 0 0 0 1.5.5\n\t0 1 0 0 0 1\n", "0 1 2\n")) ==
+		"m.txt:6: malformed number.");
+	CHECK(ParseError(MeshText("3", "1", "\t0 0 0 0 0 1\n\t1 0 0 0 0 1\n\t0 1e99 0 0 0 1\n", "0 1 2\n")) ==
+		"m.txt:7: number out of range.");
+	CHECK(ParseError(MeshText("3", "1", ThreeVertices, "0 1 3\n")) == "m.txt:11: index 3 is out of range.");
+	CHECK(ParseError(MeshText("3", "1", ThreeVertices, "0 -1 2\n")) == "m.txt:11: malformed number.");
+
+	// Missing braces and keywords.
+	std::string text = MeshText("3", "1", ThreeVertices, "0 1 2\n");
+	CHECK(ParseError(text.substr(0, text.size() - 2)) == "m.txt:12: expected '}'.");
+	std::string noTriangleList = text;
+	noTriangleList.replace(noTriangleList.find("TriangleList"), 12, "Triangles   ");
+	CHECK(ParseError(noTriangleList) == "m.txt:9: expected 'TriangleList'.");
+}
+
+TEST_CASE(ChunksMatchOneThread)
+{
+	std::string text = LargeMeshText(200);
+	CHECK(text.size() > 4*128*1024);
+
+	TextMesh single;
+	TextMesh split;
+	std::string error;
+	CHECK(MeshTextParser::Parse(text.data(), text.size(), "m.txt", single, error, 1));
+	CHECK(MeshTextParser::Parse(text.data(), text.size(), "m.txt", split, error, 8));
+	CHECK(single.Vertices.size() == 200*200 && single.Indices.size() == 199*199*6);
+	CHECK(split.Vertices.size() == single.Vertices.size() && split.Indices == single.Indices);
+	CHECK(std::memcmp(split.Vertices.data(), single.Vertices.data(), single.Vertices.size()*sizeof(TextMeshVertex)) == 0);
+	CHECK(single.Vertices[201].Position[0] == 0.125f && single.Vertices[201].Position[1] == -1.5f);
+
+	// An error deep in a later chunk is found and reported with its own line.
+	std::size_t line = 4 + 30000;
+	std::size_t at = 0;
+	for(std::size_t i = 1; i < line; ++i)
+		at = text.find('\n', at) + 1;
+	std::string bad = text;
+	bad[text.find(' ', at)] = ',';
+	std::string expected = "m.txt:" + std::to_string(line) + ": malformed number.";
+	CHECK(ParseError(bad, 1) == expected);
+	CHECK(ParseError(bad, 8) == expected);
+}
+
+TEST_CASE(ParsesTheShippedModels)
+{
+	TextMesh mesh;
+	std::string error;
+	CHECK(MeshTextParser::Load(MODELS_DIR "car.txt", mesh, error));
+	CHECK(mesh.Vertices.size() == 1860 && mesh.Indices.size() == 1850*3);
+	CHECK(mesh.Vertices.size() > 0 && mesh.Vertices[0].Position[0] == -1.65064f && mesh.Vertices[0].Normal[2] == -0.870484f);
+
+	CHECK(!MeshTextParser::Load(MODELS_DIR "missing.txt", mesh, error));
+	CHECK(error == MODELS_DIR "missing.txt: cannot open file.");
+}
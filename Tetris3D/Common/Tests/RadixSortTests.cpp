@@ -0,0 +1,89 @@
+//***************************************************************************************
+// RadixSortTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Sorts a copy with RadixSort and with std::stable_sort and compares keys and
+	// payloads, so both order and stability are checked.
+	bool MatchesStableSort(std::vector<SortKeyEntry> entries)
+	{
+		for(std::size_t i = 0; i < entries.size(); ++i)
+			entries[i].Value = static_cast<std::uint32_t>(i);
+
+		std::vector<SortKeyEntry> expected = entries;
+		std::stable_sort(expected.begin(), expected.end(),
+			[](const SortKeyEntry& a, const SortKeyEntry& b) { return a.Key < b.Key; });
+
+		std::vector<SortKeyEntry> scratch(entries.size());
+		RadixSort(entries.data(), scratch.data(), entries.size());
+
+		for(std::size_t i = 0; i < entries.size(); ++i)
+		{
+			if(entries[i].Key != expected[i].Key || entries[i].Value != expected[i].Value)
+				return false;
+		}
+		return true;
+	}
+
+	std::vector<SortKeyEntry> RandomKeys(std::size_t count, std::uint64_t mask, unsigned seed)
+	{
+		std::mt19937_64 rng(seed);
+		std::vector<SortKeyEntry> entries(count);
+		for(SortKeyEntry& e : entries)
+			e.Key = rng() & mask;
+		return entries;
+	}
+}
+
+TEST_CASE(MatchesStableSortOnRandomKeys)
+{
+	CHECK(MatchesStableSort(RandomKeys(100000, ~0ull, 1)));
+	CHECK(MatchesStableSort(RandomKeys(1000, ~0ull, 2)));
+	CHECK(MatchesStableSort(RandomKeys(77, ~0ull, 3)));
+}
+
+TEST_CASE(IsStableWithManyDuplicates)
+{
+	// Few distinct keys spread over several bytes, so equal keys must keep their order
+	// through every pass.
+	CHECK(MatchesStableSort(RandomKeys(5000, 0x0300000000000103ull, 4)));
+	CHECK(MatchesStableSort(RandomKeys(5000, 0xff00000000000000ull, 5)));
+}
+
+TEST_CASE(HandlesAllEqualKeys)
+{
+	std::vector<SortKeyEntry> entries(1000);
+	for(SortKeyEntry& e : entries)
+		e.Key = 0x0123456789abcdefull;
+	CHECK(MatchesStableSort(entries));
+
+	for(SortKeyEntry& e : entries)
+		e.Key = 0;
+	CHECK(MatchesStableSort(entries));
+}
+
+TEST_CASE(HandlesTinyInputs)
+{
+	CHECK(MatchesStableSort(std::vector<SortKeyEntry>()));
+	CHECK(MatchesStableSort(RandomKeys(1, ~0ull, 6)));
+	CHECK(MatchesStableSort(RandomKeys(2, ~0ull, 7)));
+}
+
+TEST_CASE(HandlesSortedAndReversedInput)
+{
+	std::vector<SortKeyEntry> entries(4096);
+	for(std::size_t i = 0; i < entries.size(); ++i)
+		entries[i].Key = i*0x0001000100010001ull;
+	CHECK(MatchesStableSort(entries));
+
+	std::reverse(entries.begin(), entries.end());
+	CHECK(MatchesStableSort(entries));
+}
@@ -0,0 +1,281 @@
+//***************************************************************************************
+// RenderCommandStreamTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "RenderCommandStream.h"
+
+namespace
+{
+	typedef RecordingBackend::Call Call;
+
+	Call MakeCall(RenderCommand command, std::uint32_t a0, std::uint32_t a1 = 0, std::uint32_t a2 = 0, std::uint32_t a3 = 0)
+	{
+		Call call;
+		call.Command = command;
+		call.Args[0] = a0;
+		call.Args[1] = a1;
+		call.Args[2] = a2;
+		call.Args[3] = a3;
+		return call;
+	}
+
+	bool SameCalls(const std::vector<Call>& recorded, const std::vector<Call>& expected)
+	{
+		if(recorded.size() != expected.size())
+			return false;
+
+		for(std::size_t i = 0; i < recorded.size(); ++i)
+		{
+			if(recorded[i].Command != expected[i].Command)
+				return false;
+			for(int a = 0; a < 4; ++a)
+			{
+				if(recorded[i].Args[a] != expected[i].Args[a])
+					return false;
+			}
+		}
+		return true;
+	}
+
+	DrawPacket MakePacket(std::uint32_t pso, std::uint32_t geometry, std::uint32_t mesh, std::uint32_t object)
+	{
+		DrawPacket packet;
+		packet.PipelineState = pso;
+		packet.Geometry = geometry;
+		packet.Topology = 4;
+		packet.Mesh = mesh;
+		packet.ObjectConstants = object;
+		packet.IndexCount = 36;
+		packet.StartIndexLocation = 6*mesh;
+		packet.BaseVertexLocation = (std::int32_t)(8*mesh);
+		return packet;
+	}
+}
+
+TEST_CASE(ReplaysEncodedCommandsInOrder)
+{
+	RenderCommandStream stream;
+	RenderCommandEncoder encoder(stream);
+	encoder.SetPipelineState(3);
+	encoder.SetGeometry(1);
+	encoder.SetPrimitiveTopology(4);
+	encoder.SetMeshConstants(9);
+	encoder.SetObjectConstants(12);
+	encoder.SetInstanceRange(100);
+	encoder.DrawIndexedInstanced(36, 5, 72, -8);
+
+	RecordingBackend backend;
+	stream.Replay(backend);
+
+	const std::vector<Call> expected =
+	{
+		MakeCall(RenderCommand::SetPipelineState, 3),
+		MakeCall(RenderCommand::SetGeometry, 1),
+		MakeCall(RenderCommand::SetPrimitiveTopology, 4),
+		MakeCall(RenderCommand::SetMeshConstants, 9),
+		MakeCall(RenderCommand::SetObjectConstants, 12),
+		MakeCall(RenderCommand::SetInstanceRange, 100),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 36, 5, 72, (std::uint32_t)-8),
+	};
+	CHECK(SameCalls(backend.Calls(), expected));
+
+	// One word per command and argument.
+	CHECK(stream.Words().size() == 6*2 + 5);
+	CHECK(stream.BindCount() == 6 && stream.DrawCount() == 1 && stream.ElidedBindCount() == 0);
+}
+
+TEST_CASE(ElidesRedundantBinds)
+{
+	RenderCommandStream stream;
+	RenderCommandEncoder encoder(stream);
+
+	encoder.SetPipelineState(1);
+	encoder.SetGeometry(2);
+	encoder.DrawIndexedInstanced(3, 1, 0, 0);
+
+	// Same state again: only the changed object constants are bound.
+	encoder.SetPipelineState(1);
+	encoder.SetGeometry(2);
+	encoder.SetObjectConstants(7);
+	encoder.DrawIndexedInstanced(3, 1, 3, 0);
+
+	// A state that goes back to an earlier value is bound again.
+	encoder.SetPipelineState(0);
+	encoder.SetPipelineState(1);
+	encoder.DrawIndexedInstanced(3, 1, 6, 0);
+
+	// After Invalidate everything is bound.
+	encoder.Invalidate();
+	encoder.SetPipelineState(1);
+	encoder.SetGeometry(2);
+	encoder.DrawIndexedInstanced(3, 1, 9, 0);
+
+	RecordingBackend backend;
+	stream.Replay(backend);
+
+	const std::vector<Call> expected =
+	{
+		MakeCall(RenderCommand::SetPipelineState, 1),
+		MakeCall(RenderCommand::SetGeometry, 2),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 3, 1, 0, 0),
+		MakeCall(RenderCommand::SetObjectConstants, 7),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 3, 1, 3, 0),
+		MakeCall(RenderCommand::SetPipelineState, 0),
+		MakeCall(RenderCommand::SetPipelineState, 1),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 3, 1, 6, 0),
+		MakeCall(RenderCommand::SetPipelineState, 1),
+		MakeCall(RenderCommand::SetGeometry, 2),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 3, 1, 9, 0),
+	};
+	CHECK(SameCalls(backend.Calls(), expected));
+	CHECK(stream.BindCount() == 7);
+	CHECK(stream.ElidedBindCount() == 2);
+	CHECK(stream.DrawCount() == 4);
+}
+
+TEST_CASE(QueueSortsAndEncodesPackets)
+{
+	RenderQueue queue;
+
+	// Submitted out of order: two pipeline states, two meshes of one geometry.
+	queue.Submit(MakePacket(1, 0, 2, 10));
+	queue.Submit(MakePacket(0, 0, 1, 11));
+	queue.Submit(MakePacket(1, 0, 2, 12));
+	queue.Submit(MakePacket(0, 0, 2, 13));
+
+	// An instanced batch has no object constants.
+	DrawPacket instanced = MakePacket(0, 0, 1, DrawPacket::Unused);
+	instanced.FirstInstance = 40;
+	instanced.InstanceCount = 20;
+	queue.Submit(instanced);
+
+	queue.Sort();
+	RenderCommandStream stream;
+	queue.Encode(stream);
+
+	RecordingBackend backend;
+	stream.Replay(backend);
+
+	const std::vector<Call> expected =
+	{
+		MakeCall(RenderCommand::SetPipelineState, 0),
+		MakeCall(RenderCommand::SetGeometry, 0),
+		MakeCall(RenderCommand::SetPrimitiveTopology, 4),
+		MakeCall(RenderCommand::SetMeshConstants, 1),
+		MakeCall(RenderCommand::SetObjectConstants, 11),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 36, 1, 6, 8),
+		MakeCall(RenderCommand::SetInstanceRange, 40),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 36, 20, 6, 8),
+		MakeCall(RenderCommand::SetMeshConstants, 2),
+		MakeCall(RenderCommand::SetObjectConstants, 13),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 36, 1, 12, 16),
+		MakeCall(RenderCommand::SetPipelineState, 1),
+		MakeCall(RenderCommand::SetObjectConstants, 10),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 36, 1, 12, 16),
+		MakeCall(RenderCommand::SetObjectConstants, 12),
+		MakeCall(RenderCommand::DrawIndexedInstanced, 36, 1, 12, 16),
+	};
+	CHECK(SameCalls(backend.Calls(), expected));
+
+	// 5 draws bind pipeline state, geometry, topology and mesh each, 4 bind object
+	// constants and 1 an instance range: 25 binds, of which 14 are redundant.
+	CHECK(stream.DrawCount() == 5);
+	CHECK(stream.BindCount() == 11);
+	CHECK(stream.ElidedBindCount() == 14);
+}
+
+TEST_CASE(ManyDrawsOfOneStateBindItOnce)
+{
+	RenderQueue queue;
+	for(std::uint32_t i = 0; i < 230; ++i)
+		queue.Submit(MakePacket(i % 2, 0, 3, i));
+	queue.Sort();
+
+	RenderCommandStream stream;
+	queue.Encode(stream);
+	RecordingBackend backend;
+	stream.Replay(backend);
+
+	// Two pipeline states, one geometry, topology and mesh, an object slot per draw.
+	CHECK(stream.DrawCount() == 230);
+	CHECK(stream.BindCount() == 2 + 1 + 1 + 1 + 230);
+	CHECK(backend.Calls().size() == stream.BindCount() + stream.DrawCount());
+
+	std::uint32_t psoBinds = 0;
+	for(const Call& call : backend.Calls())
+		psoBinds += call.Command == RenderCommand::SetPipelineState ? 1 : 0;
+	CHECK(psoBinds == 2);
+}
+
+TEST_CASE(DrawKeyOrdersLayersFirst)
+{
+	// Every field of a later layer (e.g. transparent after opaque) maxed out or not,
+	// the layer decides.
+	const std::uint32_t maxDepth = (1u << DrawKey::DepthBits) - 1;
+	std::uint64_t lastOpaque = DrawKey::Make(0, 255, 15, 255, 4095, 1023, maxDepth);
+	std::uint64_t firstTransparent = DrawKey::Make(1, 0, 0, 0, 0, 0, 0);
+	CHECK(lastOpaque < firstTransparent);
+	CHECK(DrawKey::Make(1, 0, 0, 0, 0, 0, maxDepth) < DrawKey::Make(2, 0, 0, 0, 0, 0, 0));
+}
+
+TEST_CASE(DrawKeyOrdersStateBeforeDepth)
+{
+	// Fields in order of bind cost: each one outranks everything less significant.
+	const std::uint32_t maxDepth = (1u << DrawKey::DepthBits) - 1;
+	CHECK(DrawKey::Make(0, 0, 15, 255, 4095, 1023, maxDepth) < DrawKey::Make(0, 1, 0, 0, 0, 0, 0));
+	CHECK(DrawKey::Make(0, 1, 0, 255, 4095, 1023, maxDepth) < DrawKey::Make(0, 1, 1, 0, 0, 0, 0));
+	CHECK(DrawKey::Make(0, 1, 1, 0, 4095, 1023, maxDepth) < DrawKey::Make(0, 1, 1, 1, 0, 0, 0));
+	CHECK(DrawKey::Make(0, 1, 1, 1, 0, 1023, maxDepth) < DrawKey::Make(0, 1, 1, 1, 1, 0, 0));
+	CHECK(DrawKey::Make(0, 1, 1, 1, 1, 0, maxDepth) < DrawKey::Make(0, 1, 1, 1, 1, 1, 0));
+	CHECK(DrawKey::Make(0, 1, 1, 1, 1, 1, 0) < DrawKey::Make(0, 1, 1, 1, 1, 1, 1));
+}
+
+TEST_CASE(DrawKeyDrawsFrontToBack)
+{
+	const float nearZ = 1.0f;
+	const float farZ = 1000.0f;
+
+	CHECK(DrawKey::QuantizeDepth(nearZ, nearZ, farZ) == 0);
+	CHECK(DrawKey::QuantizeDepth(farZ, nearZ, farZ) == (1u << DrawKey::DepthBits) - 1);
+	CHECK(DrawKey::QuantizeDepth(-5.0f, nearZ, farZ) == 0);
+	CHECK(DrawKey::QuantizeDepth(5000.0f, nearZ, farZ) == (1u << DrawKey::DepthBits) - 1);
+
+	std::uint32_t last = 0;
+	bool monotonic = true;
+	for(float z = nearZ; z <= farZ; z += 0.37f)
+	{
+		std::uint32_t depth = DrawKey::QuantizeDepth(z, nearZ, farZ);
+		monotonic = monotonic && depth >= last;
+		last = depth;
+	}
+	CHECK(monotonic);
+
+	// Same state, submitted back to front: the queue draws the nearest first.
+	RenderQueue queue;
+	for(std::uint32_t i = 0; i < 4; ++i)
+	{
+		DrawPacket packet = MakePacket(0, 0, 1, i);
+		packet.Depth = DrawKey::QuantizeDepth(400.0f - 100.0f*i, nearZ, farZ);
+		queue.Submit(packet);
+	}
+	// An opaque draw submitted after a later layer still comes first.
+	DrawPacket transparent = MakePacket(0, 0, 1, 10);
+	transparent.Layer = 1;
+	queue.Submit(transparent);
+	queue.Submit(MakePacket(1, 0, 1, 11));
+	queue.Sort();
+
+	RenderCommandStream stream;
+	queue.Encode(stream);
+	RecordingBackend backend;
+	stream.Replay(backend);
+
+	std::vector<std::uint32_t> objects;
+	for(const Call& call : backend.Calls())
+	{
+		if(call.Command == RenderCommand::SetObjectConstants)
+			objects.push_back(call.Args[0]);
+	}
+	CHECK((objects == std::vector<std::uint32_t>{ 3, 2, 1, 0, 11, 10 }));
+}
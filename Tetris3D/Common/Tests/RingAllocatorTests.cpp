@@ -0,0 +1,175 @@
+//***************************************************************************************
+// RingAllocatorTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "RingAllocator.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Chunk
+	{
+		std::uint64_t Offset;
+		std::uint64_t Size;
+	};
+
+	bool Overlap(const Chunk& a, const Chunk& b)
+	{
+		return a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size;
+	}
+}
+
+TEST_CASE(AllocatesAlignedChunksInOrder)
+{
+	RingAllocator ring(1024);
+	CHECK(ring.Allocate(10, 16) == 0);
+	CHECK(ring.Allocate(10, 16) == 16);
+	CHECK(ring.Allocate(1, 1) == 26);
+	CHECK(ring.Allocate(256, 256) == 256);
+	CHECK(ring.UsedBytes() == 512);
+	CHECK(ring.Allocate(0, 4) == 512);
+}
+
+TEST_CASE(ChunksDoNotWrap)
+{
+	RingAllocator ring(1024);
+	CHECK(ring.Allocate(900, 4) == 0);
+	ring.FinishFrame(1);
+	CHECK(ring.Allocate(100, 4) == 900);
+	ring.FinishFrame(2);
+
+	// Frame 1 is done; 200 bytes do not fit before the end, so they start at 0.
+	ring.Reclaim(1);
+	CHECK(ring.UsedBytes() == 100);
+	CHECK(ring.Allocate(200, 4) == 0);
+
+	// The skipped 24 bytes at the end count as used until frame 3 is reclaimed.
+	CHECK(ring.UsedBytes() == 100 + 24 + 200);
+	ring.FinishFrame(3);
+	ring.Reclaim(2);
+	CHECK(ring.UsedBytes() == 24 + 200);
+	ring.Reclaim(3);
+	CHECK(ring.UsedBytes() == 0);
+}
+
+TEST_CASE(FullRingFailsUntilAFenceCompletes)
+{
+	RingAllocator ring(1024);
+	CHECK(ring.Allocate(512, 256) == 0);
+	ring.FinishFrame(1);
+	CHECK(ring.Allocate(512, 256) == 512);
+	ring.FinishFrame(2);
+
+	CHECK(ring.Allocate(1, 1) == RingAllocator::InvalidOffset);
+	CHECK(ring.Allocate(2048, 1) == RingAllocator::InvalidOffset);
+
+	// A fence before either frame frees nothing.
+	ring.Reclaim(0);
+	CHECK(ring.Allocate(1, 1) == RingAllocator::InvalidOffset);
+
+	ring.Reclaim(1);
+	CHECK(ring.Allocate(256, 256) == 0);
+	CHECK(ring.Allocate(512, 256) == RingAllocator::InvalidOffset);
+	CHECK(ring.Allocate(256, 256) == 256);
+	ring.FinishFrame(3);
+
+	// One completed fence retires every frame up to it.
+	ring.Reclaim(3);
+	CHECK(ring.UsedBytes() == 0);
+	CHECK(ring.Allocate(1024, 256) == 0);
+}
+
+TEST_CASE(EmptyRingStartsOver)
+{
+	RingAllocator ring(1024);
+	CHECK(ring.Allocate(600, 8) == 0);
+	ring.FinishFrame(1);
+	ring.Reclaim(1);
+
+	// Without the reset this would skip to the end and fail.
+	CHECK(ring.Allocate(1024, 8) == 0);
+	ring.FinishFrame(2);
+
+	// A frame with nothing allocated still retires in order.
+	ring.FinishFrame(3);
+	ring.Reclaim(2);
+	CHECK(ring.Allocate(8, 8) == 0);
+
+	// Allocations not yet in a finished frame are never reclaimed.
+	ring.Reclaim(3);
+	CHECK(ring.UsedBytes() == 8);
+	CHECK(ring.Allocate(8, 8) == 8);
+}
+
+TEST_CASE(LiveChunksNeverOverlap)
+{
+	// Three frames in flight with a GPU one to three frames behind, random sizes and
+	// constant buffer like alignments, over many wraps of the ring.
+	const std::uint64_t Capacity = 64*1024;
+	RingAllocator ring(Capacity);
+	std::mt19937 random(3);
+
+	struct Frame
+	{
+		std::uint64_t Fence;
+		std::vector<Chunk> Chunks;
+	};
+	std::deque<Frame> inFlight;
+	std::vector<Chunk> current;
+
+	std::uint64_t completed = 0;
+	std::uint64_t allocated = 0;
+	int failures = 0;
+	bool aligned = true;
+	bool disjoint = true;
+	bool inside = true;
+
+	for(std::uint64_t fence = 1; fence <= 2000; ++fence)
+	{
+		int count = random() % 40;
+		for(int i = 0; i < count; ++i)
+		{
+			std::uint64_t alignment = 1ull << (random() % 9);
+			std::uint64_t size = 1 + random() % 1024;
+			std::uint64_t offset = ring.Allocate(size, alignment);
+			if(offset == RingAllocator::InvalidOffset)
+			{
+				failures++;
+				continue;
+			}
+
+			Chunk chunk = { offset, size };
+			aligned = aligned && offset % alignment == 0;
+			inside = inside && offset + size <= Capacity;
+			for(const Frame& frame : inFlight)
+				for(const Chunk& live : frame.Chunks)
+					disjoint = disjoint && !Overlap(chunk, live);
+			for(const Chunk& live : current)
+				disjoint = disjoint && !Overlap(chunk, live);
+
+			current.push_back(chunk);
+			allocated += size;
+		}
+
+		ring.FinishFrame(fence);
+		inFlight.push_back({ fence, std::move(current) });
+		current.clear();
+
+		// The GPU finishes zero to two frames per CPU frame, keeping up to three in flight.
+		completed = (std::max)(completed + random() % 3, fence > 3 ? fence - 3 : 0);
+		completed = (std::min)(completed, fence);
+		ring.Reclaim(completed);
+		while(!inFlight.empty() && inFlight.front().Fence <= completed)
+			inFlight.pop_front();
+	}
+
+	CHECK(aligned && disjoint && inside);
+	CHECK(allocated > 50*Capacity);
+
+	// Three frames of up to 40 KiB in 64 KiB: some allocations must have waited.
+	CHECK(failures > 0);
+}
@@ -0,0 +1,179 @@
+//***************************************************************************************
+// TaskGraphTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE(RunsInDependencyThenReadyOrder)
+{
+	std::vector<std::string> order;
+	auto log = [&order](const char* name) { return [&order, name] { order.push_back(name); }; };
+
+	TaskGraph graph;
+	TaskGraph::TaskId a = graph.Add("a", log("a"));
+	TaskGraph::TaskId b = graph.Add("b", log("b"), { a });
+	TaskGraph::TaskId c = graph.Add("c", log("c"));
+	TaskGraph::TaskId join = graph.Add("join", nullptr, { b, c });
+	graph.Add("d", log("d"), { join });
+
+	// On one thread: a and c are ready first, b once a has finished, d last.
+	graph.Run(1);
+	CHECK((order == std::vector<std::string>{ "a", "c", "b", "d" }));
+
+	const auto& timeline = graph.Timeline();
+	CHECK(timeline.size() == 5 && timeline[3].Name == "join");
+	CHECK(timeline[1].StartMs >= timeline[0].EndMs);
+	CHECK(timeline[4].StartMs >= timeline[1].EndMs && timeline[4].StartMs >= timeline[2].EndMs);
+	for(const TaskGraph::TimelineEntry& entry : timeline)
+		CHECK(entry.Thread == 0 && entry.EndMs <= graph.TotalMs());
+
+	// One line per task and the total.
+	std::string text = graph.TimelineText();
+	CHECK(std::count(text.begin(), text.end(), '\n') == 6);
+	CHECK(text.find("total") != std::string::npos);
+}
+
+TEST_CASE(ThrowingTaskSkipsWhatHasNotStarted)
+{
+	std::vector<std::string> order;
+
+	TaskGraph graph;
+	TaskGraph::TaskId loader = graph.Add("loader", [&] { order.push_back("loader"); throw std::runtime_error("missing file"); });
+	graph.Add("user", [&] { order.push_back("user"); }, { loader });
+	graph.Add("independent", [&] { order.push_back("independent"); });
+
+	std::string message;
+	try
+	{
+		graph.Run(1);
+	}
+	catch(const std::runtime_error& e)
+	{
+		message = e.what();
+	}
+
+	// The dependent never runs, nor does the ready task that had not started.
+	CHECK(message == "missing file");
+	CHECK((order == std::vector<std::string>{ "loader" }));
+}
+
+TEST_CASE(FailureWaitsForRunningTasks)
+{
+	// The second task is running when the first throws; Run returns only after it
+	// has finished, and rethrows the first exception.
+	std::mutex mutex;
+	std::condition_variable changed;
+	bool slowStarted = false;
+	bool slowFinished = false;
+
+	TaskGraph graph;
+	graph.Add("fails", [&]
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait_for(lock, std::chrono::seconds(10), [&] { return slowStarted; });
+		throw std::logic_error("first");
+	});
+	graph.Add("slow", [&]
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			slowStarted = true;
+		}
+		changed.notify_all();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		slowFinished = true;
+	});
+
+	std::string message;
+	try
+	{
+		graph.Run(2);
+	}
+	catch(const std::logic_error& e)
+	{
+		message = e.what();
+	}
+
+	CHECK(message == "first");
+	CHECK(slowStarted && slowFinished);
+}
+
+TEST_CASE(ManyThreadsKeepDependencies)
+{
+	// A random graph on several threads: every task runs once, after everything it
+	// depends on has finished.
+	const int TaskCount = 300;
+	std::mt19937 rng(35);
+
+	std::atomic<int> clock(0);
+	std::vector<int> started(TaskCount, -1);
+	std::vector<int> ended(TaskCount, -1);
+	std::vector<std::atomic<int>> runs(TaskCount);
+	std::vector<std::vector<TaskGraph::TaskId>> dependencies(TaskCount);
+
+	TaskGraph graph;
+	for(int i = 0; i < TaskCount; ++i)
+	{
+		for(int k = 0; i > 0 && k < (int)(rng() % 4); ++k)
+			dependencies[i].push_back(rng() % i);
+
+		graph.Add("task" + std::to_string(i), [&, i]
+		{
+			started[i] = clock++;
+			runs[i]++;
+			volatile int spin = 0;
+			for(int s = 0; s < 1000; ++s)
+				spin = spin + s;
+			ended[i] = clock++;
+		}, dependencies[i]);
+	}
+
+	graph.Run(4);
+
+	bool ordered = true;
+	for(int i = 0; i < TaskCount; ++i)
+	{
+		ordered = ordered && runs[i] == 1 && graph.Timeline()[i].Thread < 4;
+		for(TaskGraph::TaskId dependency : dependencies[i])
+			ordered = ordered && ended[dependency] < started[i];
+	}
+	CHECK(ordered);
+}
+
+TEST_CASE(IndependentTasksRunConcurrently)
+{
+	// Each task waits for the other to start, so the graph only finishes when they
+	// run on two threads at once.
+	std::mutex mutex;
+	std::condition_variable changed;
+	int startedCount = 0;
+	bool bothStarted[2] = { false, false };
+
+	TaskGraph graph;
+	for(int i = 0; i < 2; ++i)
+	{
+		graph.Add("waiter", [&, i]
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startedCount++;
+			changed.notify_all();
+			bothStarted[i] = changed.wait_for(lock, std::chrono::seconds(10), [&] { return startedCount == 2; });
+		});
+	}
+
+	graph.Run(2);
+	CHECK(bothStarted[0] && bothStarted[1]);
+	CHECK(graph.Timeline()[0].Thread != graph.Timeline()[1].Thread);
+}
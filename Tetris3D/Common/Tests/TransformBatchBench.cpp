@@ -0,0 +1,73 @@
+//***************************************************************************************
+// TransformBatchBench.cpp
+//
+// TransformBatch::MultiplyTranspose against MultiplyTransposeScalar from 100 to 100k
+// matrices, for the two layouts the app writes: whole float4x4 constants (4 rows,
+// 64 bytes apart) and the affine columns of InstanceData (3 rows, 56 bytes apart).
+// Each is timed with a parent matrix and with a null one, which only transposes, as
+// UpdateObjectCBs and InstanceStreamBuilder call it.  Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "TransformBatch.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	typedef void (*MultiplyTransposeFunction)(const float*, std::size_t, std::size_t, const float*,
+		std::uint32_t, float*, std::size_t);
+
+	double NanosecondsPerMatrix(MultiplyTransposeFunction multiply, const std::vector<float>& locals,
+		const float* parent, std::uint32_t outRows, std::vector<float>& out, std::size_t outStride)
+	{
+		const std::size_t count = locals.size()/16;
+		const int runs = count < 10000 ? 2000 : 50;
+		double seconds = Bench::BestOf(runs, [&]
+		{
+			multiply(locals.data(), 16*sizeof(float), count, parent, outRows, out.data(), outStride);
+			Bench::Use(out.data());
+		});
+		return seconds*1e9/count;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(44);
+	std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+
+	float parent[16];
+	for(float& p : parent)
+		p = value(rng);
+
+	struct Layout { const char* Name; std::uint32_t Rows; std::size_t Stride; };
+	const Layout layouts[] = { { "float4x4", 4, 64 }, { "instance", 3, 56 } };
+
+	std::printf("ns per matrix, SIMD / scalar\n");
+	std::printf("   count  layout    parent                    null parent\n");
+	for(std::size_t count = 100; count <= 100000; count *= 10)
+	{
+		std::vector<float> locals(16*count);
+		for(float& l : locals)
+			l = value(rng);
+
+		for(const Layout& layout : layouts)
+		{
+			std::vector<float> out(count*layout.Stride/sizeof(float));
+			double simd = NanosecondsPerMatrix(TransformBatch::MultiplyTranspose, locals, parent,
+				layout.Rows, out, layout.Stride);
+			double scalar = NanosecondsPerMatrix(TransformBatch::MultiplyTransposeScalar, locals, parent,
+				layout.Rows, out, layout.Stride);
+			double simdNull = NanosecondsPerMatrix(TransformBatch::MultiplyTranspose, locals, nullptr,
+				layout.Rows, out, layout.Stride);
+			double scalarNull = NanosecondsPerMatrix(TransformBatch::MultiplyTransposeScalar, locals, nullptr,
+				layout.Rows, out, layout.Stride);
+			std::printf("%8zu  %-8s  %6.2f / %6.2f (%4.1fx)  %6.2f / %6.2f (%4.1fx)\n", count, layout.Name,
+				simd, scalar, scalar/simd, simdNull, scalarNull, scalarNull/simdNull);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,172 @@
+//***************************************************************************************
+// TransformBatchTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "TransformBatch.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const float Guard = -12345.0f;
+
+	void RandomMatrix(std::mt19937& random, float* m)
+	{
+		std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+		for(int i = 0; i < 16; ++i)
+			m[i] = value(random);
+	}
+
+	// local*parent in double, row-vector convention.
+	void Product(const float* local, const float* parent, double* out)
+	{
+		for(int r = 0; r < 4; ++r)
+		{
+			for(int c = 0; c < 4; ++c)
+			{
+				out[r*4 + c] = 0.0;
+				for(int k = 0; k < 4; ++k)
+					out[r*4 + c] += (double)local[r*4 + k]*parent[k*4 + c];
+			}
+		}
+	}
+
+	// count random matrices, each followed by padding up to stride bytes.
+	std::vector<float> RandomLocals(std::mt19937& random, std::size_t count, std::size_t stride)
+	{
+		std::vector<float> locals(count*stride/sizeof(float) + 16, Guard);
+		for(std::size_t i = 0; i < count; ++i)
+			RandomMatrix(random, &locals[i*stride/sizeof(float)]);
+		return locals;
+	}
+}
+
+TEST_CASE(MultiplyMatchesTheProduct)
+{
+	std::mt19937 random(5);
+	float parent[16];
+	RandomMatrix(random, parent);
+	std::vector<float> locals = RandomLocals(random, 9, 64);
+	std::vector<float> out(9*16, Guard);
+
+	TransformBatch::Multiply(locals.data(), 64, 9, parent, out.data(), 64);
+
+	bool close = true;
+	for(std::size_t i = 0; i < 9; ++i)
+	{
+		double expected[16];
+		Product(&locals[i*16], parent, expected);
+		for(int k = 0; k < 16; ++k)
+			close = close && std::fabs(out[i*16 + k] - expected[k]) <= 1e-5*(1.0 + std::fabs(expected[k]));
+	}
+	CHECK(close);
+
+	// Translation in the last row: a translated local under a translated parent.
+	const float local[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 1, 2, 3, 1 };
+	const float scaleMove[16] = { 2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 2, 0, 10, 20, 30, 1 };
+	float world[16];
+	TransformBatch::Multiply(local, 64, 1, scaleMove, world, 64);
+	CHECK(world[12] == 12.0f && world[13] == 24.0f && world[14] == 36.0f && world[15] == 1.0f);
+	CHECK(world[0] == 2.0f && world[5] == 2.0f && world[10] == 2.0f);
+}
+
+TEST_CASE(SimdMatchesScalarBitForBit)
+{
+	std::mt19937 random(9);
+	float parent[16];
+	RandomMatrix(random, parent);
+
+	// Every count around the two-matrix step, packed and constant buffer strides,
+	// with and without a parent.
+	const std::size_t strides[] = { 64, 80, 256 };
+	for(std::size_t count = 0; count <= 7; ++count)
+	{
+		for(std::size_t localStride : strides)
+		{
+			for(std::size_t outStride : strides)
+			{
+				std::vector<float> locals = RandomLocals(random, count, localStride);
+				for(const float* p : { (const float*)parent, (const float*)nullptr })
+				{
+					std::vector<float> simd(count*outStride/sizeof(float) + 16, Guard);
+					std::vector<float> scalar = simd;
+					TransformBatch::Multiply(locals.data(), localStride, count, p, simd.data(), outStride);
+					TransformBatch::MultiplyScalar(locals.data(), localStride, count, p, scalar.data(), outStride);
+					CHECK(std::memcmp(simd.data(), scalar.data(), simd.size()*sizeof(float)) == 0);
+
+					for(std::uint32_t rows = 1; rows <= 4; ++rows)
+					{
+						std::fill(simd.begin(), simd.end(), Guard);
+						std::fill(scalar.begin(), scalar.end(), Guard);
+						TransformBatch::MultiplyTranspose(locals.data(), localStride, count, p, rows, simd.data(), outStride);
+						TransformBatch::MultiplyTransposeScalar(locals.data(), localStride, count, p, rows, scalar.data(), outStride);
+						CHECK(std::memcmp(simd.data(), scalar.data(), simd.size()*sizeof(float)) == 0);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE(TransposeWritesTheRequestedColumns)
+{
+	std::mt19937 random(13);
+	float parent[16];
+	RandomMatrix(random, parent);
+	std::vector<float> locals = RandomLocals(random, 3, 64);
+
+	float product[3][16];
+	TransformBatch::Multiply(locals.data(), 64, 3, parent, &product[0][0], 64);
+
+	// InstanceData layout: three affine columns in 48-byte elements.
+	std::vector<float> out(3*12 + 4, Guard);
+	TransformBatch::MultiplyTranspose(locals.data(), 64, 3, parent, 3, out.data(), 48);
+
+	bool transposed = true;
+	for(int i = 0; i < 3; ++i)
+		for(int c = 0; c < 3; ++c)
+			for(int r = 0; r < 4; ++r)
+				transposed = transposed && out[i*12 + c*4 + r] == product[i][r*4 + c];
+	CHECK(transposed);
+	CHECK(out[36] == Guard && out[39] == Guard);
+}
+
+TEST_CASE(IdentityParentCopies)
+{
+	std::mt19937 random(17);
+	std::vector<float> locals = RandomLocals(random, 5, 64);
+	std::vector<float> out(5*16, Guard);
+	TransformBatch::Multiply(locals.data(), 64, 5, nullptr, out.data(), 64);
+	CHECK(std::memcmp(out.data(), locals.data(), out.size()*sizeof(float)) == 0);
+
+	const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	TransformBatch::Multiply(locals.data(), 64, 5, identity, out.data(), 64);
+	CHECK(std::memcmp(out.data(), locals.data(), out.size()*sizeof(float)) == 0);
+}
+
+TEST_CASE(InPlaceMatchesOutOfPlace)
+{
+	std::mt19937 random(21);
+	float parent[16];
+	RandomMatrix(random, parent);
+
+	for(std::size_t count : { std::size_t(1), std::size_t(4), std::size_t(7) })
+	{
+		std::vector<float> locals = RandomLocals(random, count, 64);
+		std::vector<float> expected(locals.size(), Guard);
+		TransformBatch::Multiply(locals.data(), 64, count, parent, expected.data(), 64);
+
+		TransformBatch::Multiply(locals.data(), 64, count, parent, locals.data(), 64);
+		CHECK(std::memcmp(locals.data(), expected.data(), count*16*sizeof(float)) == 0);
+
+		std::vector<float> transposed = RandomLocals(random, count, 64);
+		std::vector<float> expectedTransposed(transposed.size(), Guard);
+		TransformBatch::MultiplyTranspose(transposed.data(), 64, count, parent, 4, expectedTransposed.data(), 64);
+		TransformBatch::MultiplyTranspose(transposed.data(), 64, count, parent, 4, transposed.data(), 64);
+		CHECK(std::memcmp(transposed.data(), expectedTransposed.data(), count*16*sizeof(float)) == 0);
+	}
+}
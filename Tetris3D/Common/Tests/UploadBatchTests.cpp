@@ -0,0 +1,146 @@
+//***************************************************************************************
+// UploadBatchTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "RingAllocator.h"
+#include "UploadBatch.h"
+
+namespace
+{
+	// Stand-ins for resources and resource states.
+	const int VertexBuffer = 1;
+	const int IndexBuffer = 2;
+	const UploadBatch::Destination Vertices = &VertexBuffer;
+	const UploadBatch::Destination Indices = &IndexBuffer;
+
+	const std::uint32_t Common = 0;
+	const std::uint32_t GenericRead = 0xac3;
+	const std::uint32_t CopyDest = 0x400;
+
+	// Stages like StagingUploader: 16-byte aligned chunks of one ring shared by
+	// every batch.
+	const std::uint64_t StagingAlignment = 16;
+
+	std::uint64_t Stage(RingAllocator& ring, UploadBatch& batch, UploadBatch::Destination dst,
+		std::uint64_t dstOffset, std::uint64_t size)
+	{
+		std::uint64_t offset = ring.Allocate(size, StagingAlignment);
+		if(offset != RingAllocator::InvalidOffset)
+			batch.Add(dst, dstOffset, offset, size, Common, GenericRead);
+		return offset;
+	}
+
+	bool IsCopy(const UploadBatch::Copy& copy, UploadBatch::Destination dst, std::uint64_t dstOffset,
+		std::uint64_t srcOffset, std::uint64_t size)
+	{
+		return copy.Dst == dst && copy.DstOffset == dstOffset && copy.SrcOffset == srcOffset && copy.Size == size;
+	}
+}
+
+TEST_CASE(ContiguousCopiesMerge)
+{
+	UploadBatch batch;
+	batch.Add(Vertices, 0, 0, 64, Common, GenericRead);
+	batch.Add(Vertices, 64, 64, 32, Common, GenericRead);
+	batch.Add(Vertices, 96, 96, 32, Common, GenericRead);
+	batch.Build();
+	CHECK(batch.AddedCount() == 3);
+	CHECK(batch.Copies().size() == 1 && IsCopy(batch.Copies()[0], Vertices, 0, 0, 128));
+
+	// Contiguous in the destination only, or in the staging memory only.
+	batch.Clear();
+	batch.Add(Vertices, 0, 0, 64, Common, GenericRead);
+	batch.Add(Vertices, 64, 80, 16, Common, GenericRead);
+	batch.Add(Vertices, 96, 96, 16, Common, GenericRead);
+	batch.Build();
+	CHECK(batch.Copies().size() == 3);
+}
+
+TEST_CASE(CopiesAreGroupedByDestination)
+{
+	UploadBatch batch;
+	batch.Add(Indices, 32, 0, 32, CopyDest, GenericRead);
+	batch.Add(Vertices, 16, 32, 16, Common, GenericRead);
+	batch.Add(Indices, 0, 48, 32, CopyDest, GenericRead);
+	batch.Add(Vertices, 0, 80, 16, Common, GenericRead);
+	batch.Add(Vertices, 32, 0, 0, Common, GenericRead);
+	batch.Build();
+
+	// In the order the destinations were first added, then by destination offset.
+	const auto& copies = batch.Copies();
+	CHECK(batch.AddedCount() == 4 && copies.size() == 4);
+	CHECK(IsCopy(copies[0], Indices, 0, 48, 32));
+	CHECK(IsCopy(copies[1], Indices, 32, 0, 32));
+	CHECK(IsCopy(copies[2], Vertices, 0, 80, 16));
+	CHECK(IsCopy(copies[3], Vertices, 16, 32, 16));
+
+	// One transition per destination, whatever its number of copies.
+	const auto& transitions = batch.Transitions();
+	CHECK(transitions.size() == 2);
+	CHECK(transitions[0].Dst == Indices && transitions[0].Before == CopyDest && transitions[0].After == GenericRead);
+	CHECK(transitions[1].Dst == Vertices && transitions[1].Before == Common && transitions[1].After == GenericRead);
+
+	batch.Clear();
+	CHECK(batch.Empty() && batch.AddedCount() == 0 && batch.Transitions().empty());
+
+	// Empty copies add nothing, not even a transition.
+	batch.Add(Indices, 0, 0, 0, Common, GenericRead);
+	batch.Build();
+	CHECK(batch.Empty() && batch.Transitions().empty());
+}
+
+TEST_CASE(StagedChunksMergeWhenAligned)
+{
+	RingAllocator ring(1024);
+	UploadBatch batch;
+
+	// Whole 16-byte chunks staged back to back become one copy; a chunk that ends
+	// between boundaries leaves a gap in the staging memory.
+	CHECK(Stage(ring, batch, Vertices, 0, 64) == 0);
+	CHECK(Stage(ring, batch, Vertices, 64, 32) == 64);
+	CHECK(Stage(ring, batch, Vertices, 96, 20) == 96);
+	CHECK(Stage(ring, batch, Vertices, 116, 12) == 128);
+	CHECK(Stage(ring, batch, Indices, 0, 6) == 144);
+	batch.Build();
+
+	const auto& copies = batch.Copies();
+	CHECK(copies.size() == 3);
+	CHECK(IsCopy(copies[0], Vertices, 0, 0, 116));
+	CHECK(IsCopy(copies[1], Vertices, 116, 128, 12));
+	CHECK(IsCopy(copies[2], Indices, 0, 144, 6));
+	CHECK(batch.Transitions().size() == 2);
+}
+
+TEST_CASE(BatchesShareTheRingUntilTheirFenceCompletes)
+{
+	RingAllocator ring(256);
+	UploadBatch batch;
+
+	// Frame 1 records a batch; its staging memory is in use until fence 1 completes.
+	CHECK(Stage(ring, batch, Vertices, 0, 128) == 0);
+	CHECK(Stage(ring, batch, Indices, 0, 64) == 128);
+	batch.Build();
+	CHECK(batch.Copies().size() == 2);
+	batch.Clear();
+	ring.FinishFrame(1);
+
+	// Frame 2 gets the rest of the ring and no more.
+	CHECK(Stage(ring, batch, Vertices, 128, 48) == 192);
+	CHECK(Stage(ring, batch, Vertices, 176, 32) == RingAllocator::InvalidOffset);
+	ring.Reclaim(0);
+	CHECK(Stage(ring, batch, Vertices, 176, 32) == RingAllocator::InvalidOffset);
+
+	// Once fence 1 completes the chunk wraps to the start of the ring.
+	ring.Reclaim(1);
+	CHECK(Stage(ring, batch, Vertices, 176, 32) == 0);
+	batch.Build();
+	CHECK(batch.AddedCount() == 2 && batch.Copies().size() == 2);
+	CHECK(IsCopy(batch.Copies()[0], Vertices, 128, 192, 48));
+	CHECK(IsCopy(batch.Copies()[1], Vertices, 176, 0, 32));
+	batch.Clear();
+	ring.FinishFrame(2);
+
+	ring.Reclaim(2);
+	CHECK(ring.UsedBytes() == 0);
+}
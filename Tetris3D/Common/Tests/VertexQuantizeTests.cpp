@@ -0,0 +1,219 @@
+//***************************************************************************************
+// VertexQuantizeTests.cpp
+//***************************************************************************************
+
+#include "Check.h"
+#include "VertexQuantize.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Angle between a unit normal and its round trip through the octahedral encoding.
+	float RoundTripAngle(const float n[3])
+	{
+		std::int16_t oct[2];
+		VertexQuantize::OctEncode(n, oct);
+		float d[3];
+		VertexQuantize::OctDecode(oct, d);
+
+		float dot = n[0]*d[0] + n[1]*d[1] + n[2]*d[2];
+		float cross[3] = { n[1]*d[2] - n[2]*d[1], n[2]*d[0] - n[0]*d[2], n[0]*d[1] - n[1]*d[0] };
+		float sine = std::sqrt(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+		return std::atan2(sine, dot);
+	}
+
+	void Normalize(float n[3])
+	{
+		float length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+		for(int a = 0; a < 3; ++a)
+			n[a] /= length;
+	}
+
+	// Decoded position error allowed on one axis: half a step plus float rounding of
+	// the decode, which is relative to the largest magnitude involved.
+	float PositionTolerance(const QuantizationBounds& bounds, int axis)
+	{
+		float magnitude = std::fabs(bounds.Offset[axis]) + std::fabs(bounds.Scale[axis]);
+		return bounds.MaxError(axis) + 4.0f*FLT_EPSILON*magnitude;
+	}
+}
+
+TEST_CASE(PositionErrorStaysWithinBounds)
+{
+	std::mt19937 rng(32);
+
+	// Small and large boxes, near and far from the origin, and one flat axis.
+	const float boxes[][6] =
+	{
+		{ 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f },
+		{ -3.5f, 10.0f, 2.0f, 0.25f, 4.0f, 7.0f },
+		{ 1000.0f, -2000.0f, 500.0f, 30.0f, 0.01f, 250.0f },
+		{ 0.0f, 5.0f, 0.0f, 2.0f, 0.0f, 2.0f },
+	};
+
+	for(const auto& box : boxes)
+	{
+		const float* center = box;
+		const float* extents = box + 3;
+
+		std::vector<float> points;
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		for(int i = 0; i < 20000; ++i)
+		{
+			for(int a = 0; a < 3; ++a)
+				points.push_back(center[a] + unit(rng)*extents[a]);
+		}
+
+		// The corners are the hardest case for the bounds.
+		for(int c = 0; c < 8; ++c)
+		{
+			for(int a = 0; a < 3; ++a)
+				points.push_back(center[a] + ((c >> a) & 1 ? extents[a] : -extents[a]));
+		}
+
+		QuantizationBounds bounds = QuantizationBounds::FromPoints(points.data(), 3*sizeof(float), points.size() / 3);
+
+		float worst[3] = {};
+		bool withinTolerance = true;
+		const float normal[3] = { 0.0f, 0.0f, 1.0f };
+		for(std::size_t i = 0; i < points.size(); i += 3)
+		{
+			PackedVertex v = VertexQuantize::Pack(&points[i], normal, bounds);
+			CHECK(v.Position[3] == 0);
+
+			float decoded[3];
+			VertexQuantize::UnpackPosition(v, bounds, decoded);
+			for(int a = 0; a < 3; ++a)
+			{
+				float error = std::fabs(decoded[a] - points[i + a]);
+				worst[a] = (std::max)(worst[a], error);
+				withinTolerance = withinTolerance && error <= PositionTolerance(bounds, a);
+			}
+		}
+		CHECK(withinTolerance);
+
+		// The bound is not loose: where the step is well above the float spacing of
+		// the input, random points come close to half a step.
+		for(int a = 0; a < 3; ++a)
+		{
+			if(bounds.Scale[a] == 0.0f)
+				CHECK(worst[a] == 0.0f);
+			else if(bounds.MaxError(a) > 8.0f*(PositionTolerance(bounds, a) - bounds.MaxError(a)))
+				CHECK(worst[a] > 0.4f*bounds.MaxError(a));
+		}
+	}
+}
+
+TEST_CASE(PositionsOutsideTheBoundsAreClamped)
+{
+	const float center[3] = { 0.0f, 0.0f, 0.0f };
+	const float extents[3] = { 1.0f, 2.0f, 3.0f };
+	QuantizationBounds bounds = QuantizationBounds::FromCenterExtents(center, extents);
+
+	const float normal[3] = { 1.0f, 0.0f, 0.0f };
+	const float outside[3] = { -5.0f, 2.5f, 0.0f };
+	PackedVertex v = VertexQuantize::Pack(outside, normal, bounds);
+	CHECK(v.Position[0] == 0 && v.Position[1] == 65535);
+
+	float decoded[3];
+	VertexQuantize::UnpackPosition(v, bounds, decoded);
+	CHECK(decoded[0] == -1.0f && decoded[1] == 2.0f);
+	CHECK(std::fabs(decoded[2]) <= PositionTolerance(bounds, 2));
+}
+
+TEST_CASE(OctahedralNormalsRoundTripOverTheSphere)
+{
+	// Fibonacci sphere: evenly spread directions including both hemispheres.
+	const int count = 200000;
+	const float golden = 2.39996323f;
+	float worst = 0.0f;
+	for(int i = 0; i < count; ++i)
+	{
+		float z = 1.0f - 2.0f*(i + 0.5f)/count;
+		float r = std::sqrt((std::max)(1.0f - z*z, 0.0f));
+		float n[3] = { r*std::cos(golden*i), r*std::sin(golden*i), z };
+		worst = (std::max)(worst, RoundTripAngle(n));
+	}
+	CHECK(worst <= VertexQuantize::MaxNormalError);
+}
+
+TEST_CASE(OctahedralNormalsAtPolesAndSeam)
+{
+	std::vector<std::array<float, 3>> normals =
+	{
+		// Poles and axes; the -z pole maps to the corners of the square.
+		{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, -0.0f },
+		{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+	};
+
+	// Just around the poles and on both sides of the z = 0 seam, where the lower
+	// hemisphere is folded over the diagonals.
+	for(int i = 0; i < 360; ++i)
+	{
+		float angle = i*3.14159265f/180.0f;
+		float c = std::cos(angle), s = std::sin(angle);
+		for(float z : { 0.0f, -0.0f, 1e-7f, -1e-7f, 1e-3f, -1e-3f, 0.9999f, -0.9999f, 1.0f - 1e-7f, -1.0f + 1e-7f })
+		{
+			float r = std::sqrt(1.0f - z*z);
+			std::array<float, 3> n = { r*c, r*s, z };
+			Normalize(n.data());
+			normals.push_back(n);
+		}
+	}
+
+	bool withinError = true;
+	bool unitLength = true;
+	bool sameHemisphere = true;
+	for(const auto& n : normals)
+	{
+		withinError = withinError && RoundTripAngle(n.data()) <= VertexQuantize::MaxNormalError;
+
+		std::int16_t oct[2];
+		VertexQuantize::OctEncode(n.data(), oct);
+		float d[3];
+		VertexQuantize::OctDecode(oct, d);
+		unitLength = unitLength && std::fabs(d[0]*d[0] + d[1]*d[1] + d[2]*d[2] - 1.0f) < 1e-5f;
+
+		// Both sides of the seam keep the sign of z, up to the error.
+		if(std::fabs(n[2]) > VertexQuantize::MaxNormalError)
+			sameHemisphere = sameHemisphere && (n[2] > 0.0f) == (d[2] > 0.0f);
+	}
+	CHECK(withinError);
+	CHECK(unitLength);
+	CHECK(sameHemisphere);
+
+	// -32768 decodes like -32767, as the input assembler does.
+	const std::int16_t low[2] = { -32768, 0 };
+	const std::int16_t clamped[2] = { -32767, 0 };
+	float a[3], b[3];
+	VertexQuantize::OctDecode(low, a);
+	VertexQuantize::OctDecode(clamped, b);
+	CHECK(a[0] == b[0] && a[1] == b[1] && a[2] == b[2]);
+}
+
+TEST_CASE(PackStoresBothHalves)
+{
+	const float center[3] = { 1.0f, 1.0f, 1.0f };
+	const float extents[3] = { 1.0f, 1.0f, 1.0f };
+	QuantizationBounds bounds = QuantizationBounds::FromCenterExtents(center, extents);
+
+	float normal[3] = { 0.3f, -0.5f, -0.8f };
+	Normalize(normal);
+	const float position[3] = { 0.5f, 1.5f, 2.0f };
+	PackedVertex v = VertexQuantize::Pack(position, normal, bounds);
+
+	float p[3], n[3];
+	VertexQuantize::UnpackPosition(v, bounds, p);
+	VertexQuantize::UnpackNormal(v, n);
+	for(int a = 0; a < 3; ++a)
+	{
+		CHECK(std::fabs(p[a] - position[a]) <= PositionTolerance(bounds, a));
+		CHECK(std::fabs(n[a] - normal[a]) <= VertexQuantize::MaxNormalError);
+	}
+}
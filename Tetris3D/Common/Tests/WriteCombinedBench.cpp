@@ -0,0 +1,66 @@
+//***************************************************************************************
+// WriteCombinedBench.cpp
+//
+// Writes 10k constant blocks into 256-byte slots, as the object constants are written
+// to the upload ring, with one memcpy per slot and with WriteCombined::WriteStrided.
+// The destination is ordinary cached memory here; a mapped upload heap is
+// write-combined, where the streamed whole lines matter more.  Not run by ctest.
+//***************************************************************************************
+
+#include "Bench.h"
+#include "WriteCombined.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const std::size_t BlockCount = 10000;
+	const std::size_t SlotSize = 256;
+
+	void Compare(std::size_t blockSize, unsigned char* destination)
+	{
+		std::vector<unsigned char> source(BlockCount*blockSize);
+		for(std::size_t i = 0; i < source.size(); ++i)
+			source[i] = (unsigned char)i;
+
+		double memcpySeconds = Bench::BestOf(200, [&]
+		{
+			for(std::size_t i = 0; i < BlockCount; ++i)
+				std::memcpy(destination + i*SlotSize, source.data() + i*blockSize, blockSize);
+			Bench::Use(destination);
+		});
+
+		double stridedSeconds = Bench::BestOf(200, [&]
+		{
+			WriteCombined::WriteStrided(destination, SlotSize, source.data(), blockSize, BlockCount);
+			Bench::Use(destination);
+		});
+
+		const double gigabytes = BlockCount*blockSize/1e9;
+		std::printf("%10zu %10.3f %10.1f %13.3f %10.1f\n", blockSize,
+			memcpySeconds*1e3, gigabytes/memcpySeconds, stridedSeconds*1e3, gigabytes/stridedSeconds);
+	}
+}
+
+int main()
+{
+	// Cache line aligned, like a mapped resource.
+	const std::size_t size = BlockCount*SlotSize;
+	unsigned char* destination = (unsigned char*)std::malloc(size + WriteCombined::CacheLineSize);
+	unsigned char* aligned = (unsigned char*)(((std::uintptr_t)destination + WriteCombined::CacheLineSize - 1) &
+		~(std::uintptr_t)(WriteCombined::CacheLineSize - 1));
+	std::memset(aligned, 0, size);
+
+	std::printf("10k blocks in 256-byte slots; GB/s of block data\n");
+	std::printf("block size  memcpy ms       GB/s    strided ms       GB/s\n");
+	// 144 bytes is ObjectConstants.
+	for(std::size_t blockSize : { 64, 144, 208, 256 })
+		Compare(blockSize, aligned);
+
+	std::free(destination);
+	return 0;
+}
@@ -0,0 +1,144 @@
+//***************************************************************************************
+// WriteCombinedTests.cpp
+//
+// Write and WriteStrided against memcpy at every destination offset within a cache
+// line, so the head, streamed body and tail of each copy are covered.
+//***************************************************************************************
+
+#include "Check.h"
+#include "WriteCombined.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	const unsigned char Guard = 0xcd;
+
+	// A cache line aligned buffer with room for offset, size and a line of guard bytes.
+	struct Destination
+	{
+		explicit Destination(std::size_t size)
+			: Storage(size + 3*WriteCombined::CacheLineSize, Guard)
+		{
+			std::uintptr_t address = reinterpret_cast<std::uintptr_t>(Storage.data());
+			Line = Storage.data() + ((WriteCombined::CacheLineSize - (address & (WriteCombined::CacheLineSize - 1))) &
+				(WriteCombined::CacheLineSize - 1));
+		}
+
+		// Every byte outside [begin, end) still holds the guard.
+		bool GuardsIntact(const unsigned char* begin, const unsigned char* end)const
+		{
+			return std::all_of(Storage.data(), begin, [](unsigned char c) { return c == Guard; }) &&
+				std::all_of(end, Storage.data() + Storage.size(), [](unsigned char c) { return c == Guard; });
+		}
+
+		std::vector<unsigned char> Storage;
+		unsigned char* Line = nullptr;
+	};
+
+	std::vector<unsigned char> Pattern(std::size_t size)
+	{
+		std::vector<unsigned char> bytes(size + 1);
+		for(std::size_t i = 0; i < bytes.size(); ++i)
+			bytes[i] = (unsigned char)(i*7 + 1);
+		return bytes;
+	}
+}
+
+TEST_CASE(WriteMatchesMemcpyAtEveryOffset)
+{
+	const std::size_t MaxSize = 4*WriteCombined::CacheLineSize + 3;
+	std::vector<unsigned char> source = Pattern(MaxSize);
+
+	for(std::size_t offset = 0; offset < WriteCombined::CacheLineSize; ++offset)
+	{
+		// Source offsets that differ from the destination's: the loads are unaligned.
+		for(std::size_t sourceOffset = 0; sourceOffset < 2; ++sourceOffset)
+		{
+			for(std::size_t size = 0; size + sourceOffset <= MaxSize; ++size)
+			{
+				Destination destination(MaxSize);
+				unsigned char* dst = destination.Line + offset;
+				WriteCombined::Write(dst, source.data() + sourceOffset, size);
+
+				CHECK(std::equal(dst, dst + size, source.data() + sourceOffset));
+				CHECK(destination.GuardsIntact(dst, dst + size));
+			}
+		}
+	}
+}
+
+TEST_CASE(WriteCopiesLargeRanges)
+{
+	const std::size_t Size = 1 << 20;
+	std::vector<unsigned char> source = Pattern(Size);
+	for(std::size_t offset : { std::size_t(0), std::size_t(5), std::size_t(48) })
+	{
+		Destination destination(Size);
+		unsigned char* dst = destination.Line + offset;
+		WriteCombined::Write(dst, source.data(), Size);
+		CHECK(std::equal(dst, dst + Size, source.data()));
+		CHECK(destination.GuardsIntact(dst, dst + Size));
+	}
+}
+
+TEST_CASE(WriteStridedPadsToCacheLines)
+{
+	// Constant buffer strides and odd ones, element sizes around 16 and 64 bytes.
+	const std::size_t strides[] = { 256, 80, 64, 33 };
+	const std::size_t elementSizes[] = { 1, 15, 16, 17, 63, 64, 65, 144, 200, 256 };
+	const std::size_t Count = 5;
+
+	for(std::size_t stride : strides)
+	{
+		for(std::size_t elementSize : elementSizes)
+		{
+			if(elementSize > stride)
+				continue;
+
+			std::vector<unsigned char> source = Pattern(elementSize*Count);
+			const std::size_t padded = (std::min)((elementSize + 63) & ~std::size_t(63), stride);
+
+			// Aligned (streaming) and unaligned (plain) destinations.
+			for(std::size_t offset : { std::size_t(0), std::size_t(4) })
+			{
+				Destination destination(stride*Count);
+				unsigned char* dst = destination.Line + offset;
+				WriteCombined::WriteStrided(dst, stride, source.data(), elementSize, Count);
+
+				bool same = true;
+				for(std::size_t i = 0; i < Count; ++i)
+				{
+					const unsigned char* element = dst + i*stride;
+					same = same && std::equal(element, element + elementSize, source.data() + i*elementSize);
+					same = same && std::all_of(element + elementSize, element + padded, [](unsigned char c) { return c == 0; });
+
+					// The rest of the stride is not touched.
+					same = same && std::all_of(element + padded, element + stride, [](unsigned char c) { return c == Guard; });
+				}
+				CHECK(same);
+				CHECK(destination.GuardsIntact(dst, dst + stride*Count));
+			}
+		}
+	}
+}
+
+TEST_CASE(MappedRangesAreTrackedInDebugBuilds)
+{
+	unsigned char mapped[128] = {};
+	WriteCombined::RegisterMapped(mapped, sizeof(mapped));
+
+#ifndef NDEBUG
+	CHECK(WriteCombined::IsMapped(mapped + 10, 4));
+	CHECK(WriteCombined::IsMapped(mapped - 4, 5));
+	CHECK(!WriteCombined::IsMapped(mapped - 4, 4));
+	CHECK(!WriteCombined::IsMapped(mapped + sizeof(mapped), 16));
+#else
+	CHECK(!WriteCombined::IsMapped(mapped, sizeof(mapped)));
+#endif
+
+	WriteCombined::UnregisterMapped(mapped);
+	CHECK(!WriteCombined::IsMapped(mapped, sizeof(mapped)));
+}
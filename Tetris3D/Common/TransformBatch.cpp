@@ -0,0 +1,193 @@
+//***************************************************************************************
+// TransformBatch.cpp
+//***************************************************************************************
+
+#include "TransformBatch.h"
+#include <cassert>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define TRANSFORM_BATCH_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const float* Advance(const float* p, std::size_t bytes)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(p) + bytes);
+	}
+
+	float* Advance(float* p, std::size_t bytes)
+	{
+		return reinterpret_cast<float*>(reinterpret_cast<unsigned char*>(p) + bytes);
+	}
+
+	// Row r of local*parent, summed in the order of XMMatrixMultiply.  A null parent
+	// is the identity and copies the row.
+	void MultiplyRowScalar(const float* local, const float* parent, int r, float row[4])
+	{
+		if(parent == nullptr)
+		{
+			for(int c = 0; c < 4; ++c)
+				row[c] = local[r*4 + c];
+			return;
+		}
+
+		const float x = local[r*4 + 0];
+		const float y = local[r*4 + 1];
+		const float z = local[r*4 + 2];
+		const float w = local[r*4 + 3];
+
+		for(int c = 0; c < 4; ++c)
+		{
+			float xz = x*parent[0*4 + c] + z*parent[2*4 + c];
+			float yw = y*parent[1*4 + c] + w*parent[3*4 + c];
+			row[c] = xz + yw;
+		}
+	}
+
+#if TRANSFORM_BATCH_SSE
+	struct Parent
+	{
+		__m128 R0, R1, R2, R3;
+	};
+
+	inline __m128 MultiplyRow(__m128 row, const Parent& p)
+	{
+		__m128 x = _mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0));
+		__m128 y = _mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 z = _mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2));
+		__m128 w = _mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m128 xz = _mm_add_ps(_mm_mul_ps(x, p.R0), _mm_mul_ps(z, p.R2));
+		__m128 yw = _mm_add_ps(_mm_mul_ps(y, p.R1), _mm_mul_ps(w, p.R3));
+		return _mm_add_ps(xz, yw);
+	}
+
+	// All four rows are read before anything is written, so out may alias local.
+	template<bool HasParent>
+	inline void MultiplyOne(const float* local, const Parent& p, bool transpose, std::uint32_t outRows, float* out)
+	{
+		__m128 r0 = _mm_loadu_ps(local + 0);
+		__m128 r1 = _mm_loadu_ps(local + 4);
+		__m128 r2 = _mm_loadu_ps(local + 8);
+		__m128 r3 = _mm_loadu_ps(local + 12);
+
+		if(HasParent)
+		{
+			r0 = MultiplyRow(r0, p);
+			r1 = MultiplyRow(r1, p);
+			r2 = MultiplyRow(r2, p);
+			r3 = MultiplyRow(r3, p);
+		}
+
+		if(transpose)
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(out + 0, r0);
+		if(outRows > 1) _mm_storeu_ps(out + 4, r1);
+		if(outRows > 2) _mm_storeu_ps(out + 8, r2);
+		if(outRows > 3) _mm_storeu_ps(out + 12, r3);
+	}
+
+	template<bool HasParent>
+	void MultiplySse(const float* locals, std::size_t localStride, std::size_t count,
+		const float parent[16], bool transpose, std::uint32_t outRows, float* out, std::size_t outStride)
+	{
+		Parent p = {};
+		if(HasParent)
+		{
+			p.R0 = _mm_loadu_ps(parent + 0);
+			p.R1 = _mm_loadu_ps(parent + 4);
+			p.R2 = _mm_loadu_ps(parent + 8);
+			p.R3 = _mm_loadu_ps(parent + 12);
+		}
+
+		// Two independent matrices per iteration keep more multiplies in flight.
+		std::size_t i = 0;
+		for(; i + 2 <= count; i += 2)
+		{
+			const float* local1 = Advance(locals, localStride);
+			float* out1 = Advance(out, outStride);
+
+			MultiplyOne<HasParent>(locals, p, transpose, outRows, out);
+			MultiplyOne<HasParent>(local1, p, transpose, outRows, out1);
+
+			locals = Advance(local1, localStride);
+			out = Advance(out1, outStride);
+		}
+
+		if(i < count)
+			MultiplyOne<HasParent>(locals, p, transpose, outRows, out);
+	}
+
+	void MultiplySse(const float* locals, std::size_t localStride, std::size_t count,
+		const float parent[16], bool transpose, std::uint32_t outRows, float* out, std::size_t outStride)
+	{
+		if(parent != nullptr)
+			MultiplySse<true>(locals, localStride, count, parent, transpose, outRows, out, outStride);
+		else
+			MultiplySse<false>(locals, localStride, count, parent, transpose, outRows, out, outStride);
+	}
+#endif
+}
+
+void TransformBatch::Multiply(const float* locals, std::size_t localStride, std::size_t count,
+	const float parent[16], float* out, std::size_t outStride)
+{
+#if TRANSFORM_BATCH_SSE
+	MultiplySse(locals, localStride, count, parent, false, 4, out, outStride);
+#else
+	MultiplyScalar(locals, localStride, count, parent, out, outStride);
+#endif
+}
+
+void TransformBatch::MultiplyTranspose(const float* locals, std::size_t localStride, std::size_t count,
+	const float parent[16], std::uint32_t outRows, float* out, std::size_t outStride)
+{
+	assert(outRows >= 1 && outRows <= 4);
+
+#if TRANSFORM_BATCH_SSE
+	MultiplySse(locals, localStride, count, parent, true, outRows, out, outStride);
+#else
+	MultiplyTransposeScalar(locals, localStride, count, parent, outRows, out, outStride);
+#endif
+}
+
+void TransformBatch::MultiplyScalar(const float* locals, std::size_t localStride, std::size_t count,
+	const float parent[16], float* out, std::size_t outStride)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		float rows[4][4];
+		for(int r = 0; r < 4; ++r)
+			MultiplyRowScalar(locals, parent, r, rows[r]);
+
+		for(int r = 0; r < 4; ++r)
+			for(int c = 0; c < 4; ++c)
+				out[r*4 + c] = rows[r][c];
+
+		locals = Advance(locals, localStride);
+		out = Advance(out, outStride);
+	}
+}
+
+void TransformBatch::MultiplyTransposeScalar(const float* locals, std::size_t localStride, std::size_t count,
+	const float parent[16], std::uint32_t outRows, float* out, std::size_t outStride)
+{
+	assert(outRows >= 1 && outRows <= 4);
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		float rows[4][4];
+		for(int r = 0; r < 4; ++r)
+			MultiplyRowScalar(locals, parent, r, rows[r]);
+
+		for(std::uint32_t c = 0; c < outRows; ++c)
+			for(int r = 0; r < 4; ++r)
+				out[c*4 + r] = rows[r][c];
+
+		locals = Advance(locals, localStride);
+		out = Advance(out, outStride);
+	}
+}
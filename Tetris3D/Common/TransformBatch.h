@@ -0,0 +1,40 @@
+//***************************************************************************************
+// TransformBatch.h
+//
+// Multiplies arrays of 4x4 matrices by a shared parent matrix, optionally writing the
+// transposed result straight into a constant or structured buffer layout.  Matrices are
+// row-major and use the row-vector convention (translation in the last row), like
+// XMFLOAT4X4.  Two matrices are processed per iteration with SSE when it is available;
+// the scalar path performs the same operations in the same order as the SSE path and as
+// XMMatrixMultiply, so the results are bit-identical.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace TransformBatch
+{
+	///<summary>
+	/// out[i] = locals[i]*parent for count matrices.  locals and out advance by their
+	/// strides in bytes.  A null parent is the identity and skips the multiply.  out
+	/// may alias locals when the strides are equal.
+	///</summary>
+	void Multiply(const float* locals, std::size_t localStride, std::size_t count,
+		const float parent[16], float* out, std::size_t outStride);
+
+	///<summary>
+	/// Writes the first outRows (1 to 4) rows of transpose(locals[i]*parent), i.e. the
+	/// columns of the product, at out with outStride bytes between matrices: 4 rows
+	/// for a float4x4 in a constant buffer, 3 for the affine columns of InstanceData.
+	///</summary>
+	void MultiplyTranspose(const float* locals, std::size_t localStride, std::size_t count,
+		const float parent[16], std::uint32_t outRows, float* out, std::size_t outStride);
+
+	// Scalar versions of the functions above, always available for reference.
+	void MultiplyScalar(const float* locals, std::size_t localStride, std::size_t count,
+		const float parent[16], float* out, std::size_t outStride);
+	void MultiplyTransposeScalar(const float* locals, std::size_t localStride, std::size_t count,
+		const float parent[16], std::uint32_t outRows, float* out, std::size_t outStride);
+}
@@ -0,0 +1,97 @@
+//***************************************************************************************
+// UploadBatch.cpp
+//***************************************************************************************
+
+#include "UploadBatch.h"
+#include <algorithm>
+#include <cassert>
+
+void UploadBatch::Add(Destination dst, std::uint64_t dstOffset, std::uint64_t srcOffset, std::uint64_t size,
+	std::uint32_t before, std::uint32_t after)
+{
+	assert(dst != nullptr);
+
+	if(size == 0)
+		return;
+
+	Copy copy;
+	copy.Dst = dst;
+	copy.DstOffset = dstOffset;
+	copy.SrcOffset = srcOffset;
+	copy.Size = size;
+	mCopies.push_back(copy);
+	mAddedCount++;
+
+	// Destinations are few, a linear search is enough.
+	auto it = std::find_if(mTransitions.begin(), mTransitions.end(),
+		[dst](const Transition& t) { return t.Dst == dst; });
+
+	if(it == mTransitions.end())
+	{
+		Transition transition;
+		transition.Dst = dst;
+		transition.Before = before;
+		transition.After = after;
+		mTransitions.push_back(transition);
+	}
+	else
+	{
+		assert(it->Before == before && it->After == after);
+	}
+}
+
+void UploadBatch::Build()
+{
+	// Group by destination, in the order of mTransitions, then by destination offset.
+	auto rank = [this](Destination dst)
+	{
+		for(std::size_t i = 0; i < mTransitions.size(); ++i)
+		{
+			if(mTransitions[i].Dst == dst)
+				return i;
+		}
+		return mTransitions.size();
+	};
+
+	std::vector<std::pair<std::size_t, Copy>> sorted;
+	sorted.reserve(mCopies.size());
+	for(const Copy& copy : mCopies)
+		sorted.push_back(std::make_pair(rank(copy.Dst), copy));
+
+	std::stable_sort(sorted.begin(), sorted.end(),
+		[](const std::pair<std::size_t, Copy>& a, const std::pair<std::size_t, Copy>& b)
+	{
+		if(a.first != b.first)
+			return a.first < b.first;
+		return a.second.DstOffset < b.second.DstOffset;
+	});
+
+	mCopies.clear();
+	for(const auto& entry : sorted)
+	{
+		const Copy& copy = entry.second;
+
+		if(!mCopies.empty())
+		{
+			Copy& last = mCopies.back();
+			assert(last.Dst != copy.Dst || last.DstOffset + last.Size <= copy.DstOffset);
+
+			if(last.Dst == copy.Dst &&
+				last.DstOffset + last.Size == copy.DstOffset &&
+				last.SrcOffset + last.Size == copy.SrcOffset)
+			{
+				last.Size += copy.Size;
+				continue;
+			}
+		}
+
+		mCopies.push_back(copy);
+	}
+}
+
+void UploadBatch::Clear()
+{
+	mCopies.clear();
+	mTransitions.clear();
+	mAddedCount = 0;
+}
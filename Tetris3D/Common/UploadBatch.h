@@ -0,0 +1,66 @@
+//***************************************************************************************
+// UploadBatch.h
+//
+// Collects the buffer copies of an upload from staging memory and turns them into as
+// few commands as possible: copies to the same destination that are contiguous in
+// both the staging memory and the destination become one copy, and each destination
+// gets one transition before and one after all of its copies, however many copies it
+// has.  Destinations are opaque pointers and states are plain integers, so the batch
+// can be built and checked without a device.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class UploadBatch
+{
+public:
+	typedef const void* Destination;
+
+	struct Copy
+	{
+		Destination Dst = nullptr;
+		std::uint64_t DstOffset = 0;
+		std::uint64_t SrcOffset = 0;
+		std::uint64_t Size = 0;
+	};
+
+	struct Transition
+	{
+		Destination Dst = nullptr;
+		std::uint32_t Before = 0;
+		std::uint32_t After = 0;
+	};
+
+	///<summary>
+	/// Adds a copy of size bytes at srcOffset in the staging memory to dstOffset in
+	/// dst.  dst is in state before until the batch is recorded and in state after
+	/// once it is; every copy to the same destination must give the same states.
+	/// Destination ranges must not overlap within a batch.
+	///</summary>
+	void Add(Destination dst, std::uint64_t dstOffset, std::uint64_t srcOffset, std::uint64_t size,
+		std::uint32_t before, std::uint32_t after);
+
+	// Sorts and merges the copies added since the last Clear.  Call before reading
+	// Copies and Transitions.
+	void Build();
+
+	void Clear();
+
+	bool Empty()const { return mCopies.empty(); }
+
+	// After Build: the merged copies, grouped by destination in the order the
+	// destinations were first added, and one transition per destination.
+	const std::vector<Copy>& Copies()const { return mCopies; }
+	const std::vector<Transition>& Transitions()const { return mTransitions; }
+
+	// Copies added since the last Clear, before merging.
+	std::size_t AddedCount()const { return mAddedCount; }
+
+private:
+	std::vector<Copy> mCopies;
+	std::vector<Transition> mTransitions;
+	std::size_t mAddedCount = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "d3dUtil.h"
+#include "WriteCombined.h"
 
 template<typename T>
 class UploadBuffer
@@ -29,7 +30,10 @@ public:
             nullptr,
             IID_PPV_ARGS(&mUploadBuffer)));
 
-        ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
+        // The CPU never reads the buffer: it is write-combined memory.
+        CD3DX12_RANGE noRead(0, 0);
+        ThrowIfFailed(mUploadBuffer->Map(0, &noRead, reinterpret_cast<void**>(&mMappedData)));
+        WriteCombined::RegisterMapped(mMappedData, (size_t)mElementByteSize*elementCount);
 
         // We do not need to unmap until we are done with the resource.  However, we must not write to
         // the resource while it is in use by the GPU (so we must use synchronization techniques).
@@ -40,7 +44,10 @@ public:
     ~UploadBuffer()
     {
         if(mUploadBuffer != nullptr)
+        {
+            WriteCombined::UnregisterMapped(mMappedData);
             mUploadBuffer->Unmap(0, nullptr);
+        }
 
         mMappedData = nullptr;
     }
@@ -52,7 +59,54 @@ public:
 
     void CopyData(int elementIndex, const T& data)
     {
+        WriteCombined::AssertNotMapped(&data, sizeof(T));
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
+        mElementsWritten++;
+        mBytesWritten += sizeof(T);
+    }
+
+    // Writes size bytes at offset inside element elementIndex, e.g. the members of T
+    // that change when the rest of the element does not.
+    void CopyBytes(int elementIndex, size_t offset, const void* data, size_t size)
+    {
+        assert(offset + size <= sizeof(T));
+        WriteCombined::AssertNotMapped(data, size);
+        memcpy(&mMappedData[elementIndex*mElementByteSize + offset], data, size);
+        mBytesWritten += size;
+    }
+
+    // Writes count consecutive elements starting at firstElement in one pass of
+    // streaming stores.  Constant buffer elements are padded with zeros to whole
+    // cache lines, so the write-combined memory only sees full line writes.
+    void CopyRange(int firstElement, const T* data, UINT count)
+    {
+        BYTE* destination = &mMappedData[firstElement*mElementByteSize];
+        if(mIsConstantBuffer)
+            WriteCombined::WriteStrided(destination, mElementByteSize, data, sizeof(T), count);
+        else
+            WriteCombined::Write(destination, data, (size_t)count*sizeof(T));
+
+        mElementsWritten += count;
+        mBytesWritten += (UINT64)count*sizeof(T);
+    }
+
+    // Number of whole elements written by CopyData and CopyRange, and the bytes
+    // written by those and CopyBytes, since the last ResetWriteCount, to account for
+    // the upload traffic of a frame.
+    UINT ElementsWritten()const
+    {
+        return mElementsWritten;
+    }
+
+    UINT64 BytesWritten()const
+    {
+        return mBytesWritten;
+    }
+
+    void ResetWriteCount()
+    {
+        mElementsWritten = 0;
+        mBytesWritten = 0;
     }
 
 private:
@@ -61,4 +115,7 @@ private:
 
     UINT mElementByteSize = 0;
     bool mIsConstantBuffer = false;
+
+    UINT mElementsWritten = 0;
+    UINT64 mBytesWritten = 0;
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+//***************************************************************************************
+// UploadRing.cpp
+//***************************************************************************************
+
+#include "UploadRing.h"
+#include <stdexcept>
+
+UploadRing::UploadRing(ID3D12Device* device, UINT64 capacity)
+	: mAllocator(capacity)
+{
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(capacity),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mUploadBuffer)));
+
+	// The CPU never reads the buffer: it is write-combined memory.
+	CD3DX12_RANGE noRead(0, 0);
+	ThrowIfFailed(mUploadBuffer->Map(0, &noRead, reinterpret_cast<void**>(&mMappedData)));
+	WriteCombined::RegisterMapped(mMappedData, (size_t)capacity);
+
+	mGpuAddress = mUploadBuffer->GetGPUVirtualAddress();
+}
+
+UploadRing::~UploadRing()
+{
+	if(mUploadBuffer != nullptr)
+	{
+		WriteCombined::UnregisterMapped(mMappedData);
+		mUploadBuffer->Unmap(0, nullptr);
+	}
+}
+
+UploadRing::Allocation UploadRing::Allocate(UINT64 size, UINT64 alignment)
+{
+	UINT64 offset = mAllocator.Allocate(size, alignment);
+	if(offset == RingAllocator::InvalidOffset)
+		throw std::runtime_error("UploadRing: out of space for the frames in flight.");
+
+	Allocation chunk;
+	chunk.CpuAddress = mMappedData + offset;
+	chunk.GpuAddress = mGpuAddress + offset;
+	chunk.Offset = offset;
+	return chunk;
+}
+
+void UploadRing::FinishFrame(UINT64 fence)
+{
+	mAllocator.FinishFrame(fence);
+}
+
+void UploadRing::Reclaim(UINT64 completedFence)
+{
+	mAllocator.Reclaim(completedFence);
+}
+
+void UploadRing::ResetWriteCount()
+{
+	mElementsWritten = 0;
+	mBytesWritten = 0;
+}
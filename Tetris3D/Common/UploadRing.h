@@ -0,0 +1,79 @@
+//***************************************************************************************
+// UploadRing.h
+//
+// A persistently mapped upload heap managed by a RingAllocator, for data that is
+// written every frame, such as constant buffers.  Draws bind the GPU address of the
+// chunk they were given, so nothing depends on a fixed slot per object and the buffer
+// does not change when objects are added or removed.  The owner calls FinishFrame with
+// the fence signaled after each frame and Reclaim with the completed fence value.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "RingAllocator.h"
+#include "WriteCombined.h"
+
+class UploadRing
+{
+public:
+	struct Allocation
+	{
+		BYTE* CpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+
+		// Offset from the start of the ring.
+		UINT64 Offset = 0;
+	};
+
+	// capacity must be a multiple of D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT.
+	UploadRing(ID3D12Device* device, UINT64 capacity);
+	UploadRing(const UploadRing& rhs) = delete;
+	UploadRing& operator=(const UploadRing& rhs) = delete;
+	~UploadRing();
+
+	///<summary>
+	/// Returns size bytes aligned to alignment, to be written (never read) by the CPU
+	/// before the commands that use them are executed.  Throws when the frames in
+	/// flight leave no room: the ring is too small for the per-frame data.
+	///</summary>
+	Allocation Allocate(UINT64 size, UINT64 alignment);
+
+	// Writes data into a new constant buffer chunk, padded to whole cache lines.
+	template<typename T>
+	Allocation WriteConstants(const T& data)
+	{
+		const UINT byteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
+
+		Allocation chunk = Allocate(byteSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+		WriteCombined::WriteStrided(chunk.CpuAddress, byteSize, &data, sizeof(T), 1);
+
+		mElementsWritten++;
+		mBytesWritten += sizeof(T);
+		return chunk;
+	}
+
+	void FinishFrame(UINT64 fence);
+	void Reclaim(UINT64 completedFence);
+
+	ID3D12Resource* Resource()const { return mUploadBuffer.Get(); }
+	D3D12_GPU_VIRTUAL_ADDRESS GpuAddress()const { return mGpuAddress; }
+	UINT64 UsedBytes()const { return mAllocator.UsedBytes(); }
+	UINT64 Capacity()const { return mAllocator.Capacity(); }
+
+	// Number of elements (and their bytes) written by WriteConstants since the last
+	// ResetWriteCount.
+	UINT ElementsWritten()const { return mElementsWritten; }
+	UINT64 BytesWritten()const { return mBytesWritten; }
+	void ResetWriteCount();
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+	BYTE* mMappedData = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS mGpuAddress = 0;
+
+	RingAllocator mAllocator;
+
+	UINT mElementsWritten = 0;
+	UINT64 mBytesWritten = 0;
+};
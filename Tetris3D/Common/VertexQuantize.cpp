@@ -0,0 +1,156 @@
+//***************************************************************************************
+// VertexQuantize.cpp
+//***************************************************************************************
+
+#include "VertexQuantize.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	const float UnormMax = 65535.0f;
+	const float SnormMax = 32767.0f;
+
+	// Same conversion as the input assembler for R16G16_SNORM.
+	float SnormToFloat(std::int16_t q)
+	{
+		return (std::max)(q / SnormMax, -1.0f);
+	}
+
+	float SignNotZero(float x)
+	{
+		return x >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	// Matches DecodeOctNormal in Default.hlsl.
+	void OctDecodeFloat(float ex, float ey, float n[3])
+	{
+		float x = ex, y = ey, z = 1.0f - std::fabs(ex) - std::fabs(ey);
+		float t = (std::max)(-z, 0.0f);
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+
+		float invLength = 1.0f / std::sqrt(x*x + y*y + z*z);
+		n[0] = x*invLength;
+		n[1] = y*invLength;
+		n[2] = z*invLength;
+	}
+}
+
+QuantizationBounds QuantizationBounds::FromPoints(const float* positions, std::size_t positionStride, std::size_t count)
+{
+	float minP[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxP[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	const char* p = reinterpret_cast<const char*>(positions);
+	for(std::size_t i = 0; i < count; ++i, p += positionStride)
+	{
+		const float* v = reinterpret_cast<const float*>(p);
+		for(int a = 0; a < 3; ++a)
+		{
+			minP[a] = (std::min)(minP[a], v[a]);
+			maxP[a] = (std::max)(maxP[a], v[a]);
+		}
+	}
+
+	QuantizationBounds b;
+	for(int a = 0; a < 3 && count > 0; ++a)
+	{
+		b.Offset[a] = minP[a];
+		b.Scale[a] = maxP[a] - minP[a];
+	}
+
+	return b;
+}
+
+QuantizationBounds QuantizationBounds::FromCenterExtents(const float center[3], const float extents[3])
+{
+	QuantizationBounds b;
+	for(int a = 0; a < 3; ++a)
+	{
+		b.Offset[a] = center[a] - extents[a];
+		b.Scale[a] = 2.0f*extents[a];
+	}
+
+	return b;
+}
+
+float QuantizationBounds::MaxError(int axis)const
+{
+	return 0.5f*Scale[axis]/UnormMax;
+}
+
+PackedVertex VertexQuantize::Pack(const float position[3], const float normal[3], const QuantizationBounds& bounds)
+{
+	PackedVertex v;
+	for(int a = 0; a < 3; ++a)
+	{
+		float t = bounds.Scale[a] > 0.0f ? (position[a] - bounds.Offset[a]) / bounds.Scale[a] : 0.0f;
+		t = (std::min)((std::max)(t, 0.0f), 1.0f);
+		v.Position[a] = static_cast<std::uint16_t>(t*UnormMax + 0.5f);
+	}
+	v.Position[3] = 0;
+
+	OctEncode(normal, v.Normal);
+	return v;
+}
+
+void VertexQuantize::UnpackPosition(const PackedVertex& v, const QuantizationBounds& bounds, float position[3])
+{
+	for(int a = 0; a < 3; ++a)
+		position[a] = v.Position[a] / UnormMax * bounds.Scale[a] + bounds.Offset[a];
+}
+
+void VertexQuantize::UnpackNormal(const PackedVertex& v, float normal[3])
+{
+	OctDecode(v.Normal, normal);
+}
+
+void VertexQuantize::OctEncode(const float n[3], std::int16_t oct[2])
+{
+	// Project onto the octahedron |x|+|y|+|z| = 1 and fold the lower half over the
+	// diagonals.
+	float l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+	if(l1 == 0.0f)
+	{
+		oct[0] = oct[1] = 0;
+		return;
+	}
+
+	float invL1 = 1.0f / l1;
+	float x = n[0]*invL1;
+	float y = n[1]*invL1;
+	if(n[2] < 0.0f)
+	{
+		float fx = (1.0f - std::fabs(y))*SignNotZero(x);
+		float fy = (1.0f - std::fabs(x))*SignNotZero(y);
+		x = fx;
+		y = fy;
+	}
+
+	float fx = std::floor(x*SnormMax);
+	float fy = std::floor(y*SnormMax);
+
+	float bestDot = -2.0f;
+	for(int i = 0; i < 4; ++i)
+	{
+		float qx = (std::min)((std::max)(fx + (i & 1), -SnormMax), SnormMax);
+		float qy = (std::min)((std::max)(fy + (i >> 1), -SnormMax), SnormMax);
+
+		float d[3];
+		OctDecodeFloat(qx/SnormMax, qy/SnormMax, d);
+		float dot = d[0]*n[0] + d[1]*n[1] + d[2]*n[2];
+		if(dot > bestDot)
+		{
+			bestDot = dot;
+			oct[0] = static_cast<std::int16_t>(qx);
+			oct[1] = static_cast<std::int16_t>(qy);
+		}
+	}
+}
+
+void VertexQuantize::OctDecode(const std::int16_t oct[2], float n[3])
+{
+	OctDecodeFloat(SnormToFloat(oct[0]), SnormToFloat(oct[1]), n);
+}
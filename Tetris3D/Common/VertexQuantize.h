@@ -0,0 +1,61 @@
+//***************************************************************************************
+// VertexQuantize.h
+//
+// Compact 12-byte vertex format.  Positions are quantized to 16 bits per axis relative
+// to the bounds of their submesh (DXGI_FORMAT_R16G16B16A16_UNORM) and unit normals are
+// octahedral encoded into two 16-bit values (DXGI_FORMAT_R16G16_SNORM).  The vertex
+// shader rebuilds the position from the submesh's QuantizationBounds; see
+// DecodePosition and DecodeOctNormal in Default.hlsl.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+struct PackedVertex
+{
+	std::uint16_t Position[4]; // xyz, w is unused.
+	std::int16_t Normal[2];
+};
+
+static_assert(sizeof(PackedVertex) == 12, "PackedVertex must match the input layout.");
+
+///<summary>
+/// Maps quantized positions back to model space: p = q/65535*Scale + Offset.  The
+/// layout matches the cbMesh root constants of the shaders.
+///</summary>
+struct QuantizationBounds
+{
+	float Scale[3] = { 0.0f, 0.0f, 0.0f };
+	float Pad0 = 0.0f;
+	float Offset[3] = { 0.0f, 0.0f, 0.0f };
+	float Pad1 = 0.0f;
+
+	static QuantizationBounds FromPoints(const float* positions, std::size_t positionStride, std::size_t count);
+	static QuantizationBounds FromCenterExtents(const float center[3], const float extents[3]);
+
+	// Largest distance between a position inside the bounds and its decoded value,
+	// per axis: half a quantization step (plus float rounding of the decode).
+	float MaxError(int axis)const;
+};
+
+static_assert(sizeof(QuantizationBounds) == 8*sizeof(float), "QuantizationBounds must match cbMesh.");
+
+namespace VertexQuantize
+{
+	// Largest angle, in radians, between a unit normal and its decoded value.
+	const float MaxNormalError = 2.0e-4f;
+
+	PackedVertex Pack(const float position[3], const float normal[3], const QuantizationBounds& bounds);
+
+	void UnpackPosition(const PackedVertex& v, const QuantizationBounds& bounds, float position[3]);
+	void UnpackNormal(const PackedVertex& v, float normal[3]);
+
+	///<summary>
+	/// Octahedral encoding of a unit vector.  Of the four roundings of the encoded
+	/// value the one that decodes closest to n is kept.
+	///</summary>
+	void OctEncode(const float n[3], std::int16_t oct[2]);
+	void OctDecode(const std::int16_t oct[2], float n[3]);
+}
@@ -0,0 +1,167 @@
+//***************************************************************************************
+// WriteCombined.cpp
+//***************************************************************************************
+
+#include "WriteCombined.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifndef NDEBUG
+#include <mutex>
+#include <vector>
+#endif
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define WRITE_COMBINED_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#ifndef NDEBUG
+	struct MappedRange
+	{
+		const unsigned char* Begin;
+		const unsigned char* End;
+	};
+
+	std::mutex gMappedMutex;
+	std::vector<MappedRange> gMappedRanges;
+#endif
+}
+
+void WriteCombined::Write(void* destination, const void* source, std::size_t size)
+{
+	AssertNotMapped(source, size);
+
+	unsigned char* dst = static_cast<unsigned char*>(destination);
+	const unsigned char* src = static_cast<const unsigned char*>(source);
+
+#if WRITE_COMBINED_SSE
+	// Plain stores up to the first cache line boundary, streaming stores for the whole
+	// lines, and plain stores for the partial line after them.  Every streamed line is
+	// written completely by four consecutive stores, so it leaves the write-combining
+	// buffer as one full-line transaction.
+	std::size_t head = (CacheLineSize - (reinterpret_cast<std::uintptr_t>(dst) & (CacheLineSize - 1))) & (CacheLineSize - 1);
+	head = (std::min)(head, size);
+	std::memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	if(size >= CacheLineSize)
+	{
+		for(; size >= CacheLineSize; size -= CacheLineSize, dst += CacheLineSize, src += CacheLineSize)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+		}
+
+		// Streaming stores are weakly ordered; make them visible before anything that
+		// follows, such as the submission of the commands that read them.
+		_mm_sfence();
+	}
+#endif
+
+	std::memcpy(dst, src, size);
+}
+
+void WriteCombined::WriteStrided(void* destination, std::size_t destinationStride, const void* source,
+	std::size_t elementSize, std::size_t count)
+{
+	assert(elementSize <= destinationStride);
+	AssertNotMapped(source, elementSize*count);
+
+	unsigned char* dst = static_cast<unsigned char*>(destination);
+	const unsigned char* src = static_cast<const unsigned char*>(source);
+
+	// Bytes written per element: the element and the zeros after it.
+	const std::size_t padded = (std::min)((elementSize + CacheLineSize - 1) & ~(CacheLineSize - 1), destinationStride);
+
+#if WRITE_COMBINED_SSE
+	if((reinterpret_cast<std::uintptr_t>(dst) & 15) == 0 && (destinationStride & 15) == 0)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		for(std::size_t i = 0; i < count; ++i, dst += destinationStride, src += elementSize)
+		{
+			std::size_t offset = 0;
+			for(; offset + 16 <= elementSize; offset += 16)
+				_mm_stream_si128(reinterpret_cast<__m128i*>(dst + offset), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset)));
+
+			if(offset < elementSize)
+			{
+				alignas(16) unsigned char last[16] = {};
+				std::memcpy(last, src + offset, elementSize - offset);
+				_mm_stream_si128(reinterpret_cast<__m128i*>(dst + offset), _mm_load_si128(reinterpret_cast<const __m128i*>(last)));
+				offset += 16;
+			}
+
+			for(; offset < padded; offset += 16)
+				_mm_stream_si128(reinterpret_cast<__m128i*>(dst + offset), zero);
+		}
+
+		_mm_sfence();
+		return;
+	}
+#endif
+
+	for(std::size_t i = 0; i < count; ++i, dst += destinationStride, src += elementSize)
+	{
+		std::memcpy(dst, src, elementSize);
+		std::memset(dst + elementSize, 0, padded - elementSize);
+	}
+}
+
+void WriteCombined::RegisterMapped(const void* data, std::size_t size)
+{
+#ifndef NDEBUG
+	const unsigned char* begin = static_cast<const unsigned char*>(data);
+
+	std::lock_guard<std::mutex> lock(gMappedMutex);
+	gMappedRanges.push_back({ begin, begin + size });
+#else
+	(void)data;
+	(void)size;
+#endif
+}
+
+void WriteCombined::UnregisterMapped(const void* data)
+{
+#ifndef NDEBUG
+	std::lock_guard<std::mutex> lock(gMappedMutex);
+	auto it = std::find_if(gMappedRanges.begin(), gMappedRanges.end(),
+		[data](const MappedRange& range) { return range.Begin == data; });
+	if(it != gMappedRanges.end())
+		gMappedRanges.erase(it);
+#else
+	(void)data;
+#endif
+}
+
+bool WriteCombined::IsMapped(const void* data, std::size_t size)
+{
+#ifndef NDEBUG
+	const unsigned char* begin = static_cast<const unsigned char*>(data);
+	const unsigned char* end = begin + size;
+
+	std::lock_guard<std::mutex> lock(gMappedMutex);
+	for(const MappedRange& range : gMappedRanges)
+	{
+		if(begin < range.End && range.Begin < end)
+			return true;
+	}
+#else
+	(void)data;
+	(void)size;
+#endif
+
+	return false;
+}
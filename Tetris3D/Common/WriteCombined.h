@@ -0,0 +1,55 @@
+//***************************************************************************************
+// WriteCombined.h
+//
+// Writes into write-combined memory, such as a mapped upload heap.  Such memory is
+// fast to write in whole, sequential cache lines and very slow to read or to write in
+// scattered pieces, so ranges are written with non-temporal (streaming) SSE stores
+// when they are available, and padded elements are written up to whole cache lines.
+//
+// Debug builds keep a registry of the mapped ranges so reading one back, e.g. copying
+// from one element of an upload buffer to another, asserts.  No Direct3D dependencies.
+//***************************************************************************************
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+namespace WriteCombined
+{
+	// Writes are padded to multiples of this many bytes where the layout allows it.
+	const std::size_t CacheLineSize = 64;
+
+	///<summary>
+	/// Copies size bytes from source to destination.  The whole cache lines of
+	/// destination are written with streaming stores, the partial lines at either
+	/// end with ordinary stores.
+	///</summary>
+	void Write(void* destination, const void* source, std::size_t size);
+
+	///<summary>
+	/// Copies count elements of elementSize bytes, packed at source, to destination
+	/// with destinationStride bytes between elements (e.g. 256 for constant buffers).
+	/// Each element is followed by zeros up to the next cache line boundary inside
+	/// its stride, so whole lines are written.  elementSize <= destinationStride.
+	///</summary>
+	void WriteStrided(void* destination, std::size_t destinationStride, const void* source,
+		std::size_t elementSize, std::size_t count);
+
+	// Debug builds: adds or removes a mapped range checked by AssertNotMapped.  No-ops
+	// otherwise.
+	void RegisterMapped(const void* data, std::size_t size);
+	void UnregisterMapped(const void* data);
+
+	// True when [data, data + size) overlaps a registered range; always false in
+	// release builds.
+	bool IsMapped(const void* data, std::size_t size);
+
+	// Asserts that data, about to be read, is not write-combined memory.
+	inline void AssertNotMapped(const void* data, std::size_t size)
+	{
+		assert(!IsMapped(data, size) && "Reading back write-combined memory.");
+		(void)data;
+		(void)size;
+	}
+}
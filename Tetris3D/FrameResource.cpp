@@ -1,17 +1,43 @@
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT materialCount, UINT objectCount)
+FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT materialCount, UINT instanceCount)
 {
     ThrowIfFailed(device->CreateCommandAllocator(
         D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
     PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
-	MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
-	ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
+	MaterialBuffer = std::make_unique<UploadBuffer<MaterialData>>(device, materialCount, false);
+	InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(device, instanceCount, false);
+	InstanceCapacity = instanceCount;
 }
 
 FrameResource::~FrameResource()
 {
 
+}
+
+UINT FrameResource::UploadedElements()const
+{
+	return PassCB->ElementsWritten() + MaterialBuffer->ElementsWritten() +
+		InstanceBuffer->ElementsWritten();
+}
+
+UINT64 FrameResource::UploadedBytes()const
+{
+	return PassCB->BytesWritten() + MaterialBuffer->BytesWritten() +
+		InstanceBuffer->BytesWritten();
+}
+
+UINT64 FrameResource::ResidentBytes()const
+{
+	return d3dUtil::CommittedBytes(PassCB->Resource()) + d3dUtil::CommittedBytes(MaterialBuffer->Resource()) +
+		d3dUtil::CommittedBytes(InstanceBuffer->Resource());
+}
+
+void FrameResource::ResetUploadStats()
+{
+	PassCB->ResetWriteCount();
+	MaterialBuffer->ResetWriteCount();
+	InstanceBuffer->ResetWriteCount();
 }
\ No newline at end of file
@@ -3,11 +3,17 @@
 #include "Common/d3dUtil.h"
 #include "Common/MathHelper.h"
 #include "Common/UploadBuffer.h"
+#include "Common/InstanceStream.h"
+#include "Common/VertexQuantize.h"
 
 struct ObjectConstants
 {
     DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
 	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+	UINT     MaterialIndex;
+	UINT     ObjPad0;
+	UINT     ObjPad1;
+	UINT     ObjPad2;
 };
 
 struct PassConstants
@@ -18,6 +24,10 @@ struct PassConstants
     DirectX::XMFLOAT4X4 InvProj = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 InvViewProj = MathHelper::Identity4x4();
+
+    // Applied by the vertex shaders after the world matrix of every object, so a
+    // transform of the whole scene (the board rotation) does not dirty the objects.
+    DirectX::XMFLOAT4X4 SceneTransform = MathHelper::Identity4x4();
     DirectX::XMFLOAT3 EyePosW = { 0.0f, 0.0f, 0.0f };
     float cbPerObjectPad1 = 0.0f;
     DirectX::XMFLOAT2 RenderTargetSize = { 0.0f, 0.0f };
@@ -36,32 +46,59 @@ struct PassConstants
 	Light Lights[MaxLights];
 };
 
-struct Vertex
+// Material data read by the shaders through a StructuredBuffer indexed by
+// Material::MatCBIndex, so instances with different materials can share a draw.
+struct MaterialData
 {
-    DirectX::XMFLOAT3 Pos;
-	DirectX::XMFLOAT3 Normal;
+	DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
+	DirectX::XMFLOAT3 FresnelR0 = { 0.01f, 0.01f, 0.01f };
+	float Roughness = 0.25f;
+
+	// Used in texture mapping.
+	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
 };
 
+// 12-byte quantized vertex; positions are decoded with the QuantizationBounds of
+// their submesh, bound as per-mesh root constants.
+typedef PackedVertex Vertex;
+
 // Stores the resources needed for the CPU to build the command lists
 // for a frame.  
 struct FrameResource
 {
 public:
     
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount);
+    FrameResource(ID3D12Device* device, UINT passCount, UINT materialCount, UINT instanceCount);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
 
+    // Upload traffic of the frame: the elements and bytes written to the buffers
+    // below since the last ResetUploadStats.
+    UINT UploadedElements()const;
+    UINT64 UploadedBytes()const;
+    void ResetUploadStats();
+
+    // Memory taken by the upload buffers below.
+    UINT64 ResidentBytes()const;
+
     // We cannot reset the allocator until the GPU is done processing the commands.
     // So each frame needs their own allocator.
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
-    // We cannot update a cbuffer until the GPU is done processing the commands
-    // that reference it.  So each frame needs their own cbuffers.
+    // We cannot update a buffer until the GPU is done processing the commands
+    // that reference it.  So each frame needs their own buffers.  The object
+    // constants are allocated from the app's constant ring instead.
     std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
-	std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
+	std::unique_ptr<UploadBuffer<MaterialData>> MaterialBuffer = nullptr;
+
+	// Instance stream for the instanced render items, rebuilt every frame.
+	std::unique_ptr<UploadBuffer<InstanceData>> InstanceBuffer = nullptr;
+	UINT InstanceCapacity = 0;
+
+	// What InstanceBuffer holds, so unchanged instances are not written again.  The
+	// upload heap is write-combined and must not be read back to compare.
+	std::vector<InstanceData> WrittenInstances;
 
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
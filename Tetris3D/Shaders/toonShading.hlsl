@@ -22,17 +22,35 @@
 
 // Constant data that varies per frame.
 
-cbuffer cbPerObject : register(b0)
+struct InstanceData
 {
-    float4x4 gWorld;
+    // Columns of the row-vector world matrix; see InstanceStream.h.
+    float4 World0;
+    float4 World1;
+    float4 World2;
+    uint   Color;
+    uint   MaterialIndex;
+};
+
+struct MaterialData
+{
+    float4   DiffuseAlbedo;
+    float3   FresnelR0;
+    float    Roughness;
+    float4x4 MatTransform;
 };
 
-cbuffer cbMaterial : register(b1)
+StructuredBuffer<InstanceData> gInstanceData : register(t0);
+StructuredBuffer<MaterialData> gMaterialData : register(t1);
+
+cbuffer cbPerObject : register(b0)
 {
-	float4 gDiffuseAlbedo;
-    float3 gFresnelR0;
-    float  gRoughness;
-	float4x4 gMatTransform;
+    float4x4 gWorld;
+    float4x4 gTexTransform;
+    uint gMaterialIndex;
+    uint gObjPad0;
+    uint gObjPad1;
+    uint gObjPad2;
 };
 
 // Constant data that varies per material.
@@ -44,6 +62,7 @@ cbuffer cbPass : register(b2)
     float4x4 gInvProj;
     float4x4 gViewProj;
     float4x4 gInvViewProj;
+    float4x4 gSceneTransform; // Applied after the world matrix, e.g. the board rotation.
     float3 gEyePosW;
     float cbPerObjectPad1;
     float2 gRenderTargetSize;
@@ -60,11 +79,21 @@ cbuffer cbPass : register(b2)
     // are spot lights for a maximum of MaxLights per object.
     Light gLights[MaxLights];
 };
+
+// Maps the quantized positions of the bound submesh back to model space;
+// see VertexQuantize.h.
+cbuffer cbMesh : register(b3)
+{
+    float3 gPosScale;
+    float cbMeshPad0;
+    float3 gPosOffset;
+    float cbMeshPad1;
+};
  
 struct VertexIn
 {
-	float3 PosL    : POSITION;
-    float3 NormalL : NORMAL;
+	float4 PosQ    : POSITION; // R16G16B16A16_UNORM, relative to the submesh bounds.
+    float2 NormalQ : NORMAL;   // R16G16_SNORM, octahedral encoded.
 };
 
 struct VertexOut
@@ -72,22 +101,78 @@ struct VertexOut
 	float4 PosH    : SV_POSITION;
     float3 PosW    : POSITION;
     float3 NormalW : NORMAL;
+
+    nointerpolation float4 Color : COLOR;
+    nointerpolation uint MatIndex : MATINDEX;
 };
 
+float4 UnpackColor(uint c)
+{
+    return float4(c & 0xff, (c >> 8) & 0xff, (c >> 16) & 0xff, c >> 24) / 255.0f;
+}
+
+float3 DecodePosition(float4 q)
+{
+    return q.xyz*gPosScale + gPosOffset;
+}
+
+// Unfolds the lower half of the octahedron; see VertexQuantize::OctDecode.
+float3 DecodeOctNormal(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
 VertexOut VS(VertexIn vin)
 {
 	VertexOut vout = (VertexOut)0.0f;
+
+    float3 posL = DecodePosition(vin.PosQ);
+    float3 normalL = DecodeOctNormal(vin.NormalQ);
 	
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(mul(float4(posL, 1.0f), gWorld), gSceneTransform);
     vout.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
+    vout.NormalW = mul(mul(normalL, (float3x3)gWorld), (float3x3)gSceneTransform);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
 
+    vout.Color = gMaterialData[gMaterialIndex].DiffuseAlbedo;
+    vout.MatIndex = gMaterialIndex;
+
+    return vout;
+}
+
+VertexOut VSInstanced(VertexIn vin, uint instanceID : SV_InstanceID)
+{
+	VertexOut vout = (VertexOut)0.0f;
+
+    InstanceData inst = gInstanceData[instanceID];
+
+    float4 posL = float4(DecodePosition(vin.PosQ), 1.0f);
+    float3 normalL = DecodeOctNormal(vin.NormalQ);
+
+    // Transform to world space.
+    float3 posW = float3(dot(posL, inst.World0), dot(posL, inst.World1), dot(posL, inst.World2));
+    vout.PosW = mul(float4(posW, 1.0f), gSceneTransform).xyz;
+
+    // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
+    float3 normalW = float3(dot(normalL, inst.World0.xyz),
+                            dot(normalL, inst.World1.xyz),
+                            dot(normalL, inst.World2.xyz));
+    vout.NormalW = mul(normalW, (float3x3)gSceneTransform);
+
+    // Transform to homogeneous clip space.
+    vout.PosH = mul(float4(vout.PosW, 1.0f), gViewProj);
+
+    vout.Color = UnpackColor(inst.Color);
+    vout.MatIndex = inst.MaterialIndex;
+
     return vout;
 }
 
@@ -111,11 +196,15 @@ float4 PS(VertexOut pin) : SV_Target
     // Vector from point being lit to eye. 
     float3 toEyeW = normalize(gEyePosW - pin.PosW);
 
+    // The albedo comes with the vertex; the rest of the material is fetched by index.
+    MaterialData matData = gMaterialData[pin.MatIndex];
+    float4 diffuseAlbedo = pin.Color;
+
 	// Indirect lighting.
-    float4 ambient = gAmbientLight*gDiffuseAlbedo;
+    float4 ambient = gAmbientLight*diffuseAlbedo;
 
-    const float shininess = 1.0f - gRoughness;
-    Material mat = { gDiffuseAlbedo, gFresnelR0, shininess };
+    const float shininess = 1.0f - matData.Roughness;
+    Material mat = { diffuseAlbedo, matData.FresnelR0, shininess };
     float3 shadowFactor = 1.0f;
     float4 directLight = ComputeLighting(gLights, mat, pin.PosW,
         pin.NormalW, toEyeW, shadowFactor);
@@ -127,7 +216,7 @@ float4 PS(VertexOut pin) : SV_Target
     litColor.b = fkd(litColor.b);
 	
     // Common convention to take alpha from diffuse material.
-    litColor.a = gDiffuseAlbedo.a;
+    litColor.a = diffuseAlbedo.a;
 
     return litColor;
 }
\ No newline at end of file
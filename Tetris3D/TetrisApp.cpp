@@ -8,9 +8,23 @@
 #include "Common/MathHelper.h"
 #include "Common/UploadBuffer.h"
 #include "Common/GeometryGenerator.h"
+#include "Common/D3D12RenderBackend.h"
+#include "Common/FrustumCull.h"
+#include "Common/TransformBatch.h"
+#include "Common/TaskGraph.h"
+#include "Common/MeshCache.h"
+#include "Common/MeshAtlasBuilder.h"
+#include "Common/MeshBake.h"
+#include "Common/MeshSimplify.h"
+#include "Common/UploadRing.h"
+#include "Common/StagingUploader.h"
+#include "Common/MemoryReport.h"
 #include "FrameResource.h"
 
 #include<time.h>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -18,6 +32,62 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// Pass and object constants of the frames in flight.
+const UINT64 gConstantRingSize = 1024*1024;
+
+// Buffer data on its way to default heaps; the startup geometry needs about 2 MB.
+const UINT64 gStagingSize = 8*1024*1024;
+
+// The levels of detail of a mesh, finest first.  Each level is its own submesh
+// and instance batch.
+struct MeshLodChain
+{
+	struct Level
+	{
+		UINT MeshId = 0;
+		UINT IndexCount = 0;
+		UINT StartIndexLocation = 0;
+	};
+
+	std::vector<Level> Levels;
+
+	// Distance from the finest level's surface, in model units.
+	std::vector<float> Errors;
+};
+
+// Handles are indices into the dense material and mesh tables of the app: a
+// material's MatCBIndex and a submesh's MeshId.
+typedef UINT MaterialHandle;
+typedef UINT MeshHandle;
+
+// Everything a render item needs to draw a submesh, looked up by MeshHandle.
+struct MeshEntry
+{
+	MeshGeometry* Geo = nullptr;
+	UINT MeshId = 0;
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	int BaseVertexLocation = 0;
+	BoundingBox Bounds;
+
+	// Levels of detail of the mesh, or null.
+	const MeshLodChain* Lods = nullptr;
+};
+
+// The shape meshes, filled by the startup tasks and released once the geometry is
+// uploaded.  The generated meshes are shared with the mesh cache.
+struct ShapeMeshes
+{
+	MeshCache::MeshPtr Box;
+	MeshCache::MeshPtr BackgroundGrid;
+	MeshCache::MeshPtr Grid;
+	MeshCache::MeshPtr Sphere;
+	MeshCache::MeshPtr Cylinder;
+	// Baked models with their levels of detail; the files stay open until the upload.
+	MeshFile Skull;
+	MeshFile Car;
+};
+
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
 struct RenderItem
@@ -31,18 +101,37 @@ struct RenderItem
 
 	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify obect data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
+	// Dirty flag indicating the object data has changed and Constants must be rebuilt.
+	// Set to gNumFrameResources when the item changes; any value above 0 is dirty.
 	int NumFramesDirty = gNumFrameResources;
 
-	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
+	// Object constants as uploaded, rebuilt only when the item is dirty and written
+	// to the constant ring every frame the item is drawn.
+	ObjectConstants Constants;
+
+	// Constant ring slot holding Constants this frame (see D3D12RenderBackend).
+	UINT ObjectCBSlot = 0;
+
+	// Sequential index of the render item, assigned as it is built.
 	UINT ObjCBIndex = -1;
 
+	// Identifies the submesh for instanced render items.  Items with the same MeshId
+	// are drawn together from the instance stream.
+	UINT MeshId = 0;
+
+	// View space depth of the object's origin, updated every frame to sort draws
+	// front to back.
+	float ViewDepth = 0.0f;
+
 	Material* Mat = nullptr;
 	MeshGeometry* Geo = nullptr;
 
+	// Local space bounds of the submesh, used for frustum culling.
+	BoundingBox Bounds;
+
+	// Levels of detail to choose the submesh from every frame, or null.
+	const MeshLodChain* Lods = nullptr;
+
     // Primitive topology.
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
@@ -55,6 +144,7 @@ struct RenderItem
 enum class RenderLayer : int
 {
 	Opaque = 0,
+	Instanced,
 	Count
 };
 
@@ -84,19 +174,36 @@ private:
 
     void OnKeyboardInput(const GameTimer& gt);
 	void UpdateCamera(const GameTimer& gt);
+	void CullRenderItems(const GameTimer& gt);
+	void SelectLods(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
-	void UpdateMaterialCBs(const GameTimer& gt);
+	void UpdateInstanceBuffer(const GameTimer& gt);
+	void UpdateMaterialBuffer(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
 
-    void BuildDescriptorHeaps();
-    void BuildConstantBufferViews();
+	XMMATRIX SceneRotation(const GameTimer& gt);
+	UINT GetMeshId(const std::string& submeshName);
+
+	// Names are resolved once, after the geometry and materials are built; the
+	// render items are then built from handles only.
+	void BuildHandleTables();
+	MaterialHandle FindMaterial(const std::string& name)const;
+	MeshHandle FindMesh(const std::string& submeshName)const;
+	void SetRenderItemMesh(RenderItem& ri, MeshHandle mesh)const;
+
     void BuildRootSignature();
-    void BuildShadersAndInputLayout();
-    void BuildShapeGeometry();
+    std::vector<TaskGraph::TaskId> BuildShadersAndInputLayout(TaskGraph& startup);
+    TaskGraph::TaskId BuildShapeGeometry(TaskGraph& startup);
+    void UploadShapeGeometry();
 	void BuildMaterials();
     void BuildPSOs();
-    void BuildFrameResources();
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void BuildFrameResources(UINT instanceCapacity);
+    void QueueRenderItems(const std::vector<RenderItem*>& ritems, RenderLayer layer, UINT pso);
+	void QueueInstanceBatches(const std::vector<RenderItem*>& ritems, RenderLayer layer);
+	std::string PsoSuffix()const;
+
+	virtual std::wstring FrameStatsText()const override;
+	MemoryReport BuildMemoryReport()const;
 
 	void BuildbackgrounGrid();
 
@@ -124,9 +231,13 @@ private:
     int mCurrFrameResourceIndex = 0;
 
     ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
-    ComPtr<ID3D12DescriptorHeap> mCbvHeap = nullptr;
 
-	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
+	// Object constants are allocated here every frame and reclaimed once the
+	// frame's fence completes.
+	std::unique_ptr<UploadRing> mConstantRing;
+
+	// Uploads to default heap buffers, recorded as one batch per command list.
+	std::unique_ptr<StagingUploader> mStaging;
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
@@ -142,9 +253,63 @@ private:
 	// Render items divided by PSO.
 	std::vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count];
 
+	// Render items of each layer that intersect the view frustum this frame.
+	std::vector<RenderItem*> mVisibleRitems[(int)RenderLayer::Count];
+	CullBoxList mCullBoxes;
+	std::vector<std::uint8_t> mCullVisible;
+	std::vector<XMFLOAT4X4> mCullWorlds;
+
+	// Scratch for rebuilding the constants of dirty items in one batch: World and
+	// TexTransform of each item, transposed in place.
+	std::vector<RenderItem*> mDirtyRitems;
+	std::vector<XMFLOAT4X4> mDirtyTransforms;
+
+	// Instanced render items are grouped by mesh into this stream every frame.
+	InstanceStreamBuilder mInstanceStream;
+	std::unordered_map<std::string, UINT> mMeshIds;
+	std::unordered_map<std::string, MeshLodChain> mMeshLods;
+
+	// Dense tables indexed by MaterialHandle and MeshHandle, and the handles used to
+	// build the render items.
+	std::vector<Material*> mMaterialTable;
+	std::vector<MeshEntry> mMeshTable;
+	MaterialHandle mCellMaterials[8] = {};
+	MaterialHandle mGridMaterial = 0;
+	MaterialHandle mSkullMaterial = 0;
+	MeshHandle mBoxMesh = 0;
+	MeshHandle mGridMesh = 0;
+	MeshHandle mSkullMesh = 0;
+
+	// Draws are queued as packets, sorted by state and encoded into a command stream
+	// without redundant binds, which the backend replays on the command list.
+	RenderQueue mRenderQueue;
+	RenderCommandStream mCommandStream;
+	D3D12RenderBackend mRenderBackend{ 0, 3, sizeof(InstanceData), 4, sizeof(QuantizationBounds)/4 };
+	std::unordered_map<std::string, UINT> mPsoHandles;
+	std::unordered_map<const MeshGeometry*, UINT> mGeometryHandles;
+
+	std::unique_ptr<ShapeMeshes> mShapeMeshes;
+
+	// Generated meshes by generator and parameters, persisted between runs.  Meshes
+	// read back from the directory are used from the mapped files, not copied.
+	MeshCache mMeshCache;
+
+	// Reported once the first frame is presented.
+	std::chrono::steady_clock::time_point mStartTime = std::chrono::steady_clock::now();
+	bool mFirstFramePresented = false;
+
     PassConstants mMainPassCB;
 
-    UINT mPassCbvOffset = 0;
+	// mMainPassCB is only rebuilt when the camera (including the projection and the
+	// scene transform) or the lights change, then copied to the pass buffer of each
+	// frame resource in turn.  The times are written every frame.
+	bool mCameraDirty = true;
+	bool mLightsDirty = true;
+	int mPassFramesDirty = gNumFrameResources;
+
+	// Transform of the whole scene for this frame (the board rotation), applied after
+	// the world matrix of every item.
+	XMFLOAT4X4 mSceneTransform = MathHelper::Identity4x4();
 
     bool mIsWireframe = false;
 
@@ -256,6 +421,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
         MessageBox(nullptr, e.ToString().c_str(), L"HR Failed", MB_OK);
         return 0;
     }
+    catch(std::exception& e)
+    {
+        MessageBoxA(nullptr, e.what(), "Initialization Failed", MB_OK);
+        return 0;
+    }
 }
 
 TetrisApp::TetrisApp(HINSTANCE hInstance)
@@ -265,7 +435,7 @@ TetrisApp::TetrisApp(HINSTANCE hInstance)
 
 TetrisApp::~TetrisApp()
 {
-    if(md3dDevice != nullptr)
+    if(mFenceService != nullptr)
         FlushCommandQueue();
 }
 
@@ -277,13 +447,43 @@ bool TetrisApp::Initialize()
     // Reset the command list to prep for initialization commands.
     ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
 
+	mConstantRing = std::make_unique<UploadRing>(md3dDevice.Get(), gConstantRingSize);
+	mStaging = std::make_unique<StagingUploader>(md3dDevice.Get(), gStagingSize);
+
 	mapInitialize();
 
-    BuildRootSignature();
-    BuildShadersAndInputLayout();
-    BuildShapeGeometry();
-	BuildMaterials();
-    BuildPSOs();
+	// Independent startup work runs in parallel: meshes are generated and loaded while
+	// the shaders compile.  Only the geometry upload and the pipeline states wait for
+	// their inputs.
+	// Tasks start in the order they are added, the longest chains (model loading and
+	// simplification) first.
+	TaskGraph startup;
+	mMeshCache.SetDirectory("MeshCache");
+	BuildShapeGeometry(startup);
+	TaskGraph::TaskId rootSignature = startup.Add("root signature", [this] { BuildRootSignature(); });
+	std::vector<TaskGraph::TaskId> psoInputs = BuildShadersAndInputLayout(startup);
+	psoInputs.push_back(rootSignature);
+	startup.Add("materials", [this] { BuildMaterials(); });
+	startup.Add("pipeline states", [this] { BuildPSOs(); }, psoInputs);
+	startup.Run();
+
+	BuildHandleTables();
+
+	std::string timeline = "***Startup timeline\n" + startup.TimelineText();
+	::OutputDebugStringA(timeline.c_str());
+
+	MeshCache::Stats cacheStats = mMeshCache.GetStats();
+	std::string cacheText = "***Mesh cache: " + std::to_string(cacheStats.Hits) + " hits, " +
+		std::to_string(cacheStats.Misses) + " misses (" + std::to_string(cacheStats.DiskLoads) + " from disk)\n";
+	::OutputDebugStringA(cacheText.c_str());
+
+	mStaging->Record(mCommandList.Get());
+
+	const StagingUploader::BatchStats& uploads = mStaging->LastBatch();
+	std::string uploadText = "***Startup uploads: " + std::to_string(uploads.Uploads) + " uploads, " +
+		std::to_string(uploads.Copies) + " copies, " + std::to_string(uploads.Barriers) + " barriers, " +
+		std::to_string(uploads.Bytes/1024) + " KB\n";
+	::OutputDebugStringA(uploadText.c_str());
 
     // Execute the initialization commands.
     ThrowIfFailed(mCommandList->Close());
@@ -293,6 +493,13 @@ bool TetrisApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+	// The geometry is on the GPU: this releases the staging heap.
+	mStaging->FinishFrame(mFenceService->LastSignaled());
+	mStaging->Reclaim(mFenceService->CompletedValue());
+
+	std::string memoryText = "***Resident memory\n" + BuildMemoryReport().Text();
+	::OutputDebugStringA(memoryText.c_str());
+
     return true;
 }
 void TetrisApp::GameInitialize() {
@@ -320,22 +527,24 @@ void TetrisApp::GameInitialize() {
 }
 
 void TetrisApp::SettingForRenderitems() {
-	
-	FlushCommandQueue();
-
-	for (auto& e : mFrameResources) {
-		if(e->CmdListAlloc.Get())	e->CmdListAlloc.ReleaseAndGetAddressOf();
-		if(e->ObjectCB)				e->ObjectCB.release();
-		if (e->MaterialCB)			e->MaterialCB.release();
-		if (e->PassCB)				e->PassCB.release();
-	}	
-	mFrameResources.clear();
-	BuildFrameResources();
 
-	if(mCbvHeap.Get())	mCbvHeap.ReleaseAndGetAddressOf();
-	BuildDescriptorHeaps(); 
+	// Constants come from the constant ring, so only an instance buffer that is too
+	// small for the render items requires new frame resources.
+	const UINT capacity = mFrameResources.empty() ? 0 : mFrameResources[0]->InstanceCapacity;
+	const UINT instanceCapacity = (UINT)InstanceStreamBuilder::CapacityFor(mAllRitems.size(), capacity);
+	if (instanceCapacity == capacity)
+		return;
 
-	BuildConstantBufferViews();
+	// The GPU may still read the old frame resources.  Instead of waiting for it, they
+	// are released once the frames submitted so far have executed.
+	if (!mFrameResources.empty())
+	{
+		auto retired = std::make_shared<std::vector<std::unique_ptr<FrameResource>>>(std::move(mFrameResources));
+		mFenceService->OnCompleted(mFenceService->LastSignaled(), [retired] { retired->clear(); });
+	}
+
+	mFrameResources.clear();
+	BuildFrameResources(instanceCapacity);
 }
  
 void TetrisApp::mapInitialize() {
@@ -376,11 +585,13 @@ LRESULT TetrisApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 				case VK_4:
 					flicker2 = false;
 					flicker1 = flicker1 ? false : true;
+					mLightsDirty = true;
 					if (flicker1)  QueryPerformanceCounter((LARGE_INTEGER*)&flickerStartTime);
 					break;
 				case VK_5:
 					flicker1 = false;
 					flicker2 = flicker2 ? false : true;
+					mLightsDirty = true;
 					if (flicker2)  QueryPerformanceCounter((LARGE_INTEGER*)&flickerStartTime);
 					break;
 				case VK_NUMPAD0:
@@ -565,10 +776,16 @@ void TetrisApp::OnResize()
     // The window resized, so update the aspect ratio and recompute the projection matrix.
     XMMATRIX P = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
     XMStoreFloat4x4(&mProj, P);
+	mCameraDirty = true;
 }
 
 void TetrisApp::Update(const GameTimer& gt)
 {
+	mFenceService->ResetFrameStats();
+
+	// Run the deferred releases of every fence value completed so far; the wait below
+	// only reads the fence when it has to block.
+	mFenceService->Poll();
 
     OnKeyboardInput(gt);
 	UpdateCamera(gt);
@@ -612,16 +829,27 @@ void TetrisApp::Update(const GameTimer& gt)
 
     // Has the GPU finished processing the commands of the current frame resource?
     // If not, wait until the GPU has completed commands up to this fence point.
-    if(mCurrFrameResource->Fence != 0 && mFence->GetCompletedValue() < mCurrFrameResource->Fence)
-    {
-        HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-        ThrowIfFailed(mFence->SetEventOnCompletion(mCurrFrameResource->Fence, eventHandle));
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
-    }
+	mFenceService->Wait(mCurrFrameResource->Fence);
+
+	const UINT64 completedFence = mFenceService->CompletedValue();
+	mConstantRing->Reclaim(completedFence);
+	mStaging->Reclaim(completedFence);
 
+	mCurrFrameResource->ResetUploadStats();
+	mConstantRing->ResetWriteCount();
+	XMFLOAT4X4 sceneTransform;
+	XMStoreFloat4x4(&sceneTransform, SceneRotation(gt));
+	if (std::memcmp(&sceneTransform, &mSceneTransform, sizeof(XMFLOAT4X4)) != 0)
+	{
+		mSceneTransform = sceneTransform;
+		mCameraDirty = true;
+	}
+
+	CullRenderItems(gt);
+	SelectLods(gt);
 	UpdateObjectCBs(gt);
-	UpdateMaterialCBs(gt);
+	UpdateInstanceBuffer(gt);
+	UpdateMaterialBuffer(gt);
 	UpdateMainPassCB(gt);
 }
 
@@ -651,6 +879,9 @@ void TetrisApp::Draw(const GameTimer& gt)
 		);
 	}
 
+	// Buffer uploads staged since the last frame land before anything draws.
+	mStaging->Record(mCommandList.Get());
+
     mCommandList->RSSetViewports(1, &mScreenViewport);
     mCommandList->RSSetScissorRects(1, &mScissorRect);
 
@@ -665,17 +896,30 @@ void TetrisApp::Draw(const GameTimer& gt)
     // Specify the buffers we are going to render to.
     mCommandList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
 
-    ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvHeap.Get() };
-    mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
-    int passCbvIndex = mPassCbvOffset + mCurrFrameResourceIndex;
-    auto passCbvHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(mCbvHeap->GetGPUDescriptorHandleForHeapStart());
-    passCbvHandle.Offset(passCbvIndex, mCbvSrvUavDescriptorSize);
-    mCommandList->SetGraphicsRootDescriptorTable(2, passCbvHandle);
+	auto passCB = mCurrFrameResource->PassCB->Resource();
+	mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
+
+	// Bind all the materials used in this scene.  Materials are indexed per object
+	// or per instance, so this only needs to be set once per frame.
+	auto matBuffer = mCurrFrameResource->MaterialBuffer->Resource();
+	mCommandList->SetGraphicsRootShaderResourceView(1, matBuffer->GetGPUVirtualAddress());
+
+	mRenderQueue.Clear();
+	QueueRenderItems(mVisibleRitems[(int)RenderLayer::Opaque], RenderLayer::Opaque,
+		mPsoHandles["opaque" + PsoSuffix()]);
+	QueueInstanceBatches(mVisibleRitems[(int)RenderLayer::Instanced], RenderLayer::Instanced);
+	mRenderQueue.Sort();
 
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+	mCommandStream.Clear();
+	mRenderQueue.Encode(mCommandStream);
+
+	// Object constant slots are 256-byte blocks of the constant ring.
+	auto instanceBuffer = mCurrFrameResource->InstanceBuffer->Resource();
+	mRenderBackend.Begin(mCommandList.Get(), mConstantRing->GpuAddress(),
+		instanceBuffer->GetGPUVirtualAddress());
+	mCommandStream.Replay(mRenderBackend);
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -692,13 +936,22 @@ void TetrisApp::Draw(const GameTimer& gt)
     ThrowIfFailed(mSwapChain->Present(0, 0));
 	mCurrBackBuffer = (mCurrBackBuffer + 1) % SwapChainBufferCount;
 
-    // Advance the fence value to mark commands up to this fence point.
-    mCurrFrameResource->Fence = ++mCurrentFence;
-    
+	if (!mFirstFramePresented)
+	{
+		mFirstFramePresented = true;
+		std::chrono::duration<double, std::milli> sinceStart = std::chrono::steady_clock::now() - mStartTime;
+		std::wstring text = L"***First frame presented " + std::to_wstring(sinceStart.count()) + L" ms after startup\n";
+		::OutputDebugString(text.c_str());
+	}
+
     // Add an instruction to the command queue to set a new fence point. 
     // Because we are on the GPU timeline, the new fence point won't be 
     // set until the GPU finishes processing all the commands prior to this Signal().
-    mCommandQueue->Signal(mFence.Get(), mCurrentFence);
+    mCurrFrameResource->Fence = mFenceService->Signal();
+
+	// The constants written for this frame are free once the fence is reached.
+	mConstantRing->FinishFrame(mCurrFrameResource->Fence);
+	mStaging->FinishFrame(mCurrFrameResource->Fence);
 }
 
 void TetrisApp::OnMouseDown(WPARAM btnState, int x, int y)
@@ -789,7 +1042,7 @@ void TetrisApp::OnKeyboardInput(const GameTimer& gt)
 		if (TYPE != 0 && blockRoll(x, y)) {
 			for (int i = 0; i < 4; i++) {
 				mAllRitems.pop_back();
-				mRitemLayer[(int)RenderLayer::Opaque].pop_back();
+				mRitemLayer[(int)RenderLayer::Instanced].pop_back();
 				mObjCBIndex--;
 			}
 			for (auto& e : mAllRitems) e->Mat->NumFramesDirty = gNumFrameResources;
@@ -823,9 +1076,17 @@ void TetrisApp::OnKeyboardInput(const GameTimer& gt)
 void TetrisApp::UpdateCamera(const GameTimer& gt)
 {
 	// Convert Spherical to Cartesian coordinates.
-	mEyePos.x = mRadius*sinf(mPhi)*cosf(mTheta);
-	mEyePos.z = mRadius*sinf(mPhi)*sinf(mTheta);
-	mEyePos.y = mRadius*cosf(mPhi);
+	XMFLOAT3 eyePos;
+	eyePos.x = mRadius*sinf(mPhi)*cosf(mTheta);
+	eyePos.z = mRadius*sinf(mPhi)*sinf(mTheta);
+	eyePos.y = mRadius*cosf(mPhi);
+
+	// The target and up vector are fixed, so the view only changes with the eye.
+	if (eyePos.x == mEyePos.x && eyePos.y == mEyePos.y && eyePos.z == mEyePos.z)
+		return;
+
+	mEyePos = eyePos;
+	mCameraDirty = true;
 
 	// Build the view matrix.
 	XMVECTOR pos = XMVectorSet(mEyePos.x, mEyePos.y, mEyePos.z, 1.0f);
@@ -836,54 +1097,204 @@ void TetrisApp::UpdateCamera(const GameTimer& gt)
 	XMStoreFloat4x4(&mView, view);
 }
 
-void TetrisApp::UpdateObjectCBs(const GameTimer& gt)
+XMMATRIX TetrisApp::SceneRotation(const GameTimer& gt)
 {
-	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
+	if (!rotate)
+		return XMMatrixIdentity();
 
 	__int64 currTime;
 	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
 	auto t = (currTime - rotateStartTime) * gt.mSecondsPerCount;
 	float rotateSpeed = 0.3;
 
-	for(auto& e : mAllRitems)
+	return XMMatrixRotationY(t * rotateSpeed * XM_2PI);
+}
+
+void TetrisApp::CullRenderItems(const GameTimer& gt)
+{
+	XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&mView), XMLoadFloat4x4(&mProj));
+	XMFLOAT4X4 vp;
+	XMStoreFloat4x4(&vp, viewProj);
+	Frustum frustum = Frustum::FromViewProj(&vp.m[0][0]);
+
+	const float* rotation = rotate ? &mSceneTransform.m[0][0] : nullptr;
+
+	for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
 	{
-		XMMATRIX world = XMLoadFloat4x4(&e->World);
-		XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
+		const auto& ritems = mRitemLayer[layer];
+
+		// Rotate the whole layer in one batch.
+		mCullWorlds.resize(ritems.size());
+		for (size_t i = 0; i < ritems.size(); ++i)
+			mCullWorlds[i] = ritems[i]->World;
+		TransformBatch::Multiply(&mCullWorlds.data()->m[0][0], sizeof(XMFLOAT4X4), mCullWorlds.size(),
+			rotation, &mCullWorlds.data()->m[0][0], sizeof(XMFLOAT4X4));
+
+		mCullBoxes.Clear();
+		mCullBoxes.Reserve(ritems.size());
+		for (size_t i = 0; i < ritems.size(); ++i)
+		{
+			const auto& e = ritems[i];
+			mCullBoxes.AddTransformed(&e->Bounds.Center.x, &e->Bounds.Extents.x, &mCullWorlds[i].m[0][0]);
+		}
 
-		if (rotate) {
-			world *= XMMatrixRotationY(t * rotateSpeed * XM_2PI);
+		mCullVisible.resize(ritems.size());
+		mCullBoxes.Cull(frustum, mCullVisible.data());
+
+		mVisibleRitems[layer].clear();
+		for (size_t i = 0; i < ritems.size(); ++i)
+		{
+			if (mCullVisible[i])
+				mVisibleRitems[layer].push_back(ritems[i]);
 		}
+	}
+}
 
-		ObjectConstants objConstants;
-		XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
-		XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
+void TetrisApp::SelectLods(const GameTimer& gt)
+{
+	XMMATRIX view = XMLoadFloat4x4(&mView);
+	XMMATRIX rotation = XMLoadFloat4x4(&mSceneTransform);
+
+	// Converts a radius at view space depth 1 to pixels.
+	float pixelsPerUnit = 0.5f*mClientHeight*mProj._22;
 
-		currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+	for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+	{
+		for (auto& e : mVisibleRitems[layer])
+		{
+			if (e->Lods == nullptr)
+				continue;
 
-		if (e->NumFramesDirty > 0)	e->NumFramesDirty--;
+			XMMATRIX world = XMLoadFloat4x4(&e->World);
+			if (rotate) {
+				world *= rotation;
+			}
 
-		/*
-		// Only update the cbuffer data if the constants have changed.  
-		// This needs to be tracked per frame resource.
+			// Project the bounding sphere at its nearest point.
+			XMVECTOR centerV = XMVector3TransformCoord(XMLoadFloat3(&e->Bounds.Center), world*view);
+			float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&e->Bounds.Extents)));
+			float scale = XMVectorGetX(XMVector3Length(world.r[0]));
+			float depth = (std::max)(XMVectorGetZ(centerV) - radius*scale, 0.001f);
+			float screenRadius = radius*scale*pixelsPerUnit / depth;
+
+			size_t lod = MeshSimplifier::SelectLod(e->Lods->Errors, radius, screenRadius);
+			const MeshLodChain::Level& level = e->Lods->Levels[lod];
+			e->MeshId = level.MeshId;
+			e->IndexCount = level.IndexCount;
+			e->StartIndexLocation = level.StartIndexLocation;
+		}
+	}
+}
+
+void TetrisApp::UpdateObjectCBs(const GameTimer& gt)
+{
+	XMMATRIX rotation = XMLoadFloat4x4(&mSceneTransform);
+
+	// Instanced render items are written to the instance buffer instead.  Only the
+	// items drawn this frame need constants.
+	const auto& ritems = mVisibleRitems[(int)RenderLayer::Opaque];
+
+	// Only rebuild the constants if the object has changed.  The scene rotation is
+	// applied by the shaders, so it does not dirty the items.
+	mDirtyRitems.clear();
+	mDirtyTransforms.clear();
+	for(auto& e : ritems)
+	{
 		if(e->NumFramesDirty > 0)
 		{
-			XMMATRIX world = XMLoadFloat4x4(&e->World);
+			mDirtyRitems.push_back(e);
+			mDirtyTransforms.push_back(e->World);
+			mDirtyTransforms.push_back(e->TexTransform);
+		}
+	}
 
-			ObjectConstants objConstants;
-			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+	if(!mDirtyTransforms.empty())
+	{
+		TransformBatch::MultiplyTranspose(&mDirtyTransforms.data()->m[0][0], sizeof(XMFLOAT4X4),
+			mDirtyTransforms.size(), nullptr, 4, &mDirtyTransforms.data()->m[0][0], sizeof(XMFLOAT4X4));
+	}
 
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+	for(size_t i = 0; i < mDirtyRitems.size(); ++i)
+	{
+		RenderItem* e = mDirtyRitems[i];
+		e->Constants.World = mDirtyTransforms[2*i];
+		e->Constants.TexTransform = mDirtyTransforms[2*i + 1];
+		e->Constants.MaterialIndex = e->Mat->MatCBIndex;
 
-			// Next FrameResource need to be updated too.
-			e->NumFramesDirty--;
+		e->NumFramesDirty = 0;
+	}
+
+	for(auto& e : ritems)
+	{
+		XMMATRIX world = XMLoadFloat4x4(&e->World);
+
+		UploadRing::Allocation chunk = mConstantRing->WriteConstants(e->Constants);
+		e->ObjectCBSlot = (UINT)(chunk.Offset / D3D12RenderBackend::ConstantSlotSize);
+
+		if (rotate) {
+			world *= rotation;
 		}
-		*/
+
+		XMFLOAT4X4 w;
+		XMStoreFloat4x4(&w, world);
+		e->ViewDepth = w._41*mView._13 + w._42*mView._23 + w._43*mView._33 + mView._43;
 	}
 }
 
-void TetrisApp::UpdateMaterialCBs(const GameTimer& gt)
+void TetrisApp::UpdateInstanceBuffer(const GameTimer& gt)
 {
-	auto currMaterialCB = mCurrFrameResource->MaterialCB.get();
+	auto currInstanceBuffer = mCurrFrameResource->InstanceBuffer.get();
+	const auto& ritems = mVisibleRitems[(int)RenderLayer::Instanced];
+
+	// The scene rotation is applied by the shaders, so the instances only change
+	// when the board does.
+	const UINT pso = mPsoHandles["opaque_instanced" + PsoSuffix()];
+
+	mInstanceStream.Reset();
+	mInstanceStream.Reserve(ritems.size());
+	for (auto& e : ritems)
+	{
+		const XMFLOAT4& albedo = e->Mat->DiffuseAlbedo;
+		mInstanceStream.Add(pso, e->MeshId, e->Mat->MatCBIndex, &e->World.m[0][0],
+			InstanceStreamBuilder::PackColor(albedo.x, albedo.y, albedo.z, albedo.w));
+	}
+	mInstanceStream.Build();
+
+	// Write only the instances that differ from what this frame resource's buffer
+	// holds, each run of them in one streaming pass.  Past the end of the stream the
+	// buffer keeps its old instances, so the copy is never shrunk.
+	const auto& instances = mInstanceStream.Instances();
+	auto& written = mCurrFrameResource->WrittenInstances;
+	const size_t writtenCount = written.size();
+	if (written.size() < instances.size())
+		written.resize(instances.size());
+
+	auto changed = [&](size_t i)
+	{
+		return i >= writtenCount || std::memcmp(&written[i], &instances[i], sizeof(InstanceData)) != 0;
+	};
+
+	for (size_t i = 0; i < instances.size();)
+	{
+		if (!changed(i))
+		{
+			++i;
+			continue;
+		}
+
+		size_t end = i + 1;
+		while (end < instances.size() && changed(end))
+			++end;
+
+		currInstanceBuffer->CopyRange((int)i, &instances[i], (UINT)(end - i));
+		std::copy(instances.begin() + i, instances.begin() + end, written.begin() + i);
+		i = end;
+	}
+}
+
+void TetrisApp::UpdateMaterialBuffer(const GameTimer& gt)
+{
+	auto currMaterialBuffer = mCurrFrameResource->MaterialBuffer.get();
 	for (auto& e : mMaterials)
 	{
 		// Only update the cbuffer data if the constants have changed.  If the cbuffer
@@ -893,13 +1304,13 @@ void TetrisApp::UpdateMaterialCBs(const GameTimer& gt)
 		{
 			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
-			MaterialConstants matConstants;
-			matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matConstants.FresnelR0 = mat->FresnelR0;
-			matConstants.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+			MaterialData matData;
+			matData.DiffuseAlbedo = mat->DiffuseAlbedo;
+			matData.FresnelR0 = mat->FresnelR0;
+			matData.Roughness = mat->Roughness;
+			XMStoreFloat4x4(&matData.MatTransform, XMMatrixTranspose(matTransform));
 
-			currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+			currMaterialBuffer->CopyData(mat->MatCBIndex, matData);
 
 			// Next FrameResource need to be updated too.
 			mat->NumFramesDirty--;
@@ -909,147 +1320,108 @@ void TetrisApp::UpdateMaterialCBs(const GameTimer& gt)
 
 void TetrisApp::UpdateMainPassCB(const GameTimer& gt)
 {
-	XMMATRIX view = XMLoadFloat4x4(&mView);
-	XMMATRIX proj = XMLoadFloat4x4(&mProj);
-
-	XMMATRIX viewProj = XMMatrixMultiply(view, proj);
-	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
-	XMMATRIX invProj = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
-	XMMATRIX invViewProj = XMMatrixInverse(&XMMatrixDeterminant(viewProj), viewProj);
-
-	XMStoreFloat4x4(&mMainPassCB.View, XMMatrixTranspose(view));
-	XMStoreFloat4x4(&mMainPassCB.InvView, XMMatrixTranspose(invView));
-	XMStoreFloat4x4(&mMainPassCB.Proj, XMMatrixTranspose(proj));
-	XMStoreFloat4x4(&mMainPassCB.InvProj, XMMatrixTranspose(invProj));
-	XMStoreFloat4x4(&mMainPassCB.ViewProj, XMMatrixTranspose(viewProj));
-	XMStoreFloat4x4(&mMainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
-	mMainPassCB.EyePosW = mEyePos;
-	mMainPassCB.RenderTargetSize = XMFLOAT2((float)mClientWidth, (float)mClientHeight);
-	mMainPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / mClientWidth, 1.0f / mClientHeight);
-	mMainPassCB.NearZ = 1.0f;
-	mMainPassCB.FarZ = 1000.0f;
-	mMainPassCB.TotalTime = gt.TotalTime();
-	mMainPassCB.DeltaTime = gt.DeltaTime();
-	XMVECTOR AmbientL = { 0.25f, 0.25f, 0.35f, 1.0f };
-	XMVECTOR lightStrength[3] = { { 0.6f, 0.6f, 0.6f }, {0.3f, 0.3f, 0.3f}, {0.15f, 0.15f, 0.15f} };
-
-	if (flicker1 || flicker2) {
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-		auto t = (currTime - flickerStartTime) * gt.mSecondsPerCount;
-		float flickerSpeed = 1.0f;
+	// Flickering lights change every frame.
+	if (flicker1 || flicker2)
+		mLightsDirty = true;
 
-		float trans = (cosf(t * flickerSpeed * XM_PI) + 1) / 2;
-
-		if(flicker2) 
-			trans = ( trans > 0.3 ) ? 1.0f : 0.0f;
-
-		AmbientL *= trans;
-		lightStrength[0] *= trans;
-		lightStrength[1] *= trans;
-		lightStrength[2] *= trans;
+	if (mCameraDirty)
+	{
+		XMMATRIX view = XMLoadFloat4x4(&mView);
+		XMMATRIX proj = XMLoadFloat4x4(&mProj);
+
+		// The view is a rigid transform and the projection a perspective one, so
+		// neither needs the general inverse.
+		XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+		XMMATRIX invView = MathHelper::InverseRigid(view);
+		XMMATRIX invProj = MathHelper::InversePerspective(proj);
+		XMMATRIX invViewProj = XMMatrixMultiply(invProj, invView);
+
+		XMStoreFloat4x4(&mMainPassCB.View, XMMatrixTranspose(view));
+		XMStoreFloat4x4(&mMainPassCB.InvView, XMMatrixTranspose(invView));
+		XMStoreFloat4x4(&mMainPassCB.Proj, XMMatrixTranspose(proj));
+		XMStoreFloat4x4(&mMainPassCB.InvProj, XMMatrixTranspose(invProj));
+		XMStoreFloat4x4(&mMainPassCB.ViewProj, XMMatrixTranspose(viewProj));
+		XMStoreFloat4x4(&mMainPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
+		XMStoreFloat4x4(&mMainPassCB.SceneTransform, XMMatrixTranspose(XMLoadFloat4x4(&mSceneTransform)));
+		mMainPassCB.EyePosW = mEyePos;
+		mMainPassCB.RenderTargetSize = XMFLOAT2((float)mClientWidth, (float)mClientHeight);
+		mMainPassCB.InvRenderTargetSize = XMFLOAT2(1.0f / mClientWidth, 1.0f / mClientHeight);
+		mMainPassCB.NearZ = 1.0f;
+		mMainPassCB.FarZ = 1000.0f;
+
+		mCameraDirty = false;
+		mPassFramesDirty = gNumFrameResources;
 	}
-	XMStoreFloat4(&mMainPassCB.AmbientLight, AmbientL);
-	mMainPassCB.Lights[0].Direction = { 0.57735f, -0.57735f, 0.57735f };
-	XMStoreFloat3(&mMainPassCB.Lights[0].Strength, lightStrength[0]);
-	mMainPassCB.Lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
-	XMStoreFloat3(&mMainPassCB.Lights[1].Strength, lightStrength[1]);
-	mMainPassCB.Lights[2].Direction = { 0.0f, -0.707f, -0.707f };
-	XMStoreFloat3(&mMainPassCB.Lights[2].Strength, lightStrength[2]);
-
-	auto currPassCB = mCurrFrameResource->PassCB.get();
-	currPassCB->CopyData(0, mMainPassCB);
-}
 
-void TetrisApp::BuildDescriptorHeaps()
-{
-    UINT objCount = (UINT)mRitemLayer[(int)RenderLayer::Opaque].size();
-
-    // Need a CBV descriptor for each object for each frame resource,
-    // +1 for the perPass CBV for each frame resource.
-    UINT numDescriptors = (objCount+1) * gNumFrameResources;
-
-    // Save an offset to the start of the pass CBVs.  These are the last 3 descriptors.
-    mPassCbvOffset = objCount * gNumFrameResources;
-
-    D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc;
-    cbvHeapDesc.NumDescriptors = numDescriptors;
-    cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    cbvHeapDesc.NodeMask = 0;
-    ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&cbvHeapDesc,
-        IID_PPV_ARGS(&mCbvHeap)));
-}
-
-void TetrisApp::BuildConstantBufferViews()
-{
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-
-    UINT objCount = (UINT)mRitemLayer[(int)RenderLayer::Opaque].size();
-
-    // Need a CBV descriptor for each object for each frame resource.
-    for(int frameIndex = 0; frameIndex < gNumFrameResources; ++frameIndex)
-    {
-        auto objectCB = mFrameResources[frameIndex]->ObjectCB->Resource();
-        for(UINT i = 0; i < objCount; ++i)
-        {
-            D3D12_GPU_VIRTUAL_ADDRESS cbAddress = objectCB->GetGPUVirtualAddress();
+	if (mLightsDirty)
+	{
+		XMVECTOR AmbientL = { 0.25f, 0.25f, 0.35f, 1.0f };
+		XMVECTOR lightStrength[3] = { { 0.6f, 0.6f, 0.6f }, {0.3f, 0.3f, 0.3f}, {0.15f, 0.15f, 0.15f} };
 
-            // Offset to the ith object constant buffer in the buffer.
-            cbAddress += i*objCBByteSize;
+		if (flicker1 || flicker2) {
+			__int64 currTime;
+			QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+			auto t = (currTime - flickerStartTime) * gt.mSecondsPerCount;
+			float flickerSpeed = 1.0f;
 
-            // Offset to the object cbv in the descriptor heap.
-            int heapIndex = frameIndex*objCount + i;
-            auto handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(mCbvHeap->GetCPUDescriptorHandleForHeapStart());
-            handle.Offset(heapIndex, mCbvSrvUavDescriptorSize);
+			float trans = (cosf(t * flickerSpeed * XM_PI) + 1) / 2;
 
-            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-            cbvDesc.BufferLocation = cbAddress;
-            cbvDesc.SizeInBytes = objCBByteSize;
+			if(flicker2) 
+				trans = ( trans > 0.3 ) ? 1.0f : 0.0f;
 
-            md3dDevice->CreateConstantBufferView(&cbvDesc, handle);
-        }
-    }
+			AmbientL *= trans;
+			lightStrength[0] *= trans;
+			lightStrength[1] *= trans;
+			lightStrength[2] *= trans;
+		}
+		XMStoreFloat4(&mMainPassCB.AmbientLight, AmbientL);
+		mMainPassCB.Lights[0].Direction = { 0.57735f, -0.57735f, 0.57735f };
+		XMStoreFloat3(&mMainPassCB.Lights[0].Strength, lightStrength[0]);
+		mMainPassCB.Lights[1].Direction = { -0.57735f, -0.57735f, 0.57735f };
+		XMStoreFloat3(&mMainPassCB.Lights[1].Strength, lightStrength[1]);
+		mMainPassCB.Lights[2].Direction = { 0.0f, -0.707f, -0.707f };
+		XMStoreFloat3(&mMainPassCB.Lights[2].Strength, lightStrength[2]);
+
+		mLightsDirty = false;
+		mPassFramesDirty = gNumFrameResources;
+	}
 
-    UINT passCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants));
+	// The times change every frame and are always written.
+	mMainPassCB.TotalTime = gt.TotalTime();
+	mMainPassCB.DeltaTime = gt.DeltaTime();
 
-    // Last three descriptors are the pass CBVs for each frame resource.
-    for(int frameIndex = 0; frameIndex < gNumFrameResources; ++frameIndex)
-    {
-        auto passCB = mFrameResources[frameIndex]->PassCB->Resource();
-        D3D12_GPU_VIRTUAL_ADDRESS cbAddress = passCB->GetGPUVirtualAddress();
-
-        // Offset to the pass cbv in the descriptor heap.
-        int heapIndex = mPassCbvOffset + frameIndex;
-        auto handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(mCbvHeap->GetCPUDescriptorHandleForHeapStart());
-        handle.Offset(heapIndex, mCbvSrvUavDescriptorSize);
-
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-        cbvDesc.BufferLocation = cbAddress;
-        cbvDesc.SizeInBytes = passCBByteSize;
-        
-        md3dDevice->CreateConstantBufferView(&cbvDesc, handle);
-    }
+	// Each frame resource has its own copy, so after a change every copy is written
+	// once; in between only the times of this frame's copy are.
+	static_assert(offsetof(PassConstants, DeltaTime) == offsetof(PassConstants, TotalTime) + sizeof(float),
+		"TotalTime and DeltaTime are written together.");
+	if (mPassFramesDirty > 0)
+	{
+		mCurrFrameResource->PassCB->CopyData(0, mMainPassCB);
+		mPassFramesDirty--;
+	}
+	else
+	{
+		mCurrFrameResource->PassCB->CopyBytes(0, offsetof(PassConstants, TotalTime), &mMainPassCB.TotalTime, 2*sizeof(float));
+	}
 }
 
 void TetrisApp::BuildRootSignature()
 {
-    CD3DX12_DESCRIPTOR_RANGE cbvTable0;
-    cbvTable0.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-
-    CD3DX12_DESCRIPTOR_RANGE cbvTable1;
-    cbvTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 2);
-
 	// Root parameter can be a table, root descriptor or root constants.
-	CD3DX12_ROOT_PARAMETER slotRootParameter[3];
+	CD3DX12_ROOT_PARAMETER slotRootParameter[5];
 
-	// Create root CBVs.
-    slotRootParameter[0].InitAsDescriptorTable(1, &cbvTable0);
-	slotRootParameter[1].InitAsConstantBufferView(1);
-    slotRootParameter[2].InitAsDescriptorTable(1, &cbvTable1);
+	// Create root CBVs.  The object constants are bound by their address in the
+	// constant ring, the pass constants by the pass buffer of the frame resource.
+    slotRootParameter[0].InitAsConstantBufferView(0);
+	slotRootParameter[1].InitAsShaderResourceView(1);
+    slotRootParameter[2].InitAsConstantBufferView(2);
+	slotRootParameter[3].InitAsShaderResourceView(0);
+
+	// Per-mesh vertex dequantization (QuantizationBounds).
+	slotRootParameter[4].InitAsConstants(sizeof(QuantizationBounds)/4, 3);
 
 	// A root signature is an array of root parameters.
-	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(3, slotRootParameter, 0, nullptr, 
+	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(5, slotRootParameter, 0, nullptr, 
         D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
 	// create a root signature with a single slot which points to a descriptor range consisting of a single constant buffer
@@ -1071,217 +1443,262 @@ void TetrisApp::BuildRootSignature()
 		IID_PPV_ARGS(mRootSignature.GetAddressOf())));
 }
 
-void TetrisApp::BuildShadersAndInputLayout()
+std::vector<TaskGraph::TaskId> TetrisApp::BuildShadersAndInputLayout(TaskGraph& startup)
 {
-	mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders\\Default.hlsl", nullptr, "PS", "ps_5_1");
-	mShaders["opaqueToonShadingPS"] = d3dUtil::CompileShader(L"Shaders\\toonShading.hlsl", nullptr, "PS", "ps_5_1");
+	struct ShaderDesc
+	{
+		const char* Name;
+		const wchar_t* Filename;
+		const char* EntryPoint;
+		const char* Target;
+	};
+
+	const ShaderDesc shaders[] =
+	{
+		{ "standardVS", L"Shaders\\Default.hlsl", "VS", "vs_5_1" },
+		{ "instancedVS", L"Shaders\\Default.hlsl", "VSInstanced", "vs_5_1" },
+		{ "opaquePS", L"Shaders\\Default.hlsl", "PS", "ps_5_1" },
+		{ "opaqueToonShadingPS", L"Shaders\\toonShading.hlsl", "PS", "ps_5_1" },
+	};
+
+	// Every shader compiles in its own task.  The map entries are created here so the
+	// tasks only write to their own blob.
+	std::vector<TaskGraph::TaskId> tasks;
+	for (const ShaderDesc& desc : shaders)
+	{
+		ComPtr<ID3DBlob>& blob = mShaders[desc.Name];
+		tasks.push_back(startup.Add(std::string("compile ") + desc.Name, [&blob, desc]
+		{
+			blob = d3dUtil::CompileShader(desc.Filename, nullptr, desc.EntryPoint, desc.Target);
+		}));
+	}
 	
     mInputLayout =
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
     };
+
+	return tasks;
 }
 
-void TetrisApp::BuildShapeGeometry()
+// Reorders the triangle list for the vertex cache and reports the average cache miss
+// ratio (vertices transformed per triangle) before and after.
+static void OptimizeShapeMesh(const std::wstring& name, GeometryGenerator::MeshData& mesh)
 {
-    GeometryGenerator geoGen;
-	GeometryGenerator::MeshData box = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 0);
-	GeometryGenerator::MeshData backgroundGrid = geoGen.CreateGrid((float)WIDTH-2, (float)HEIGHT-2, HEIGHT-1, WIDTH-1);
+	size_t vertexCount = mesh.Vertices.size();
+	float before = MeshOptimize::ComputeAcmr(mesh.Indices32.data(), mesh.Indices32.size(), vertexCount);
 
-	backgroundGrid.Indices32.clear();
-	backgroundGrid.Indices32.resize( ((HEIGHT)*(WIDTH) * 2) * 4); // 4 indices per face
+	GeometryGenerator().OptimizeMesh(mesh);
 
-	// Iterate over each quad and compute indices.
+	float after = MeshOptimize::ComputeAcmr(mesh.Indices32.data(), mesh.Indices32.size(), vertexCount);
+	std::wstring text = L"***ACMR " + name + L": " + std::to_wstring(before) + L" -> " + std::to_wstring(after) + L"\n";
+	::OutputDebugString(text.c_str());
+}
+
+// Opens Models/<name>.mesh, baking it from Models/<name>.txt first when it is missing
+// or stale, and reports the average cache miss ratio of each level of detail.
+static void LoadModel(const std::string& name, MeshFile& file)
+{
+	std::string error;
+	bool rebuilt = false;
+	if (!MeshBake::Load("Models/" + name + ".txt", "Models/" + name + ".mesh", MeshBakeSettings(), file, error, &rebuilt))
+		throw std::runtime_error(error);
+
+	const MeshFileHeader& header = file.Header();
+	std::string text = "***" + name + ".mesh" + (rebuilt ? " (rebuilt)" : "") + ": ACMR";
+	for (UINT i = 0; i < header.LodCount; ++i)
 	{
-		int m = HEIGHT-1, n = WIDTH-1;
-		unsigned int k = 0;
-		for (unsigned int i = 0; i < m-1; ++i)
+		const MeshFileLod& lod = file.Lods()[i];
+		text += " " + std::to_string(MeshOptimize::ComputeAcmr(file.Indices() + lod.StartIndex, lod.IndexCount, header.VertexCount));
+	}
+	::OutputDebugStringA((text + "\n").c_str());
+}
+
+TaskGraph::TaskId TetrisApp::BuildShapeGeometry(TaskGraph& startup)
+{
+	mShapeMeshes = std::make_unique<ShapeMeshes>();
+	ShapeMeshes& meshes = *mShapeMeshes;
+
+	std::vector<TaskGraph::TaskId> meshTasks;
+
+	// The models are baked offline (Tools/MeshConverter.cpp) or on the first load:
+	// levels of detail, vertex cache order and quantized vertices.  The levels index
+	// the vertices of the full meshes and the chains stop before the error reaches 2%
+	// of the mesh size (MeshBakeSettings).
+	meshTasks.push_back(startup.Add("skull load", [&meshes] { LoadModel("skull", meshes.Skull); }));
+	meshTasks.push_back(startup.Add("car load", [&meshes] { LoadModel("car", meshes.Car); }));
+
+	// The generated meshes come from the mesh cache; the keys name the generator and
+	// the vertex cache optimization applied to its output.
+	MeshCache& cache = mMeshCache;
+
+	meshTasks.push_back(startup.Add("box mesh", [&meshes, &cache]
+	{
+		meshes.Box = cache.GetOrCreate(MeshKey("CreateBox+OptimizeMesh", 1.0f, 1.0f, 1.0f, 0u), []
 		{
-			for (unsigned int j = 0; j < n-1; ++j)
-			{
+			GeometryGenerator::MeshData box = GeometryGenerator().CreateBox(1.0f, 1.0f, 1.0f, 0);
+			OptimizeShapeMesh(L"box", box);
+			return box;
+		});
+	}));
+
+	// The background grid is a line list and keeps its order.
+	meshTasks.push_back(startup.Add("background grid mesh", [&meshes, &cache]
+	{
+		meshes.BackgroundGrid = cache.GetOrCreate(MeshKey("BackgroundGrid", WIDTH, HEIGHT), []
+		{
+			GeometryGenerator::MeshData backgroundGrid = GeometryGenerator().CreateGrid((float)WIDTH-2, (float)HEIGHT-2, HEIGHT-1, WIDTH-1);
 
-				backgroundGrid.Indices32[k] = (i + 1)*n + j;
-				backgroundGrid.Indices32[k+1] = i * n + j;
+			backgroundGrid.Indices32.clear();
+			backgroundGrid.Indices32.resize( ((HEIGHT)*(WIDTH) * 2) * 4); // 4 indices per face
 
-				backgroundGrid.Indices32[k + 2] = i * n + j;
-				backgroundGrid.Indices32[k + 3] = i * n + j + 1;
+			// Iterate over each quad and compute indices.
+			int m = HEIGHT-1, n = WIDTH-1;
+			unsigned int k = 0;
+			for (unsigned int i = 0; i < m-1; ++i)
+			{
+				for (unsigned int j = 0; j < n-1; ++j)
+				{
 
-				backgroundGrid.Indices32[k + 4] = i * n + j + 1;
-				backgroundGrid.Indices32[k + 5] = (i + 1)*n + j + 1;
+					backgroundGrid.Indices32[k] = (i + 1)*n + j;
+					backgroundGrid.Indices32[k+1] = i * n + j;
 
-				backgroundGrid.Indices32[k + 6] = (i + 1)*n + j + 1;
-				backgroundGrid.Indices32[k + 7] = (i + 1)*n + j;
+					backgroundGrid.Indices32[k + 2] = i * n + j;
+					backgroundGrid.Indices32[k + 3] = i * n + j + 1;
 
-				k += 8; // next quad
-			}
-		}
-	}
+					backgroundGrid.Indices32[k + 4] = i * n + j + 1;
+					backgroundGrid.Indices32[k + 5] = (i + 1)*n + j + 1;
 
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
-	GeometryGenerator::MeshData sphere = geoGen.CreateGeosphere(0.5f, 3);
-	GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
-	GeometryGenerator::MeshData skull = geoGen.CreateFromFile("skull.txt");
-	GeometryGenerator::MeshData car = geoGen.CreateFromFile("car.txt");
-
-
-	// Cache the vertex offsets to each object in the concatenated vertex buffer.
-	UINT boxVertexOffset = 0;
-	UINT backgroundGridVertexOffset = boxVertexOffset + (UINT)box.Vertices.size();
-	UINT gridVertexOffset			= backgroundGridVertexOffset + (UINT)backgroundGrid.Vertices.size();
-	UINT sphereVertexOffset			= gridVertexOffset + (UINT)grid.Vertices.size();
-	UINT cylinderVertexOffset		= sphereVertexOffset + (UINT)sphere.Vertices.size();
-	UINT skullVertexOffset			= cylinderVertexOffset + (UINT)cylinder.Vertices.size();
-	UINT carVertexOffset			= skullVertexOffset + (UINT)skull.Vertices.size();
-
-	// Cache the starting index for each object in the concatenated index buffer.
-	UINT boxIndexOffset = 0;
-	UINT backgroundGridIndexOffset	= boxIndexOffset + (UINT)box.Indices32.size();
-	UINT gridIndexOffset			= backgroundGridIndexOffset+ (UINT)backgroundGrid.Indices32.size();
-	UINT sphereIndexOffset			= gridIndexOffset + (UINT)grid.Indices32.size();
-	UINT cylinderIndexOffset		= sphereIndexOffset + (UINT)sphere.Indices32.size();
-	UINT skullIndexOffset			= cylinderIndexOffset + (UINT)cylinder.Indices32.size();
-	UINT carIndexOffset				= skullIndexOffset + (UINT)skull.Indices32.size();
-
-    // Define the SubmeshGeometry that cover different 
-    // regions of the vertex/index buffers.
-
-	SubmeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
-	boxSubmesh.StartIndexLocation = boxIndexOffset;
-	boxSubmesh.BaseVertexLocation = boxVertexOffset;
-
-	SubmeshGeometry backgroundGridSubmesh;
-	backgroundGridSubmesh.IndexCount = (UINT)backgroundGrid.Indices32.size();
-	backgroundGridSubmesh.StartIndexLocation = backgroundGridIndexOffset;
-	backgroundGridSubmesh.BaseVertexLocation = backgroundGridVertexOffset;
-
-	SubmeshGeometry gridSubmesh;
-	gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
-	gridSubmesh.StartIndexLocation = gridIndexOffset;
-	gridSubmesh.BaseVertexLocation = gridVertexOffset;
-
-	SubmeshGeometry sphereSubmesh;
-	sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
-	sphereSubmesh.StartIndexLocation = sphereIndexOffset;
-	sphereSubmesh.BaseVertexLocation = sphereVertexOffset;
-
-	SubmeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
-	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
-
-	SubmeshGeometry skullSubmesh;
-	skullSubmesh.IndexCount = (UINT)skull.Indices32.size();
-	skullSubmesh.StartIndexLocation = skullIndexOffset;
-	skullSubmesh.BaseVertexLocation = skullVertexOffset;
-
-	SubmeshGeometry carSubmesh;
-	carSubmesh.IndexCount = (UINT)car.Indices32.size();
-	carSubmesh.StartIndexLocation = carIndexOffset;
-	carSubmesh.BaseVertexLocation = carVertexOffset;
-	
-	//
-	// Extract the vertex elements we are interested in and pack the
-	// vertices of all the meshes into one vertex buffer.
-	//
+					backgroundGrid.Indices32[k + 6] = (i + 1)*n + j + 1;
+					backgroundGrid.Indices32[k + 7] = (i + 1)*n + j;
 
-	auto totalVertexCount =
-		box.Vertices.size()
-		+	backgroundGrid.Vertices.size() 
-		+	grid.Vertices.size() 
-		+	sphere.Vertices.size() 
-		+	cylinder.Vertices.size()
-		+	skull.Vertices.size()
-		+	car.Vertices.size();
+					k += 8; // next quad
+				}
+			}
 
-	std::vector<Vertex> vertices(totalVertexCount);
+			return backgroundGrid;
+		});
+	}));
 
-	UINT k = 0;
-	for (size_t i = 0; i < box.Vertices.size(); ++i, ++k)
+	meshTasks.push_back(startup.Add("grid mesh", [&meshes, &cache]
 	{
-		vertices[k].Pos = box.Vertices[i].Position;
-		vertices[k].Normal = box.Vertices[i].Normal;
-	}
+		meshes.Grid = cache.GetOrCreate(MeshKey("CreateGrid+OptimizeMesh", 20.0f, 30.0f, 60u, 40u), []
+		{
+			GeometryGenerator::MeshData grid = GeometryGenerator().CreateGrid(20.0f, 30.0f, 60, 40);
+			OptimizeShapeMesh(L"grid", grid);
+			return grid;
+		});
+	}));
 
-	for (size_t i = 0; i < backgroundGrid.Vertices.size(); ++i, ++k)
+	meshTasks.push_back(startup.Add("sphere mesh", [&meshes, &cache]
 	{
-		vertices[k].Pos = backgroundGrid.Vertices[i].Position;
-		vertices[k].Normal = backgroundGrid.Vertices[i].Normal;
-	}
+		meshes.Sphere = cache.GetOrCreate(MeshKey("CreateGeosphere+OptimizeMesh", 0.5f, 3u), []
+		{
+			GeometryGenerator::MeshData sphere = GeometryGenerator().CreateGeosphere(0.5f, 3);
+			OptimizeShapeMesh(L"sphere", sphere);
+			return sphere;
+		});
+	}));
 
-	for (size_t i = 0; i < grid.Vertices.size(); ++i, ++k)
+	meshTasks.push_back(startup.Add("cylinder mesh", [&meshes, &cache]
 	{
-		vertices[k].Pos = grid.Vertices[i].Position;
-		vertices[k].Normal = grid.Vertices[i].Normal;
-	}
+		meshes.Cylinder = cache.GetOrCreate(MeshKey("CreateCylinder+OptimizeMesh", 0.5f, 0.3f, 3.0f, 20u, 20u), []
+		{
+			GeometryGenerator::MeshData cylinder = GeometryGenerator().CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
+			OptimizeShapeMesh(L"cylinder", cylinder);
+			return cylinder;
+		});
+	}));
+
+	// Recording the upload is the only use of the command list during startup.
+	return startup.Add("geometry upload", [this] { UploadShapeGeometry(); }, meshTasks);
+}
 
-	for (size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
+void TetrisApp::UploadShapeGeometry()
+{
+	const ShapeMeshes& meshes = *mShapeMeshes;
+
+	// The meshes are concatenated in this order, followed by the coarser levels of
+	// detail; level 0 of a chain is the mesh itself.
+	MeshAtlasBuilder atlas;
+	atlas.AddMesh("box", meshes.Box->View());
+	atlas.AddMesh("backgroundGrid", meshes.BackgroundGrid->View());
+	atlas.AddMesh("grid", meshes.Grid->View());
+	atlas.AddMesh("sphere", meshes.Sphere->View());
+	atlas.AddMesh("cylinder", meshes.Cylinder->View());
+	UINT skullMesh = atlas.AddMesh("skull", meshes.Skull);
+	UINT carMesh = atlas.AddMesh("car", meshes.Car);
+
+	auto lodName = [](const std::string& name, size_t level)
 	{
-		vertices[k].Pos = sphere.Vertices[i].Position;
-		vertices[k].Normal = sphere.Vertices[i].Normal;
-	}
-
-	for (size_t i = 0; i < cylinder.Vertices.size(); ++i, ++k)
+		return level == 0 ? name : name + "_lod" + std::to_string(level);
+	};
+	auto addLods = [&](const std::string& name, UINT mesh, const MeshFile& file)
 	{
-		vertices[k].Pos = cylinder.Vertices[i].Position;
-		vertices[k].Normal = cylinder.Vertices[i].Normal;
-	}
-
-	for (size_t i = 0; i < skull.Vertices.size(); ++i, ++k)
+		for (UINT i = 1; i < file.Header().LodCount; ++i)
+		{
+			const MeshFileLod& lod = file.Lods()[i];
+			atlas.AddIndices(lodName(name, i), mesh, file.Indices() + lod.StartIndex, lod.IndexCount);
+		}
+	};
+	addLods("skull", skullMesh, meshes.Skull);
+	addLods("car", carMesh, meshes.Car);
+
+	// Quantize the positions and normals of each generated mesh to its bounds,
+	// straight into staging memory; the baked models are copied as they are.  The
+	// copies are recorded with the rest of the startup uploads.
+	auto geo = atlas.Build(md3dDevice.Get(), *mStaging, "shapeGeo", sizeof(Vertex),
+		[](const GeometryGenerator::MeshView& mesh, const SubmeshGeometry& submesh, void* destination)
 	{
-		vertices[k].Pos = skull.Vertices[i].Position;
-		vertices[k].Normal = skull.Vertices[i].Normal;
-	}
-
-	for (size_t i = 0; i < car.Vertices.size(); ++i, ++k)
+		QuantizationBounds bounds = QuantizationBounds::FromCenterExtents(&submesh.Bounds.Center.x, &submesh.Bounds.Extents.x);
+		Vertex* vertices = static_cast<Vertex*>(destination);
+		for (size_t i = 0; i < mesh.VertexCount; ++i)
+			vertices[i] = VertexQuantize::Pack(&mesh.Vertices[i].Position.x, &mesh.Vertices[i].Normal.x, bounds);
+	});
+
+	std::wstring sizeText = L"***Skull vertex buffer: " +
+		std::to_wstring(meshes.Skull.Header().VertexCount*2*sizeof(XMFLOAT3)) + L" (float3 position and normal) -> " +
+		std::to_wstring(meshes.Skull.Header().VertexCount*sizeof(Vertex)) + L" bytes\n";
+	::OutputDebugString(sizeText.c_str());
+
+	auto buildLodChain = [&](const std::string& name, const MeshFile& file)
 	{
-		vertices[k].Pos = car.Vertices[i].Position;
-		vertices[k].Normal = car.Vertices[i].Normal;
-	}
-
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-	indices.insert(indices.end(), std::begin(backgroundGrid.GetIndices16()), std::end(backgroundGrid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
-	indices.insert(indices.end(), std::begin(skull.GetIndices16()), std::end(skull.GetIndices16()));
-	indices.insert(indices.end(), std::begin(car.GetIndices16()), std::end(car.GetIndices16()));
-
-    const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-    const UINT ibByteSize = (UINT)indices.size()  * sizeof(std::uint16_t);
-
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "shapeGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+		MeshLodChain& chain = mMeshLods[name];
+		chain.Levels.clear();
+		chain.Errors.clear();
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+		for (UINT i = 0; i < file.Header().LodCount; ++i)
+		{
+			std::string submeshName = lodName(name, i);
+			const SubmeshGeometry& submesh = geo->DrawArgs[submeshName];
+
+			MeshLodChain::Level level;
+			level.MeshId = GetMeshId(submeshName);
+			level.IndexCount = submesh.IndexCount;
+			level.StartIndexLocation = submesh.StartIndexLocation;
+			chain.Levels.push_back(level);
+			chain.Errors.push_back(file.Lods()[i].Error);
+		}
+	};
+	buildLodChain("skull", meshes.Skull);
+	buildLodChain("car", meshes.Car);
 
-	geo->DrawArgs["box"] = boxSubmesh;
-	geo->DrawArgs["backgroundGrid"] = backgroundGridSubmesh;
-	geo->DrawArgs["grid"] = gridSubmesh;
-	geo->DrawArgs["sphere"] = sphereSubmesh;
-	geo->DrawArgs["cylinder"] = cylinderSubmesh;
-	geo->DrawArgs["skull"] = skullSubmesh;
-	geo->DrawArgs["car"] = carSubmesh;
+	// Every submesh (levels of detail share the bounds of their mesh) is drawn with
+	// the dequantization of its own bounds.
+	for (auto& submesh : geo->DrawArgs)
+	{
+		QuantizationBounds bounds = QuantizationBounds::FromCenterExtents(
+			&submesh.second.Bounds.Center.x, &submesh.second.Bounds.Extents.x);
+		mRenderBackend.SetMeshConstantData(GetMeshId(submesh.first), &bounds);
+	}
 
+	mGeometryHandles[geo.get()] = mRenderBackend.AddGeometry(geo.get());
 	mGeometries[geo->Name] = std::move(geo);
+
+	// The meshes are in staging memory now.  The baked models are closed; the
+	// generated meshes stay in the mesh cache for later requests.
+	mShapeMeshes.reset();
 }
 
 void TetrisApp::BuildMaterials()
@@ -1441,15 +1858,43 @@ void TetrisApp::BuildPSOs()
 		mShaders["opaqueToonShadingPS"]->GetBufferSize()
 	};
 	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaqueToonShadingPsoDesc, IID_PPV_ARGS(&mPSOs["opaque_toonShading"])));
+
+	//
+	// Instanced variants of the PSOs above.
+	//
+
+	D3D12_SHADER_BYTECODE instancedVS =
+	{
+		reinterpret_cast<BYTE*>(mShaders["instancedVS"]->GetBufferPointer()),
+		mShaders["instancedVS"]->GetBufferSize()
+	};
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedPsoDesc = opaquePsoDesc;
+	instancedPsoDesc.VS = instancedVS;
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&instancedPsoDesc, IID_PPV_ARGS(&mPSOs["opaque_instanced"])));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedWireframePsoDesc = opaqueWireframePsoDesc;
+	instancedWireframePsoDesc.VS = instancedVS;
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&instancedWireframePsoDesc, IID_PPV_ARGS(&mPSOs["opaque_instanced_wireframe"])));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedToonShadingPsoDesc = opaqueToonShadingPsoDesc;
+	instancedToonShadingPsoDesc.VS = instancedVS;
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&instancedToonShadingPsoDesc, IID_PPV_ARGS(&mPSOs["opaque_instanced_toonShading"])));
+
+	for(auto& pso : mPSOs)
+		mPsoHandles[pso.first] = mRenderBackend.AddPipelineState(pso.second.Get());
 }
 
-void TetrisApp::BuildFrameResources()
+void TetrisApp::BuildFrameResources(UINT instanceCapacity)
 {
     for(int i = 0; i < gNumFrameResources; ++i)
     {
         mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            1, (UINT)mMaterials.size(), (UINT)mAllRitems.size()));
+            1, (UINT)mMaterials.size(), instanceCapacity));
     }
+
+	// The new pass buffers are empty.
+	mPassFramesDirty = gNumFrameResources;
 }
 
 void TetrisApp::BuildRenderItemsOnMap()
@@ -1467,9 +1912,10 @@ void TetrisApp::BuildRenderItemsOnMap()
 	}
 
 	mRitemLayer[(int)RenderLayer::Opaque].clear();
-	// All the render items are opaque.
+	mRitemLayer[(int)RenderLayer::Instanced].clear();
+	// All the map cells are drawn instanced.
 	for(auto& e : mAllRitems)
-		mRitemLayer[(int)RenderLayer::Opaque].push_back(e.get());
+		mRitemLayer[(int)RenderLayer::Instanced].push_back(e.get());
 }
 
 void TetrisApp::BuildbackgrounGrid()
@@ -1480,13 +1926,10 @@ void TetrisApp::BuildbackgrounGrid()
 	XMStoreFloat4x4(&backgroundGridRitem->World, world);
 	XMStoreFloat4x4(&backgroundGridRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 	backgroundGridRitem->ObjCBIndex = mObjCBIndex++;
-	backgroundGridRitem->Geo = mGeometries["shapeGeo"].get();
-	backgroundGridRitem->Mat = mMaterials["Green"].get();
+	backgroundGridRitem->Mat = mMaterialTable[mGridMaterial];
 	backgroundGridRitem->Mat->NumFramesDirty = gNumFrameResources;
 	backgroundGridRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
-	backgroundGridRitem->IndexCount = backgroundGridRitem->Geo->DrawArgs["backgroundGrid"].IndexCount;
-	backgroundGridRitem->StartIndexLocation = backgroundGridRitem->Geo->DrawArgs["backgroundGrid"].StartIndexLocation;
-	backgroundGridRitem->BaseVertexLocation = backgroundGridRitem->Geo->DrawArgs["backgroundGrid"].BaseVertexLocation;
+	SetRenderItemMesh(*backgroundGridRitem, mGridMesh);
 	mAllRitems.push_back(std::move(backgroundGridRitem));
 
 	mRitemLayer[(int)RenderLayer::Opaque].push_back(mAllRitems.back().get());
@@ -1508,93 +1951,245 @@ void TetrisApp::AddSkullRItem(int x, int y) {
 	XMStoreFloat4x4(&SkullRitem->World, world);
 	XMStoreFloat4x4(&SkullRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 	SkullRitem->ObjCBIndex = mObjCBIndex++;
-	SkullRitem->Geo = mGeometries["shapeGeo"].get();
-	SkullRitem->Mat = mMaterials["White"].get();
+	SkullRitem->Mat = mMaterialTable[mSkullMaterial];
 	SkullRitem->Mat->NumFramesDirty = gNumFrameResources;
 	SkullRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	SkullRitem->IndexCount = SkullRitem->Geo->DrawArgs["skull"].IndexCount;
-	SkullRitem->StartIndexLocation = SkullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
-	SkullRitem->BaseVertexLocation = SkullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+	SetRenderItemMesh(*SkullRitem, mSkullMesh);
 	mAllRitems.push_back(std::move(SkullRitem));
 
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(mAllRitems.back().get());
+	mRitemLayer[(int)RenderLayer::Instanced].push_back(mAllRitems.back().get());
 }
 
 void TetrisApp::AddRenderItem(unsigned int type, int x, int y)
 {
-	XMMATRIX world = XMMatrixScaling(1.0f, 1.0f, 1.0f)*XMMatrixTranslation( (float)x - WIDTH/2, HEIGHT/2 - (float)y, 0.0f);
+	assert(type < _countof(mCellMaterials));
 
-	std::string blockType;
-	switch (type) {
-		case 0:
-			blockType = "LightBlue";
-			break;
-		case 1:
-			blockType = "Purple";
-			break;
-		case 2:
-			blockType = "DeepBlue";
-			break;
-		case 3:
-			blockType = "Orange";
-			break;
-		case 4:
-			blockType = "Yellow";
-			break;
-		case 5:
-			blockType = "Green";
-			break;
-		case 6:
-			blockType = "Red";
-			break;
-		case 7:
-			blockType = "White";
-			break;
-	}
+	XMMATRIX world = XMMatrixScaling(1.0f, 1.0f, 1.0f)*XMMatrixTranslation( (float)x - WIDTH/2, HEIGHT/2 - (float)y, 0.0f);
 
 	auto newBoxRitem = std::make_unique<RenderItem>();
 	XMStoreFloat4x4(&newBoxRitem->World, world);
 	XMStoreFloat4x4(&newBoxRitem->TexTransform, XMMatrixScaling(1.0f, 1.0f, 1.0f));
 	newBoxRitem->ObjCBIndex = mObjCBIndex++;
-	newBoxRitem->Geo = mGeometries["shapeGeo"].get();
-	newBoxRitem->Mat = mMaterials[blockType].get();
+	newBoxRitem->Mat = mMaterialTable[mCellMaterials[type]];
 	newBoxRitem->Mat->NumFramesDirty = gNumFrameResources;
 	newBoxRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	newBoxRitem->IndexCount = newBoxRitem->Geo->DrawArgs["box"].IndexCount;
-	newBoxRitem->StartIndexLocation = newBoxRitem->Geo->DrawArgs["box"].StartIndexLocation;
-	newBoxRitem->BaseVertexLocation = newBoxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	SetRenderItemMesh(*newBoxRitem, mBoxMesh);
 	mAllRitems.push_back(std::move(newBoxRitem));
 
-	mRitemLayer[(int)RenderLayer::Opaque].push_back(mAllRitems.back().get());
+	mRitemLayer[(int)RenderLayer::Instanced].push_back(mAllRitems.back().get());
 }
 
-void TetrisApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+UINT TetrisApp::GetMeshId(const std::string& submeshName)
 {
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-	UINT matCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
- 
-	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
-	auto matCB = mCurrFrameResource->MaterialCB->Resource();
+	auto it = mMeshIds.find(submeshName);
+	if (it != mMeshIds.end())
+		return it->second;
 
-    // For each render item...
-    for(size_t i = 0; i < ritems.size(); ++i)
-    {
-        auto ri = ritems[i];
+	UINT id = (UINT)mMeshIds.size();
+	mMeshIds[submeshName] = id;
+	return id;
+}
 
-        cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-        cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
-        cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+void TetrisApp::BuildHandleTables()
+{
+	mMaterialTable.assign(mMaterials.size(), nullptr);
+	for (auto& e : mMaterials)
+	{
+		Material* mat = e.second.get();
+		if (mat->MatCBIndex < 0 || mat->MatCBIndex >= (int)mMaterialTable.size())
+			throw std::runtime_error("Material " + mat->Name + " has no valid MatCBIndex.");
+		mMaterialTable[mat->MatCBIndex] = mat;
+	}
 
-        // Offset to the CBV in the descriptor heap for this object and for this frame resource.
-        UINT cbvIndex = mCurrFrameResourceIndex*(UINT)mRitemLayer[(int)RenderLayer::Opaque].size() + ri->ObjCBIndex;
-        auto cbvHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(mCbvHeap->GetGPUDescriptorHandleForHeapStart());
-        cbvHandle.Offset(cbvIndex, mCbvSrvUavDescriptorSize);
+	for (auto& e : mGeometries)
+	{
+		MeshGeometry* geo = e.second.get();
+		for (auto& submesh : geo->DrawArgs)
+		{
+			UINT id = GetMeshId(submesh.first);
+			if (id >= mMeshTable.size())
+				mMeshTable.resize(id + 1);
+
+			MeshEntry& entry = mMeshTable[id];
+			entry.Geo = geo;
+			entry.MeshId = id;
+			entry.IndexCount = submesh.second.IndexCount;
+			entry.StartIndexLocation = submesh.second.StartIndexLocation;
+			entry.BaseVertexLocation = submesh.second.BaseVertexLocation;
+			entry.Bounds = submesh.second.Bounds;
+
+			auto lods = mMeshLods.find(submesh.first);
+			entry.Lods = lods != mMeshLods.end() ? &lods->second : nullptr;
+		}
+	}
 
-		D3D12_GPU_VIRTUAL_ADDRESS matCBAddress = matCB->GetGPUVirtualAddress() + ri->Mat->MatCBIndex*matCBByteSize;
+	// Material of each cell type of the map.
+	static const char* const cellMaterialNames[] =
+	{
+		"LightBlue", "Purple", "DeepBlue", "Orange", "Yellow", "Green", "Red", "White"
+	};
+	static_assert(_countof(cellMaterialNames) == _countof(mCellMaterials), "One material per cell type.");
 
-        cmdList->SetGraphicsRootDescriptorTable(0, cbvHandle);
-		cmdList->SetGraphicsRootConstantBufferView(1, matCBAddress);
+	for (size_t i = 0; i < _countof(cellMaterialNames); ++i)
+		mCellMaterials[i] = FindMaterial(cellMaterialNames[i]);
+	mGridMaterial = FindMaterial("Green");
+	mSkullMaterial = FindMaterial("White");
 
-        cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
-    }
+	mBoxMesh = FindMesh("box");
+	mGridMesh = FindMesh("backgroundGrid");
+	mSkullMesh = FindMesh("skull");
+}
+
+MaterialHandle TetrisApp::FindMaterial(const std::string& name)const
+{
+	auto it = mMaterials.find(name);
+	if (it == mMaterials.end())
+		throw std::runtime_error("Material " + name + " not found.");
+	return (MaterialHandle)it->second->MatCBIndex;
+}
+
+MeshHandle TetrisApp::FindMesh(const std::string& submeshName)const
+{
+	auto it = mMeshIds.find(submeshName);
+	if (it == mMeshIds.end() || it->second >= mMeshTable.size() || mMeshTable[it->second].Geo == nullptr)
+		throw std::runtime_error("Submesh " + submeshName + " not found.");
+	return it->second;
+}
+
+void TetrisApp::SetRenderItemMesh(RenderItem& ri, MeshHandle mesh)const
+{
+	const MeshEntry& entry = mMeshTable[mesh];
+	ri.Geo = entry.Geo;
+	ri.MeshId = entry.MeshId;
+	ri.IndexCount = entry.IndexCount;
+	ri.StartIndexLocation = entry.StartIndexLocation;
+	ri.BaseVertexLocation = entry.BaseVertexLocation;
+	ri.Bounds = entry.Bounds;
+	ri.Lods = entry.Lods;
+}
+
+void TetrisApp::QueueRenderItems(const std::vector<RenderItem*>& ritems, RenderLayer layer, UINT pso)
+{
+	for(size_t i = 0; i < ritems.size(); ++i)
+	{
+		auto ri = ritems[i];
+
+		DrawPacket packet;
+		packet.PipelineState = pso;
+		packet.Geometry = mGeometryHandles[ri->Geo];
+		packet.Topology = ri->PrimitiveType;
+		packet.Material = ri->Mat->MatCBIndex;
+		packet.Layer = (UINT)layer;
+		packet.Mesh = ri->MeshId;
+		packet.Depth = DrawKey::QuantizeDepth(ri->ViewDepth, mMainPassCB.NearZ, mMainPassCB.FarZ);
+		packet.ObjectConstants = ri->ObjectCBSlot;
+		packet.IndexCount = ri->IndexCount;
+		packet.StartIndexLocation = ri->StartIndexLocation;
+		packet.BaseVertexLocation = ri->BaseVertexLocation;
+
+		mRenderQueue.Submit(packet);
+	}
+}
+
+std::string TetrisApp::PsoSuffix()const
+{
+	return mIsWireframe ? "_wireframe" : (toonShading ? "_toonShading" : "");
+}
+
+void TetrisApp::QueueInstanceBatches(const std::vector<RenderItem*>& ritems, RenderLayer layer)
+{
+	const auto& instances = mInstanceStream.Instances();
+
+	// Instances are drawn rotated with the scene, as the opaque items are, so their
+	// depth is taken through the scene transform and the view together.
+	XMFLOAT4X4 depthView = mView;
+	if (rotate)
+		XMStoreFloat4x4(&depthView, XMMatrixMultiply(XMLoadFloat4x4(&mSceneTransform), XMLoadFloat4x4(&mView)));
+
+	// One draw per pipeline state and mesh; every instance of the batch shares the
+	// draw arguments of the render item that was added first.
+	for (auto& batch : mInstanceStream.Batches())
+	{
+		auto ri = ritems[batch.FirstSource];
+
+		// A batch is sorted by its nearest instance.  World holds the matrix columns,
+		// so the translation is the last element of each.
+		float viewDepth = mMainPassCB.FarZ;
+		for (UINT i = batch.StartInstance; i < batch.StartInstance + batch.InstanceCount; ++i)
+		{
+			const InstanceData& inst = instances[i];
+			float z = inst.World[0][3]*depthView._13 + inst.World[1][3]*depthView._23 + inst.World[2][3]*depthView._33 + depthView._43;
+			viewDepth = (std::min)(viewDepth, z);
+		}
+
+		DrawPacket packet;
+		packet.PipelineState = batch.PipelineState;
+		packet.Geometry = mGeometryHandles[ri->Geo];
+		packet.Topology = ri->PrimitiveType;
+		packet.Layer = (UINT)layer;
+		packet.Mesh = batch.Mesh;
+		packet.Depth = DrawKey::QuantizeDepth(viewDepth, mMainPassCB.NearZ, mMainPassCB.FarZ);
+		packet.FirstInstance = batch.StartInstance;
+		packet.IndexCount = ri->IndexCount;
+		packet.InstanceCount = batch.InstanceCount;
+		packet.StartIndexLocation = ri->StartIndexLocation;
+		packet.BaseVertexLocation = ri->BaseVertexLocation;
+
+		mRenderQueue.Submit(packet);
+	}
+}
+
+std::wstring TetrisApp::FrameStatsText()const
+{
+	size_t itemCount = 0, visibleCount = 0;
+	for (int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+	{
+		itemCount += mRitemLayer[layer].size();
+		visibleCount += mVisibleRitems[layer].size();
+	}
+
+	// Upload traffic of the last frame.
+	UINT uploadedElements = 0;
+	UINT64 uploadedBytes = 0;
+	if (mCurrFrameResource != nullptr)
+	{
+		uploadedElements = mCurrFrameResource->UploadedElements() + mConstantRing->ElementsWritten();
+		uploadedBytes = mCurrFrameResource->UploadedBytes() + mConstantRing->BytesWritten();
+	}
+
+	return L"   visible: " + std::to_wstring(visibleCount) + L"/" + std::to_wstring(itemCount) +
+		L"   draws: " + std::to_wstring(mCommandStream.DrawCount()) +
+		L"   binds: " + std::to_wstring(mCommandStream.BindCount()) +
+		L" (" + std::to_wstring(mCommandStream.ElidedBindCount()) + L" elided)" +
+		L"   upload: " + std::to_wstring(uploadedBytes) + L" B (" + std::to_wstring(uploadedElements) + L" elements)" +
+		L"   constant ring: " + std::to_wstring(mConstantRing->UsedBytes()/1024) + L" KB" +
+		L"   gpu wait: " + std::to_wstring(mFenceService->FrameStats().BlockedMs) + L" ms" +
+		L"   resident: " + std::to_wstring(BuildMemoryReport().Total()/(1024*1024)) + L" MB";
+}
+
+MemoryReport TetrisApp::BuildMemoryReport()const
+{
+	MemoryReport report;
+
+	for (const auto& geo : mGeometries)
+	{
+		const MeshGeometry& g = *geo.second;
+		report.Add("geometry", d3dUtil::CommittedBytes(g.VertexBufferGPU.Get()) + d3dUtil::CommittedBytes(g.IndexBufferGPU.Get()) +
+			d3dUtil::CommittedBytes(g.VertexBufferUploader.Get()) + d3dUtil::CommittedBytes(g.IndexBufferUploader.Get()));
+
+		UINT64 cpuBytes = 0;
+		if (g.VertexBufferCPU != nullptr)
+			cpuBytes += g.VertexBufferCPU->GetBufferSize();
+		if (g.IndexBufferCPU != nullptr)
+			cpuBytes += g.IndexBufferCPU->GetBufferSize();
+		report.Add("geometry CPU copies", cpuBytes);
+	}
+
+	report.Add("staging heap", mStaging->ResidentBytes());
+	report.Add("constant ring", d3dUtil::CommittedBytes(mConstantRing->Resource()));
+
+	for (const auto& frameResource : mFrameResources)
+		report.Add("frame resources", frameResource->ResidentBytes());
+
+	return report;
 }
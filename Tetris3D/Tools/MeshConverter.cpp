@@ -0,0 +1,63 @@
+//***************************************************************************************
+// MeshConverter.cpp
+//
+// Offline baker from the VertexList/TriangleList text format to the binary .mesh
+// format (see Common/MeshFile.h and Common/MeshBake.h).  The app bakes a missing or
+// stale .mesh file itself on load; converting offline only saves that first load.
+// The default settings are the ones the app uses.
+//
+// Build from the Tetris3D directory with
+//   cl /EHsc /O2 /std:c++17 Tools\MeshConverter.cpp Common\MeshBake.cpp Common\MeshFile.cpp
+//      Common\MappedFile.cpp Common\MeshTextParser.cpp Common\MeshSimplify.cpp
+//      Common\MeshOptimize.cpp Common\VertexQuantize.cpp Common\IndexFormat.cpp
+// and run
+//   MeshConverter Models\skull.txt Models\skull.mesh
+// Without an output path the input path with a .mesh extension is used.
+//***************************************************************************************
+
+#include "../Common/MeshBake.h"
+#include "../Common/MeshOptimize.h"
+#include <cstdio>
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2 || argc > 3)
+	{
+		std::fprintf(stderr, "usage: MeshConverter input.txt [output.mesh]\n");
+		return 1;
+	}
+
+	std::string input = argv[1];
+	std::string output = argc > 2 ? argv[2] : input.substr(0, input.find_last_of('.')) + ".mesh";
+
+	// Always rebuild: remove the old output so Load cannot reuse it.
+	std::remove(output.c_str());
+
+	MeshFile mesh;
+	std::string error;
+	if(!MeshBake::Load(input, output, MeshBakeSettings(), mesh, error))
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	// Reopen the result to validate what was written.
+	MeshFile check;
+	if(!check.Open(output, error))
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	const MeshFileHeader& header = check.Header();
+	std::printf("%s: %u vertices, %u levels of detail, %llu bytes\n", output.c_str(),
+		header.VertexCount, header.LodCount, (unsigned long long)header.FileSize);
+
+	for(std::uint32_t i = 0; i < header.LodCount; ++i)
+	{
+		const MeshFileLod& lod = check.Lods()[i];
+		std::printf("  lod%u: %u triangles, error %g, ACMR %.3f\n", i, lod.IndexCount/3, lod.Error,
+			MeshOptimize::ComputeAcmr(check.Indices() + lod.StartIndex, lod.IndexCount, header.VertexCount));
+	}
+	return 0;
+}